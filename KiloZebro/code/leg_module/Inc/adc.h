@@ -34,6 +34,14 @@ uint8_t adc_current_control_get_kp(void);
 uint8_t adc_current_control_get_ki(void);
 void adc_current_control_set_ki(uint8_t value);
 uint16_t adc_get_value(int32_t index);
+void adc_block_mode_start(void);
+void adc_block_mode_stop(void);
+uint8_t adc_block_mode_active(void);
+void adc_dma_block_handler(void);
+void adc_block_set_phase(uint8_t phase);
+const uint16_t *adc_block_next(uint8_t *phase);
+const uint16_t *adc_block_filling(uint16_t *sequences);
+void adc_block_done(const uint16_t *block);
 
 /* Temperature sensor calibration value address */
 #define TEMP110_CAL_ADDR (557<<4) // calculated using TEMP30 (printed on screen: 213) and an average slope of 4.3 and rounded. (4.3*80+213 = 557)
@@ -67,6 +75,7 @@ uint16_t adc_get_value(int32_t index);
 #define ADC_MOTOR_CURRENT_BANK GPIOC
 
 #define ADC_NUM_OF_CHANNELS 7
+#define ADC_BLOCK_SEQUENCES 16 // sequences in each half of the double buffer of the block mode, a half every 4.8 ms (a sequence every 0.3 ms)
 
 #define ADC_HAL_1_CH 10
 #define ADC_HAL_2_CH 11
@@ -43,6 +43,13 @@
 
 #define DEBUG_VREGS
 
+/* Define the line bellow to let the DMA of the ADC fill a double buffer
+ * while calibrating, so the peak detector sees every sample of the hall
+ * sensors exactly once (see adc.c). Without it the main loop takes the last
+ * sample, whatever the speed of the loop.
+ */
+#define ADC_HALL_BLOCKS
+
 /* Define the line bellow to disable the following:
  *  - The watchdog timer
  *  - The emergency break when no clock ticks have been received over
@@ -53,6 +53,18 @@
 
 #define ARRAY_SIZE 256
 
+/* Broadcast schedule frame (VREGS_BROADCAST_*). The KiloZebro legs are on the even
+ * positions, the leg at position p takes slice p / 2. */
+#define MOTION_BROADCAST_SLICES 6
+#define MOTION_BROADCAST_SLICE_SIZE 4
+
+/* Values of VREGS_MOTION_UPDATE (and VREGS_BROADCAST_UPDATE). NOW starts the
+ * command right away and throws the queue away, QUEUE puts it at the end of the
+ * queue: it starts when the command before it reaches its time. */
+#define MOTION_UPDATE_NOW 1
+#define MOTION_UPDATE_QUEUE 2
+#define MOTION_QUEUE_SIZE 8
+
 #include "stdint.h"
 
 struct motion_state{
@@ -66,8 +78,10 @@ struct motion_state{
 };
 
 int32_t motion_new_zebrobus_data(uint32_t address, uint8_t data);
+int32_t motion_new_broadcast_data(uint32_t address, uint8_t data);
 int32_t motion_write_state_to_vregs(struct motion_state motion_state);
 int32_t motion_validate_state(struct motion_state motion_state);
+void motion_queue_flush(void);
 void set_current_setpoint (int32_t value);
 int32_t get_current_setpoint (void);
 uint8_t get_state_mode (void);
@@ -20,7 +20,16 @@
 #define PEAK_NUM_OF_SENSORS 3
 #define PEAK_HISTORY_LAG 64 //because we want to bitshift to perform division, this number should be 2, 4, 8 and so on. max 255
 
+/* The last PEAK_HISTORY_LAG samples of a signal, as a circular buffer with their sum */
+struct peak_history {
+	uint16_t samples[PEAK_HISTORY_LAG];
+	uint32_t sum;
+	uint8_t newest; /* index of the newest sample */
+};
+
 uint8_t peak_process_adc_values_sensor(uint8_t fill_up_arrays);
+void peak_process_block(const uint16_t *block, uint16_t sequences,
+		uint8_t fill_up_arrays);
 uint8_t peak_get_adc_channel_index(uint8_t sensor);
 void move_over_array_elements (uint16_t *array, uint8_t array_size);
 uint16_t mean (uint16_t *array, uint8_t array_size);
@@ -41,6 +41,8 @@ int32_t time_calculate_delta(int32_t time_a, int32_t time_b);
 void start_timing_measurement(void);
 int8_t stop_and_return_timing_measurement(int32_t delta);
 void reset_timing_measurement(void);
+void time_latch(void);
+int32_t time_new_zebrobus_data(uint32_t address, uint8_t data);
 
 //#define TIME_CLOCK_PRESCALER 3661
 #define TIME_CLOCK_PRESCALER 749
@@ -49,6 +51,11 @@ void reset_timing_measurement(void);
 #define TIME_EMERGENCY_STOP_PRIORITY 0
 #define TIME_ROLEOVER_MS 256000 // 256 * 1000
 #define TIME_MAX_SECONDS UINT8_MAX
+/* A slew up to TIME_SLEW_STEP_TICKS (10 ms) is spread over the next seconds, at most
+ * TIME_SLEW_MAX_TICKS (5 ms) per second; a larger one steps the clock at once. */
+#define TIME_SLEW_MAX_TICKS 320
+#define TIME_SLEW_STEP_TICKS 640
+#define TIME_TRIM_MAX 10240 /* 1/16 ticks per second, 1 % */
 
 #define TIME_IWDG_REFRESH      (uint32_t)(0x0000AAAA)
 #define TIME_IWDG_WRITE_ACCESS (uint32_t)(0x00005555)
@@ -23,7 +23,24 @@
 #define UART1_RX_PIN GPIO_PIN_10
 #define UART1_RX_BANK GPIOA
 
-#define UART1_BAUD_RATE_DIVIDER 0x18
+#define UART1_BAUD_RATE_DIVIDER 0x18 /* 2 Mbaud at 48 MHz */
+#define UART1_WRITEOUT_TIME_TICKS 12 /* TIM17 ticks (48 MHz) per unit of VREGS_WRITEOUT_TIME, 0.25 us */
+
+/* baud rate presets of VREGS_TELEMETRY_BAUD, and their dividers at 48 MHz */
+#define UART1_BAUD_2M 0
+#define UART1_BAUD_1M 1
+#define UART1_BAUD_3M 2
+#define UART1_BAUD_DIVIDER_2M UART1_BAUD_RATE_DIVIDER
+#define UART1_BAUD_DIVIDER_1M 0x30
+#define UART1_BAUD_DIVIDER_3M 0x10
+
+/* compact telemetry frames, see vregs.h */
+#define UART1_TELEMETRY_OFF 0
+#define UART1_TELEMETRY_COMPACT 1
+#define UART1_TELEMETRY_SYNC_0 0xA5
+#define UART1_TELEMETRY_SYNC_1 0x5A
+#define UART1_TELEMETRY_HEADER_SIZE 4 /* sync 0, sync 1, sequence number, number of registers (0 for all 256) */
+#define UART1_TELEMETRY_PERIOD_TICKS 4800 /* TIM17 ticks (48 MHz) per unit of VREGS_TELEMETRY_PERIOD, 0.1 ms */
 
 
 int32_t uart1_init(void);
@@ -32,6 +49,7 @@ int32_t uart1_init_dma(void);
 int32_t uart1_trigger_dma_once(void);
 int32_t uart1_wait_until_done(void);
 int32_t uart1_pins_init(void);
+void uart1_new_zebrobus_data(uint8_t address, uint8_t data);
 
 
 #endif /* __UART1_H__ */
@@ -54,13 +54,18 @@
 #define VREGS_ZEBROBUS_ADDRESS 5
 #define VREGS_LEG_SIDE 6
 #define VREGS_LEG_ADDRESS 7
+#define VREGS_ZEBROBUS_SPEED 8 // Bus timing preset: active (low nibble) and stored for the next boot (high nibble), write to store
+#define VREGS_ZEBROBUS_REBOOT 9 // Write ZEBROBUS_REBOOT_KEY to restart the leg (and take the stored bus timing preset)
 
 #define VREGS_QUICK_STATUS 10
 #define VREGS_SYNC_COUNTER 11
 #define VREGS_CLOCK_A 12
 #define VREGS_CLOCK_B 13
+#define VREGS_ZEBROBUS_ERRORS 14 // Bus errors and overruns seen by the leg (wraps at 255)
 #define VREGS_LOOP_COUNTER 16
 #define VREGS_LOOP_TIME 17
+#define VREGS_WRITEOUT_TIME 18 // Time of the last copy of the vregs to the UART buffer (vregs_writeout), in 0.25 us
+#define VREGS_WRITEOUT_COUNT 19 // Registers copied in the last vregs_writeout (saturates at 255)
 
 #define VREGS_ERROR_COUNTER 20
 #define VREGS_LAST_ERROR 21
@@ -79,6 +84,8 @@
 #define VREGS_MOTION_NEW_DATA_FLAG 35
 #define VREGS_MOTION_CRC 36
 #define VREGS_MOTION_UPDATE 37
+#define VREGS_MOTION_QUEUE_DEPTH 38 // Amount of queued motion commands (read only)
+#define VREGS_MOTION_QUEUE_FLUSH 39 // Write 1 to throw the queued motion commands away
 
 #define VREGS_MOTOR_VOLTAGE 40
 #define VREGS_MOTOR_CURRENT 41
@@ -167,6 +174,8 @@
 #define VREGS_PEAK_MAX_AVG_DELTA_B 140 // [Debug] maximum value of average between two successive hall-sensor samples.
 #define VREGS_PEAK_AVG_DELTA 141 // [Debug] maximum value between two successive hall-sensor samples.
 #define VREGS_PEAK_THRESHOLD 142
+#define VREGS_PEAK_BLOCKS 143 // Halves of the ADC double buffer processed by the peak detector in the block mode (wraps at 255)
+#define VREGS_PEAK_BLOCK_OVERRUNS 144 // Halves that were overwritten before the peak detector got to them (wraps at 255)
 //#define VREGS_PEAK_1_HISTORY_1 141
 //#define VREGS_PEAK_1_HISTORY_2 142
 //#define VREGS_PEAK_1_HISTORY_3 143
@@ -195,6 +204,38 @@
 #define VREGS_POSITION_DELTA_T_B 162
 #endif
 
+/* Broadcast schedule frame: one write to ADDRESS_BROADCAST_ADDRESS carries the
+ * motion commands of all legs, every leg takes its own slice (see motion.c) */
+#define VREGS_BROADCAST_MODE 170
+#define VREGS_BROADCAST_SLICE_0 171 /* 4 bytes per leg: position a, position b, time a, time b */
+#define VREGS_BROADCAST_UPDATE 195
+
+/* Two-way clock synchronisation (see time.c). A write to CLOCK_LATCH (of any
+ * sequence number) latches the clock when the byte arrives; the latched time
+ * and the sequence number can then be read back. SLEW and TRIM are signed,
+ * high byte first, and take effect when their second byte is written. */
+#define VREGS_CLOCK_LATCH 200 /* sequence number of the exchange */
+#define VREGS_CLOCK_LATCH_SECONDS 201
+#define VREGS_CLOCK_LATCH_COUNTER_A 202 /* 64000 ticks per second */
+#define VREGS_CLOCK_LATCH_COUNTER_B 203
+#define VREGS_CLOCK_LATCH_SEQUENCE 204 /* sequence number of the latched time */
+#define VREGS_CLOCK_SLEW_A 205 /* ticks the clock is ahead of the host */
+#define VREGS_CLOCK_SLEW_B 206
+#define VREGS_CLOCK_TRIM_A 207 /* 1/16 ticks every second is made longer */
+#define VREGS_CLOCK_TRIM_B 208
+#define VREGS_CLOCK_RESIDUAL 209 /* ticks of the slew that are not applied yet (signed, saturated) */
+
+/* Telemetry over UART1 (see uart1.c). In the compact mode only the registers
+ * selected in the mask are sent, in frames of: UART1_TELEMETRY_SYNC_0,
+ * UART1_TELEMETRY_SYNC_1, sequence number, number of registers, the registers
+ * in increasing order, checksum (sum of the sequence number up to the last
+ * register). pootDebug.py --telemetry decodes them. */
+#define VREGS_TELEMETRY_MODE 210 /* 0: the whole register file (default), 1: compact frames */
+#define VREGS_TELEMETRY_BAUD 211 /* 0: 2 Mbaud (default), 1: 1 Mbaud, 2: 3 Mbaud, taken after the frame that is being sent */
+#define VREGS_TELEMETRY_PERIOD 212 /* time between two compact frames in 0.1 ms, 0: as fast as the loop and the UART allow */
+#define VREGS_TELEMETRY_MASK_FIRST 213 /* 32 bytes, bit i of byte k selects register 8k+i */
+#define VREGS_TELEMETRY_MASK_LAST 244
+
 /* END FIELD NAME DEFINITIONS */
 /* Important: do not remove the line above, it is used by the debug tools */
 
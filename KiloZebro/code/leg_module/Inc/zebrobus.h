@@ -31,6 +31,22 @@
 #define ZEBROBUS_SIZE_OF_QUEUE 50
 #define ZEBROBUS_QUEUE_FULL 1
 
+/* Bus timing presets (VREGS_ZEBROBUS_SPEED). I2C1 runs from the 8 MHz HSI,
+ * the values are those of the reference manual for that clock. The standard
+ * preset keeps the value the legs always had. */
+#define ZEBROBUS_SPEED_STANDARD 0	/* 100 kHz */
+#define ZEBROBUS_SPEED_FAST 1		/* 400 kHz */
+#define ZEBROBUS_SPEED_FAST_PLUS 2	/* 1 MHz, also switches the pins to Fm+ drive */
+#define ZEBROBUS_TIMINGR_STANDARD 0x0070D8FF
+#define ZEBROBUS_TIMINGR_FAST 0x00310309
+#define ZEBROBUS_TIMINGR_FAST_PLUS 0x00100306
+
+/* The preset is kept in the last flash page, which the linker script leaves
+ * out of the program. A half word: magic in the high byte, preset in the low */
+#define ZEBROBUS_SETTINGS_PAGE 0x0800FC00
+#define ZEBROBUS_SETTINGS_MAGIC 0x5A
+#define ZEBROBUS_REBOOT_KEY 0xB0
+
 struct zebrobus_write_request{
      uint32_t address;
 	 uint8_t data;
@@ -40,5 +56,6 @@ int32_t zebrobus_slave_init();
 int32_t zebrobus_put_write_request(uint32_t address, uint8_t data);
 struct zebrobus_write_request zebrobus_get_write_request();
 int32_t zebrobus_process_write_requests();
+int32_t zebrobus_get_speed();
 
 #endif /* __ZEBROBUS_H__ */
@@ -28,6 +28,18 @@
 #include "motion.h"
 
 volatile static uint16_t adc_data_dump[ADC_NUM_OF_CHANNELS];
+#ifdef ADC_HALL_BLOCKS
+/* The double buffer of the block mode: the DMA fills one half while the other half is processed */
+volatile static uint16_t adc_block_buffer[2 * ADC_BLOCK_SEQUENCES][ADC_NUM_OF_CHANNELS];
+volatile static uint8_t adc_block_mode = 0;
+/* the halves that are full and not processed yet: bit 0 the first half, bit 1 the second */
+volatile static uint8_t adc_block_ready = 0;
+/* the phase of the calibration the main loop is in (adc_block_set_phase), and the phase each half was completed in */
+volatile static uint8_t adc_block_phase = 0;
+volatile static uint8_t adc_block_phases[2];
+volatile static uint8_t adc_blocks = 0;
+volatile static uint8_t adc_block_overruns = 0;
+#endif
 static uint8_t kp = 28, ki = 150;
 
 /**
@@ -140,6 +152,32 @@ int32_t adc_init() {
 	return 0;
 }
 
+#ifdef ADC_HALL_BLOCKS
+/**
+ * In the block mode the DMA does not stop after a sequence, so the sequence
+ * it just finished is copied to adc_data_dump. The current control and
+ * adc_get_value keep working on adc_data_dump as before.
+ */
+static void adc_copy_last_sequence(void) {
+	uint16_t remaining;
+	uint16_t done;
+	uint8_t i;
+
+	/* wait for the DMA to move the last conversion of the sequence */
+	do {
+		remaining = DMA1_Channel1->CNDTR;
+	} while ((remaining % ADC_NUM_OF_CHANNELS) != 0);
+	/* sequences done in this round of the buffer, 0 right after it wrapped */
+	done = (2 * ADC_BLOCK_SEQUENCES) - (remaining / ADC_NUM_OF_CHANNELS);
+	if (done == 0) {
+		done = 2 * ADC_BLOCK_SEQUENCES;
+	}
+	for (i = 0; i < ADC_NUM_OF_CHANNELS; i++) {
+		adc_data_dump[i] = adc_block_buffer[done - 1][i];
+	}
+}
+#endif
+
 void ADC1_IRQHandler(void) {
 	interrupts_disable();
 	if (ADC1->ISR & ADC_ISR_EOC) {
@@ -147,10 +185,17 @@ void ADC1_IRQHandler(void) {
 	}
 	if (ADC1->ISR & ADC_ISR_EOS) {
 		ADC1->ISR |= ADC_ISR_EOS;
-		/* wait for the DMA handler to finish, so we are using the latest data */
-		while (!(DMA1->ISR & DMA_ISR_TCIF1))
-			;
-		DMA1->IFCR |= DMA_IFCR_CTCIF1;
+#ifdef ADC_HALL_BLOCKS
+		if (adc_block_mode == 1) {
+			adc_copy_last_sequence();
+		} else
+#endif
+		{
+			/* wait for the DMA handler to finish, so we are using the latest data */
+			while (!(DMA1->ISR & DMA_ISR_TCIF1))
+				;
+			DMA1->IFCR |= DMA_IFCR_CTCIF1;
+		}
 		/* measured current is 10 bits left aligned. */
 		adc_control_motor_current(get_current_setpoint(),
 				(adc_data_dump[ADC_MOTOR_CURRENT_INDEX]));
@@ -160,6 +205,155 @@ void ADC1_IRQHandler(void) {
 	interrupts_enable();
 }
 
+/**
+ * Start the block mode: the DMA fills a double buffer of 2 * ADC_BLOCK_SEQUENCES
+ * sequences of all channels, and interrupts at every half (half transfer) and
+ * at the end (transfer complete). The interrupt only marks the half that is
+ * full; the main loop hands it to the peak detector (adc_block_next), so every
+ * sample of the hall sensors is processed exactly once, at the rate of the ADC
+ * and not of the main loop, as long as the loop takes a half within 4.8 ms.
+ * Call it with the ADC stopped, the DMA channel disabled and all channels
+ * selected. Without ADC_HALL_BLOCKS it sets up a single sequence as before.
+ */
+void adc_block_mode_start(void) {
+#ifdef ADC_HALL_BLOCKS
+	DMA1_Channel1->CMAR = (uint32_t) adc_block_buffer;
+	DMA1_Channel1->CNDTR = 2 * ADC_BLOCK_SEQUENCES * ADC_NUM_OF_CHANNELS;
+	DMA1->IFCR |= DMA_IFCR_CGIF1;
+	DMA1_Channel1->CCR |= DMA_CCR_HTIE | DMA_CCR_TCIE;
+	/* the interrupt only marks a half, so it is short enough for the I2C slave (priority 3) */
+	NVIC_SetPriority(DMA1_Channel1_IRQn, 2);
+	NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+	adc_block_ready = 0;
+	adc_block_phase = 0;
+	adc_block_mode = 1;
+#else
+	DMA1_Channel1->CNDTR = ADC_NUM_OF_CHANNELS;
+#endif
+}
+
+/**
+ * Stop the block mode, the DMA writes to adc_data_dump again.
+ * Call it with the ADC stopped and the DMA channel disabled.
+ */
+void adc_block_mode_stop(void) {
+#ifdef ADC_HALL_BLOCKS
+	NVIC_DisableIRQ(DMA1_Channel1_IRQn);
+	DMA1_Channel1->CCR &= ~(DMA_CCR_HTIE | DMA_CCR_TCIE);
+	DMA1->IFCR |= DMA_IFCR_CGIF1;
+	DMA1_Channel1->CMAR = (uint32_t) adc_data_dump;
+	adc_block_mode = 0;
+	adc_block_ready = 0;
+#endif
+}
+
+uint8_t adc_block_mode_active(void) {
+#ifdef ADC_HALL_BLOCKS
+	return adc_block_mode;
+#else
+	return 0;
+#endif
+}
+
+/**
+ * The DMA interrupt of the block mode: mark the half that the DMA just filled
+ * as ready, the main loop processes it (adc_block_next), with the phase the
+ * main loop was in when the half was completed. The half that is
+ * ready is the one the DMA is not writing now. When the other half was still
+ * ready, the main loop was late and the DMA is writing over it: it is dropped
+ * and counted as an overrun, like a handler that was late for both flags.
+ */
+void adc_dma_block_handler(void) {
+#ifdef ADC_HALL_BLOCKS
+	uint32_t flags = DMA1->ISR & (DMA_ISR_HTIF1 | DMA_ISR_TCIF1);
+	uint8_t ready;
+	DMA1->IFCR |= DMA_IFCR_CGIF1;
+	if (adc_block_mode == 0 || flags == 0) {
+		return;
+	}
+	if (flags == (DMA_ISR_HTIF1 | DMA_ISR_TCIF1)) {
+		adc_block_overruns++;
+	}
+	if (DMA1_Channel1->CNDTR > ADC_BLOCK_SEQUENCES * ADC_NUM_OF_CHANNELS) {
+		ready = 2; /* the DMA writes the first half, the second is full */
+	} else {
+		ready = 1;
+	}
+	if (adc_block_ready & ~ready) {
+		adc_block_overruns++;
+	}
+	adc_block_phases[ready - 1] = adc_block_phase;
+	adc_block_ready = ready;
+#endif
+}
+
+/**
+ * Set the phase of the calibration that the main loop is in, the halves that
+ * the DMA completes from now on get it (see peak_process_adc_values_sensor)
+ */
+void adc_block_set_phase(uint8_t phase) {
+#ifdef ADC_HALL_BLOCKS
+	adc_block_phase = phase;
+#endif
+}
+
+/**
+ * Return the half of the double buffer that is full and not processed yet,
+ * or NULL when there is none. *phase* gets the phase it was completed in.
+ * Call adc_block_done when it is processed.
+ */
+const uint16_t *adc_block_next(uint8_t *phase) {
+#ifdef ADC_HALL_BLOCKS
+	uint8_t ready = adc_block_ready;
+	if (ready & 1) {
+		*phase = adc_block_phases[0];
+		return (const uint16_t *) adc_block_buffer[0];
+	}
+	if (ready & 2) {
+		*phase = adc_block_phases[1];
+		return (const uint16_t *) adc_block_buffer[ADC_BLOCK_SEQUENCES];
+	}
+#endif
+	return NULL;
+}
+
+/**
+ * Return the half of the double buffer that the DMA is writing now, and in
+ * *sequences* how many of its sequences are complete. A sequence the DMA is
+ * still writing does not count.
+ */
+const uint16_t *adc_block_filling(uint16_t *sequences) {
+#ifdef ADC_HALL_BLOCKS
+	uint16_t remaining = DMA1_Channel1->CNDTR;
+	uint16_t done = (2 * ADC_BLOCK_SEQUENCES)
+			- ((remaining + ADC_NUM_OF_CHANNELS - 1) / ADC_NUM_OF_CHANNELS);
+	if (done < ADC_BLOCK_SEQUENCES) {
+		*sequences = done;
+		return (const uint16_t *) adc_block_buffer[0];
+	}
+	*sequences = done - ADC_BLOCK_SEQUENCES;
+	return (const uint16_t *) adc_block_buffer[ADC_BLOCK_SEQUENCES];
+#else
+	*sequences = 0;
+	return NULL;
+#endif
+}
+
+/**
+ * The half that adc_block_next returned is processed, the DMA may fill it again
+ */
+void adc_block_done(const uint16_t *block) {
+#ifdef ADC_HALL_BLOCKS
+	uint8_t half = (block == (const uint16_t *) adc_block_buffer[0]) ? 1 : 2;
+	interrupts_disable();
+	if (adc_block_ready & half) {
+		adc_block_ready &= ~half;
+		adc_blocks++;
+	}
+	interrupts_enable();
+#endif
+}
+
 /**
  * Write the data read by the ADC to the vregs, for debug and status purposes
  */
@@ -188,6 +382,10 @@ void adc_write_data_to_vregs(void) {
 	/* convert to A */
 	current_measured = (current_measured) / ADC_CURRENT_SENSITIVITY;
 	vregs_write(VREGS_MOTOR_CURRENT, (uint8_t) current_measured);
+#ifdef ADC_HALL_BLOCKS
+	vregs_write(VREGS_PEAK_BLOCKS, adc_blocks);
+	vregs_write(VREGS_PEAK_BLOCK_OVERRUNS, adc_block_overruns);
+#endif
 }
 
 /**
@@ -38,6 +38,7 @@
 
 static struct motion_state state = { 0, 0, 0, 0, 0, 0, 0 };
 static struct motion_state new_state = { 0, 0, 0, 0, 0, 0, 0 };
+static struct motion_state broadcast_state = { 0, 0, 0, 0, 0, 0, 0 };
 static uint32_t std_var; /* standard deviation of the hall-sensor with a peak at hall-sensor 3. */
 static uint8_t calibrate = 1; /* When Zebro is turned on, calibrate should first be on. */
 static int16_t last_known_position = 0;
@@ -50,6 +51,130 @@ static int16_t position_setpoint;
 static int16_t absolute_position;
 static int16_t previous_encoder_position;
 
+/* Motion commands waiting for the current command to reach its time (ring buffer). */
+static struct motion_state queue[MOTION_QUEUE_SIZE];
+static uint8_t queue_head = 0;
+static uint8_t queue_count = 0;
+/* End time in ms (time_get_time_ms) of the active walk command, valid when active_end_valid is 1. */
+static uint32_t active_end_ms;
+static uint8_t active_end_valid = 0;
+
+static void motion_reset_candidate(struct motion_state *candidate) {
+	candidate->mode = 0;
+	candidate->position_a = 0;
+	candidate->position_b = 0;
+	candidate->time_a = 0;
+	candidate->time_b = 0;
+	candidate->new_data_flag = 0;
+	candidate->crc = 0;
+}
+
+/**
+ * Make the given command the active command. The time of a walk command is
+ * the moment it should reach its position, which is also when the next
+ * queued command starts.
+ */
+static void motion_activate(struct motion_state *command) {
+	state = *command;
+	active_end_valid = (command->mode == MOTION_MODE_WALK_FORWARD
+			|| command->mode == MOTION_MODE_WALK_BACKWARD);
+	active_end_ms = (command->time_a * 1000) + (command->time_b * 4);
+	motion_write_state_to_vregs(state);
+}
+
+/**
+ * Check if the new command is sane, and if it is, activate it.
+ * Reset the candidate state in either case. A new command replaces the
+ * queued commands as well.
+ */
+static void motion_update(struct motion_state *candidate) {
+	if (!motion_validate_state(*candidate)
+			&& ((calibrate == 0) || (candidate->mode == 0) /* idle state should always be reached */
+			|| (candidate->mode == 1) /* we should always be able to go to calibration state if necessary */
+			|| (candidate->mode == 255))) { /* panic state should of course always be reachable */
+		motion_queue_flush();
+		motion_activate(candidate);
+	}
+	motion_reset_candidate(candidate);
+}
+
+/**
+ * Check if the command is in the queue already. The time of a walk command
+ * is absolute, so two queued commands are never the same unless the host
+ * sent one twice (it repeats a batch that was not acknowledged completely).
+ */
+static uint8_t motion_queue_contains(struct motion_state *candidate) {
+	uint8_t i;
+	struct motion_state *queued;
+
+	for (i = 0; i < queue_count; i++) {
+		queued = &queue[(queue_head + i) % MOTION_QUEUE_SIZE];
+		if (queued->mode == candidate->mode
+				&& queued->position_a == candidate->position_a
+				&& queued->position_b == candidate->position_b
+				&& queued->time_a == candidate->time_a
+				&& queued->time_b == candidate->time_b) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Put the new command at the end of the queue. Only walk commands are
+ * queued, and only when the leg is calibrated and not in an emergency stop;
+ * a command that does not fit is dropped (the host can read
+ * VREGS_MOTION_QUEUE_DEPTH), and so is a command that is queued already.
+ */
+static void motion_queue_push(struct motion_state *candidate) {
+	if (!motion_validate_state(*candidate) && (calibrate == 0)
+			&& (state.mode != MOTION_MODE_EMERGENCY_STOP)
+			&& (candidate->mode == MOTION_MODE_WALK_FORWARD
+					|| candidate->mode == MOTION_MODE_WALK_BACKWARD)
+			&& (queue_count < MOTION_QUEUE_SIZE)
+			&& !motion_queue_contains(candidate)) {
+		queue[(queue_head + queue_count) % MOTION_QUEUE_SIZE] = *candidate;
+		queue_count++;
+		vregs_write(VREGS_MOTION_QUEUE_DEPTH, queue_count);
+	}
+	motion_reset_candidate(candidate);
+}
+
+/**
+ * Throw the queued commands away. The active command is not changed.
+ */
+void motion_queue_flush(void) {
+	queue_head = 0;
+	queue_count = 0;
+	vregs_write(VREGS_MOTION_QUEUE_DEPTH, 0);
+}
+
+/**
+ * Start the next queued command when the active command reached its time
+ * (or when there is no active walk command). Nothing is started during
+ * calibration or an emergency stop.
+ */
+static void motion_queue_process(void) {
+	uint8_t due;
+
+	if (state.mode == MOTION_MODE_CALIBRATE
+			|| state.mode == MOTION_MODE_EMERGENCY_STOP) {
+		return;
+	}
+	due = (active_end_valid == 0)
+			|| (time_calculate_delta(time_get_time_ms(), active_end_ms) >= 0);
+	if (due) {
+		/* forget the end time once it passed, so it can not look like a future time after the rollover */
+		active_end_valid = 0;
+	}
+	if (due && queue_count > 0) {
+		motion_activate(&queue[queue_head]);
+		queue_head = (queue_head + 1) % MOTION_QUEUE_SIZE;
+		queue_count--;
+		vregs_write(VREGS_MOTION_QUEUE_DEPTH, queue_count);
+	}
+}
+
 /**
  * Process data send to any of the addresses in the motion control range.
  */
@@ -91,20 +216,17 @@ int32_t motion_new_zebrobus_data(uint32_t address, uint8_t data) {
 		 * Reset the 'new_state' struct in either case
 		 */
 	case VREGS_MOTION_UPDATE:
-		if (!motion_validate_state(new_state)
-				&& ((calibrate == 0) || (new_state.mode == 0) /* idle state should always be reached */
-				|| (new_state.mode == 1) /* we should always be able to go to calibration state if necessary */
-				|| (new_state.mode == 255))) { /* panic state should of course always be reachable */
-			state = new_state;
-			motion_write_state_to_vregs(state);
+		if (data == MOTION_UPDATE_QUEUE) {
+			motion_queue_push(&new_state);
+		} else {
+			motion_update(&new_state);
+		}
+		break;
+
+	case VREGS_MOTION_QUEUE_FLUSH:
+		if (data == 1) {
+			motion_queue_flush();
 		}
-		new_state.mode = 0;
-		new_state.position_a = 0;
-		new_state.position_b = 0;
-		new_state.time_a = 0;
-		new_state.time_b = 0;
-		new_state.new_data_flag = 0;
-		new_state.crc = 0;
 		break;
 
 	default:
@@ -114,6 +236,64 @@ int32_t motion_new_zebrobus_data(uint32_t address, uint8_t data) {
 	return 0;
 }
 
+/**
+ * Process data send to the broadcast schedule frame. The frame holds the
+ * position and time of every leg; only the slice of this leg is kept. All legs
+ * receive the UPDATE byte at the same moment, so they start their new
+ * commands together.
+ */
+int32_t motion_new_broadcast_data(uint32_t address, uint8_t data) {
+	int32_t position = address_get_position();
+	int32_t slice_start;
+
+	/* a leg without a slice ignores the whole frame, the UPDATE byte too:
+	 * its broadcast_state is never filled, so it would act on zeros */
+	if ((position % 2) != 0 || (position / 2) >= MOTION_BROADCAST_SLICES) {
+		return 0;
+	}
+
+	if (address == VREGS_BROADCAST_MODE) {
+		broadcast_state.mode = data;
+		return 0;
+	}
+
+	if (address == VREGS_BROADCAST_UPDATE) {
+		broadcast_state.new_data_flag = 1;
+		if (data == MOTION_UPDATE_QUEUE) {
+			motion_queue_push(&broadcast_state);
+		} else {
+			motion_update(&broadcast_state);
+		}
+		return 0;
+	}
+
+	/* position a, position b, time a, time b of the leg at this position */
+	slice_start = VREGS_BROADCAST_SLICE_0
+			+ (position / 2) * MOTION_BROADCAST_SLICE_SIZE;
+	if (address < slice_start
+			|| address >= slice_start + MOTION_BROADCAST_SLICE_SIZE) {
+		return 0;
+	}
+
+	switch (address - slice_start) {
+	case 0:
+		broadcast_state.position_a = data;
+		break;
+	case 1:
+		broadcast_state.position_b = data;
+		break;
+	case 2:
+		broadcast_state.time_a = data;
+		break;
+	case 3:
+		broadcast_state.time_b = data;
+		break;
+	default:
+		break;
+	}
+	return 0;
+}
+
 /**
  * Write the values of the given state to the vregs
  */
@@ -345,6 +525,8 @@ int32_t motion_command_zebro() {
 			(uint8_t) (position_setpoint));
 #endif
 
+	motion_queue_process();
+
 	switch (state.mode) {
 
 	case MOTION_MODE_IDLE:
@@ -385,8 +567,8 @@ int32_t motion_command_zebro() {
 						| (1 << ADC_HAL_3_CH) | (1 << ADC_ID_RESISTOR_CH)
 						| (1 << ADC_BATTERY_CH) | (1 << ADC_MOTOR_CURRENT_CH)
 						| (1 << ADC_TEMP_CH);
-				/* set size of transfer */
-				DMA1_Channel1->CNDTR = ADC_NUM_OF_CHANNELS;
+				/* set size of transfer: a double buffer of sequences, processed by the peak detector per half (see adc.c) */
+				adc_block_mode_start();
 				/* enable the DMA channel */
 				DMA1_Channel1->CCR |= DMA_CCR_EN;
 				/* Write AD_START to 1 to start conversions. */
@@ -513,6 +695,8 @@ int32_t motion_command_zebro() {
 				/* Select the channels to convert. */
 				ADC1->CHSELR = (1 << ADC_BATTERY_CH)
 						| (1 << ADC_MOTOR_CURRENT_CH) | (1 << ADC_TEMP_CH);
+				/* the hall sensors are not needed any more, the DMA writes a single sequence again */
+				adc_block_mode_stop();
 				/* set size of transfer */
 				DMA1_Channel1->CNDTR = ADC_NUM_OF_CHANNELS - 4;
 				/* enable the DMA channel */
@@ -797,6 +981,7 @@ int32_t motion_return_to_idle(void) {
  * Clear the current motion command, and go to emergency stop
  */
 int32_t motion_emergency_stop(void) {
+	motion_queue_flush();
 	state.mode = 255;
 	state.position_a = 0;
 	state.position_b = 0;
@@ -31,96 +31,204 @@
 
 uint8_t peak_detected[PEAK_NUM_OF_SENSORS] = { 0, 0, 0 };
 //static uint32_t time_old;
+static struct peak_history filteredHistory[PEAK_NUM_OF_SENSORS];
+static struct peak_history history_deltas; /* shared by the three sensors */
+static uint16_t avgHistory[PEAK_NUM_OF_SENSORS][2];
+static uint16_t threshold;
+static uint16_t avg_delta = 0;
+static uint16_t max_avg_delta;
+#ifdef ADC_HALL_BLOCKS
+/* phase of the calibration (fill_up_arrays) of the last pass in the block mode of the ADC */
+static uint8_t block_fill_up_arrays = 0;
+/* the half of the ADC that was being written at the last change of the phase, and its sequences processed then */
+static const uint16_t *block_partial = NULL;
+static uint16_t block_partial_done = 0;
+#endif
 
 /**
- * Process ADC data for a single hall sensor
+ * Add a sample to a history, the oldest sample drops out of it.
+ * The history is a circular buffer with a running sum, so this costs the same
+ * for any PEAK_HISTORY_LAG. It gives exactly what move_over_array_elements and
+ * mean gave on the shifted array: the sum of the integers is kept exactly.
  */
-uint8_t peak_process_adc_values_sensor(uint8_t fill_up_arrays) {
-//	if (((TIM16->CNT) - time_old) >= 8) { /* every 1.25 ms, if this loop is too fast, peak detected does not stay high long enough and doesn't work because delta becomes too small. If too slow, the detection rate is too slow. */
-//		time_old = (TIM16->CNT);
-		uint16_t adc_data;
-		static uint16_t filteredHistory[PEAK_NUM_OF_SENSORS][PEAK_HISTORY_LAG];
-		static uint16_t array_deltas[PEAK_HISTORY_LAG];
-		static uint16_t avgHistory[PEAK_NUM_OF_SENSORS][2];
-		uint32_t standard_deviation = get_std_var();
-		uint8_t sensor;
-		static uint16_t threshold;
-		static uint8_t influence = 8; // Now we need to shift the result inside the first if statement by 4 bits.
-		static uint16_t delta = 0;
-		static uint16_t avg_delta = 0;
-		static uint16_t max_avg_delta;
-//		static uint16_t counter;
+static void peak_history_push(struct peak_history *history, uint16_t sample) {
+	history->newest = (history->newest + 1) % PEAK_HISTORY_LAG;
+	history->sum = history->sum - history->samples[history->newest] + sample;
+	history->samples[history->newest] = sample;
+}
 
-		for (sensor = 0; sensor < PEAK_NUM_OF_SENSORS; sensor++) {
-			/* sanity check */
-			if (sensor < 0 || sensor > PEAK_NUM_OF_SENSORS) {
-				return PEAK_ERROR;
-			}
+/**
+ * Mean of the samples in a history. We lose some accuracy, but this is no problem.
+ */
+static uint16_t peak_history_mean(const struct peak_history *history) {
+	return (uint16_t) (history->sum / PEAK_HISTORY_LAG);
+}
 
-			/* get the latest ADC value */
-			adc_data = adc_get_value(peak_get_adc_channel_index(sensor));
+/**
+ * Process one sequence of the ADC (all channels) for the three hall sensors
+ */
+static uint8_t peak_process_sequence(const uint16_t *sequence,
+		uint8_t fill_up_arrays) {
+	uint16_t adc_data;
+	uint32_t standard_deviation = get_std_var();
+	uint8_t sensor;
+	static uint8_t influence = 8; // Now we need to shift the result inside the first if statement by 4 bits.
+	static uint16_t delta = 0;
+//	static uint16_t counter;
 
-//			if (counter <= (4 * PEAK_HISTORY_LAG)) {
-//				avgHistory[sensor][0] = adc_data;
-//				counter += 1;
-//			}
+	for (sensor = 0; sensor < PEAK_NUM_OF_SENSORS; sensor++) {
+		/* sanity check */
+		if (sensor < 0 || sensor > PEAK_NUM_OF_SENSORS) {
+			return PEAK_ERROR;
+		}
 
-			// We assume the magnet in the leg is positioned such that peaks will be positive.
-			delta = abs(adc_data - avgHistory[sensor][0]);
-			move_over_array_elements(array_deltas, PEAK_HISTORY_LAG);
-			array_deltas[PEAK_HISTORY_LAG - 1] = delta;
-			avg_delta = mean(array_deltas, PEAK_HISTORY_LAG);
-			/* avg_delta should not be more than a quarter of the range. We are measuring positive magnetic changes, so only the top half counts. More than half of that is enough range and max should not be higher. */
-			if ((avg_delta > max_avg_delta) && (fill_up_arrays == 1)) {
-				max_avg_delta = avg_delta;
-			}
-			if (standard_deviation != 0 && (fill_up_arrays == 2)) {
-				threshold = (max_avg_delta / standard_deviation);
-			}
-			/* in our case std_var is always positive
-			 * threshold-1 is just right. Threshold-2 is too much and threshold - 0.5 can be too little
-			 */
-//			if ((avg_delta >= ((((threshold - 1)<<1) * standard_deviation)>>1)) && (fill_up_arrays == 3)) {
-			if ((avg_delta >= ((threshold - 2) * standard_deviation)) && (fill_up_arrays == 3)) {
-				peak_detected[sensor] = 1;
-				/* Make max_avg_delta 0 to be able to run calibration again and again. */
-				max_avg_delta = 0;
-				move_over_array_elements(filteredHistory[sensor],
-				PEAK_HISTORY_LAG);
+		/* get the latest ADC value */
+		adc_data = sequence[peak_get_adc_channel_index(sensor)];
 
-				filteredHistory[sensor][PEAK_HISTORY_LAG - 1] =
-						((influence * adc_data)
-								+ ((16 - influence)
-										* filteredHistory[sensor][PEAK_HISTORY_LAG
-												- 2])) >> 4; //Divide sum to get average of 16 samples. We lose some accuracy, but this is no problem.
-				avgHistory[sensor][0] = avgHistory[sensor][1];
-				avgHistory[sensor][1] = mean(filteredHistory[sensor],
-				PEAK_HISTORY_LAG); //Divide sum to get average. We lose some accuracy, but this is no problem.
-			} else {
-				//clearing the peak_detected flag is done where the flag is actually checked.
-				move_over_array_elements(filteredHistory[sensor],
-				PEAK_HISTORY_LAG);
-				filteredHistory[sensor][PEAK_HISTORY_LAG - 1] = adc_data;
-				avgHistory[sensor][0] = avgHistory[sensor][1];
-				avgHistory[sensor][1] = mean(filteredHistory[sensor],
-				PEAK_HISTORY_LAG);
-			}
+//		if (counter <= (4 * PEAK_HISTORY_LAG)) {
+//			avgHistory[sensor][0] = adc_data;
+//			counter += 1;
+//		}
+
+		// We assume the magnet in the leg is positioned such that peaks will be positive.
+		delta = abs(adc_data - avgHistory[sensor][0]);
+		peak_history_push(&history_deltas, delta);
+		avg_delta = peak_history_mean(&history_deltas);
+		/* avg_delta should not be more than a quarter of the range. We are measuring positive magnetic changes, so only the top half counts. More than half of that is enough range and max should not be higher. */
+		if ((avg_delta > max_avg_delta) && (fill_up_arrays == 1)) {
+			max_avg_delta = avg_delta;
+		}
+		if (standard_deviation != 0 && (fill_up_arrays == 2)) {
+			threshold = (max_avg_delta / standard_deviation);
+		}
+		/* in our case std_var is always positive
+		 * threshold-1 is just right. Threshold-2 is too much and threshold - 0.5 can be too little
+		 */
+//		if ((avg_delta >= ((((threshold - 1)<<1) * standard_deviation)>>1)) && (fill_up_arrays == 3)) {
+		if ((avg_delta >= ((threshold - 2) * standard_deviation)) && (fill_up_arrays == 3)) {
+			peak_detected[sensor] = 1;
+			/* Make max_avg_delta 0 to be able to run calibration again and again. */
+			max_avg_delta = 0;
+			/* filter with the newest sample so far */
+			peak_history_push(&filteredHistory[sensor],
+					((influence * adc_data)
+							+ ((16 - influence)
+									* filteredHistory[sensor].samples[filteredHistory[sensor].newest])) >> 4); //Divide sum to get average of 16 samples. We lose some accuracy, but this is no problem.
+			avgHistory[sensor][0] = avgHistory[sensor][1];
+			avgHistory[sensor][1] = peak_history_mean(&filteredHistory[sensor]);
+		} else {
+			//clearing the peak_detected flag is done where the flag is actually checked.
+			peak_history_push(&filteredHistory[sensor], adc_data);
+			avgHistory[sensor][0] = avgHistory[sensor][1];
+			avgHistory[sensor][1] = peak_history_mean(&filteredHistory[sensor]);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Write the state of the detector to the vregs, for debug purposes
+ */
+static void peak_write_to_vregs(void) {
 #ifdef DEBUG_VREGS
-			vregs_write(VREGS_PEAK_MAX_AVG_DELTA_A,
-					(uint8_t) (max_avg_delta >> 8));
-			vregs_write(VREGS_PEAK_MAX_AVG_DELTA_B, (uint8_t) (max_avg_delta));
-			vregs_write(VREGS_PEAK_AVG_DELTA, (uint8_t) (avg_delta >> 8));
-			vregs_write(VREGS_PEAK_THRESHOLD, (uint8_t) (threshold));
-			vregs_write((VREGS_PEAK_1_ADC_AVERAGE + sensor),
-					(avgHistory[sensor][1] >> 8));
-			vregs_write((VREGS_PEAK_1_DETECTED + sensor),
-					peak_detected[sensor]);
+	uint8_t sensor;
+	vregs_write(VREGS_PEAK_MAX_AVG_DELTA_A, (uint8_t) (max_avg_delta >> 8));
+	vregs_write(VREGS_PEAK_MAX_AVG_DELTA_B, (uint8_t) (max_avg_delta));
+	vregs_write(VREGS_PEAK_AVG_DELTA, (uint8_t) (avg_delta >> 8));
+	vregs_write(VREGS_PEAK_THRESHOLD, (uint8_t) (threshold));
+	for (sensor = 0; sensor < PEAK_NUM_OF_SENSORS; sensor++) {
+		vregs_write((VREGS_PEAK_1_ADC_AVERAGE + sensor),
+				(avgHistory[sensor][1] >> 8));
+		vregs_write((VREGS_PEAK_1_DETECTED + sensor), peak_detected[sensor]);
+	}
 #endif
+}
+
+/**
+ * Process ADC data for the hall sensors, called every pass of the main loop
+ * with the phase of the calibration (fill_up_arrays).
+ *
+ * Without the block mode of the ADC this takes the last sequence the ADC made,
+ * so a sequence can be missed or seen twice, depending on the loop speed.
+ * In the block mode (ADC_HALL_BLOCKS) every sequence is processed exactly once
+ * by peak_process_block, with the phase the main loop was in when the ADC made
+ * it. The halves that the DMA completed since the last pass are processed
+ * first, with the phase they were completed in (adc_block_next). When the
+ * phase changes, the sequences of the half the DMA is writing now are made in
+ * the old phase, so they are processed right away, and the rest of the half
+ * when it is complete. A change to phase 0 is a new calibration: the sequences
+ * since adc_block_mode_start are made in phase 0. The threshold is also set in
+ * the pass of phase 2, which is a single pass: the ADC may make no sequence
+ * in it.
+ */
+uint8_t peak_process_adc_values_sensor(uint8_t fill_up_arrays) {
+	uint16_t sequence[ADC_NUM_OF_CHANNELS];
+	uint8_t i;
+
+#ifdef ADC_HALL_BLOCKS
+	if (adc_block_mode_active()) {
+		const uint16_t *block;
+		uint16_t done;
+		uint8_t phase;
+		uint32_t standard_deviation;
+		while ((block = adc_block_next(&phase)) != NULL) {
+			done = 0;
+			if (block == block_partial) {
+				done = block_partial_done;
+				block_partial = NULL;
+			}
+			peak_process_block(&block[done * ADC_NUM_OF_CHANNELS],
+					ADC_BLOCK_SEQUENCES - done, phase);
+			adc_block_done(block);
 		}
-//	}
+		if (fill_up_arrays == 0) {
+			block_partial = NULL;
+		} else if (fill_up_arrays != block_fill_up_arrays) {
+			block = adc_block_filling(&done);
+			/* a half that was dropped (an overrun) is written again from the start */
+			if (block != block_partial || done < block_partial_done) {
+				block_partial = block;
+				block_partial_done = 0;
+			}
+			peak_process_block(
+					&block[block_partial_done * ADC_NUM_OF_CHANNELS],
+					done - block_partial_done, block_fill_up_arrays);
+			block_partial_done = done;
+		}
+		block_fill_up_arrays = fill_up_arrays;
+		adc_block_set_phase(fill_up_arrays);
+		standard_deviation = get_std_var();
+		if (standard_deviation != 0 && (fill_up_arrays == 2)) {
+			threshold = (max_avg_delta / standard_deviation);
+		}
+		peak_write_to_vregs();
+		return 0;
+	}
+#endif
+	for (i = 0; i < ADC_NUM_OF_CHANNELS; i++) {
+		sequence[i] = adc_get_value(i);
+	}
+	if (peak_process_sequence(sequence, fill_up_arrays) != 0) {
+		return PEAK_ERROR;
+	}
+	peak_write_to_vregs();
 	return 0;
 }
 
+/**
+ * Process a block of *sequences* ADC sequences, (a part of) a half of the
+ * double buffer of the block mode of the ADC (see adc_block_next), all in
+ * phase *fill_up_arrays*
+ */
+void peak_process_block(const uint16_t *block, uint16_t sequences,
+		uint8_t fill_up_arrays) {
+	uint16_t s;
+	for (s = 0; s < sequences; s++) {
+		peak_process_sequence(&block[s * ADC_NUM_OF_CHANNELS],
+				fill_up_arrays);
+	}
+}
+
 // Move all elements of an array one to the left
 void move_over_array_elements(uint16_t *array, uint8_t array_size) {
 	uint8_t i;
@@ -165,7 +273,8 @@ uint8_t peak_get_adc_channel_index(uint8_t sensor) {
 
 // Return if a peak for a certain hall-sensor was detected.
 uint8_t get_peak_detected(uint8_t sensor) {
-	uint8_t peak = peak_detected[sensor];
+	uint8_t peak;
+	peak = peak_detected[sensor];
 	if (peak == 1) {
 		reset_peak_detected(); //If 1 peak was detected, all of them should be cleared.
 	}
@@ -24,8 +24,19 @@
 #include "leds.h"
 #include "globals.h"
 #include "errors.h"
+#include "interrupts.h"
 
 static uint8_t current_seconds = 0;
+/* Length of the current second in ticks: TIME_ONE_SECOND_COUNTER_VALUE plus the trim and the slew step */
+static uint16_t second_length = TIME_ONE_SECOND_COUNTER_VALUE;
+static int32_t slew_remaining = 0; /* ticks the clock is still ahead of the host */
+static int16_t trim = 0; /* 1/16 ticks per second */
+static int32_t trim_fraction = 0;
+static uint8_t latched_seconds;
+static uint16_t latched_counter;
+static uint16_t latched_length;
+static uint8_t new_slew_a;
+static uint8_t new_trim_a;
 int32_t start_time;
 uint8_t start_flag = 1;
 
@@ -139,12 +150,60 @@ int32_t time_counter_reset(void){
 
 
 /**
- * Write the value of the counter to the vregs
+ * Calculate the length of the next second: the trim (with the fractions of
+ * the earlier seconds) and at most TIME_SLEW_MAX_TICKS of the slew. A
+ * longer second makes the clock run slower, so a clock that is ahead is
+ * slewed back without a jump.
+ */
+static void time_next_second_length(void) {
+	int32_t step;
+	int32_t whole;
+
+	trim_fraction += trim;
+	whole = trim_fraction / 16;
+	trim_fraction -= whole * 16;
+
+	step = slew_remaining;
+	if (step > TIME_SLEW_MAX_TICKS) step = TIME_SLEW_MAX_TICKS;
+	if (step < -TIME_SLEW_MAX_TICKS) step = -TIME_SLEW_MAX_TICKS;
+	slew_remaining -= step;
+
+	second_length = (uint16_t) (TIME_ONE_SECOND_COUNTER_VALUE + whole + step);
+}
+
+static void time_write_residual(void) {
+	int32_t residual = slew_remaining;
+
+	if (residual > INT8_MAX) residual = INT8_MAX;
+	if (residual < INT8_MIN) residual = INT8_MIN;
+	vregs_write(VREGS_CLOCK_RESIDUAL, (uint8_t) (int8_t) residual);
+}
+
+/**
+ * Write the value of the counter to the vregs.
+ * The clock counts the seconds itself: when the counter passes the length of
+ * the second, the length is taken off the counter. The counter ticks once
+ * every 750 clock cycles, so the read-modify-write does not lose a tick.
+ * The interrupts are off meanwhile (like in time_step), so a latch from the
+ * bus never sees the counter of the new second with the old seconds.
  */
 uint16_t time_check_time(void){
 	uint16_t counter_value;
-
+	uint8_t new_second = 0;
+
+	interrupts_disable();
+	if (TIM16->CNT >= second_length) {
+		TIM16->CNT -= second_length;
+		current_seconds = (current_seconds + 1) % (TIME_MAX_SECONDS + 1);
+		time_next_second_length();
+		new_second = 1;
+	}
 	counter_value = TIM16->CNT;
+	interrupts_enable();
+
+	if (new_second) {
+		time_write_residual();
+	}
 	vregs_write(VREGS_CLOCK_A, (uint8_t) (counter_value >> 8));
 	vregs_write(VREGS_CLOCK_B, (uint8_t) counter_value);
 	vregs_write(VREGS_SYNC_COUNTER, (uint8_t) current_seconds);
@@ -163,7 +222,7 @@ uint32_t time_get_time_ms(void){
 	uint32_t time;
 
 	time = current_seconds * 1000;
-	time = time + ((TIM16->CNT * 1000) / TIME_ONE_SECOND_COUNTER_VALUE);
+	time = time + ((TIM16->CNT * 1000) / second_length);
 
 	return time;
 }
@@ -174,15 +233,101 @@ uint16_t time17_get_time(void){
 
 /**
  * Set the current time, to a certain amount of seconds.
- * Fractional seconds are set to 0.
+ * Fractional seconds are set to 0, and the slew is forgotten.
  */
 uint8_t time_set_time(uint8_t seconds){
 	current_seconds = seconds;
 	TIM16->CNT = 0;
+	slew_remaining = 0;
+	time_next_second_length();
+	time_write_residual();
 
 	return seconds;
 }
 
+/**
+ * Remember the time the clock latch byte arrived. Called from the ZebroBus
+ * interrupt, so the time does not depend on when the main loop gets to the
+ * write request.
+ */
+void time_latch(void){
+	latched_counter = TIM16->CNT;
+	latched_seconds = current_seconds;
+	latched_length = second_length;
+}
+
+/**
+ * Move the clock back by the given amount of ticks at once (forward when
+ * negative).
+ */
+static void time_step(int32_t ticks){
+	int32_t counter;
+
+	interrupts_disable();
+	counter = (int32_t) TIM16->CNT - ticks;
+	while (counter < 0) {
+		counter += second_length;
+		current_seconds = (current_seconds + TIME_MAX_SECONDS) % (TIME_MAX_SECONDS + 1);
+	}
+	while (counter >= second_length) {
+		counter -= second_length;
+		current_seconds = (current_seconds + 1) % (TIME_MAX_SECONDS + 1);
+	}
+	TIM16->CNT = (uint16_t) counter;
+	interrupts_enable();
+}
+
+/**
+ * Process the clock synchronisation registers: the latch (the latched time
+ * goes to the vregs, scaled to TIME_ONE_SECOND_COUNTER_VALUE ticks per
+ * second, followed by the sequence number so the host knows it is fresh),
+ * the slew and the trim.
+ */
+int32_t time_new_zebrobus_data(uint32_t address, uint8_t data){
+	int32_t value;
+	uint32_t counter;
+
+	switch (address) {
+
+	case VREGS_CLOCK_LATCH:
+		counter = ((uint32_t) latched_counter * TIME_ONE_SECOND_COUNTER_VALUE) / latched_length;
+		vregs_write(VREGS_CLOCK_LATCH_SECONDS, latched_seconds);
+		vregs_write(VREGS_CLOCK_LATCH_COUNTER_A, (uint8_t) (counter >> 8));
+		vregs_write(VREGS_CLOCK_LATCH_COUNTER_B, (uint8_t) counter);
+		vregs_write(VREGS_CLOCK_LATCH_SEQUENCE, data);
+		break;
+
+	case VREGS_CLOCK_SLEW_A:
+		new_slew_a = data;
+		break;
+
+	case VREGS_CLOCK_SLEW_B:
+		value = (int16_t) ((new_slew_a << 8) | data);
+		if (value > TIME_SLEW_STEP_TICKS || value < -TIME_SLEW_STEP_TICKS) {
+			time_step(value);
+			value = 0;
+		}
+		slew_remaining = value;
+		time_write_residual();
+		break;
+
+	case VREGS_CLOCK_TRIM_A:
+		new_trim_a = data;
+		break;
+
+	case VREGS_CLOCK_TRIM_B:
+		value = (int16_t) ((new_trim_a << 8) | data);
+		if (value > TIME_TRIM_MAX) value = TIME_TRIM_MAX;
+		if (value < -TIME_TRIM_MAX) value = -TIME_TRIM_MAX;
+		trim = (int16_t) value;
+		break;
+
+	default:
+		break;
+	}
+	return 0;
+}
+
 /**
  * Demo thingy to make the clock count up, when no locomotive controller is
  * present.
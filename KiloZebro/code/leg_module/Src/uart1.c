@@ -20,10 +20,28 @@
 #include "leds.h"
 #include "stdint.h"
 #include "vregs.h"
+#include "time.h"
 
 uint8_t vregs[VREGS_FILE_TOTAL_SIZE];
 uint8_t vregs_buffer[VREGS_NUM_OF_BUFFERS][VREGS_FILE_TOTAL_SIZE];
 
+/* telemetry settings, see vregs.h */
+static uint8_t telemetry_mode = UART1_TELEMETRY_OFF;
+static uint8_t telemetry_baud = UART1_BAUD_2M;
+static uint8_t telemetry_baud_changed = 0;
+static uint8_t telemetry_period = 0;
+static uint8_t telemetry_mask[VREGS_TELEMETRY_MASK_LAST - VREGS_TELEMETRY_MASK_FIRST + 1];
+/* the registers selected in the mask, in increasing order */
+static uint8_t telemetry_registers[VREGS_FILE_SIZE];
+static uint16_t telemetry_count = 0;
+static uint8_t telemetry_sequence = 0;
+/* time since the last compact frame, in TIM17 ticks */
+static uint32_t telemetry_elapsed = 0;
+static uint16_t telemetry_last_time = 0;
+static uint8_t telemetry_frame[UART1_TELEMETRY_HEADER_SIZE + VREGS_FILE_SIZE + 1];
+
+static const uint16_t uart1_baud_dividers[] = { UART1_BAUD_DIVIDER_2M,
+		UART1_BAUD_DIVIDER_1M, UART1_BAUD_DIVIDER_3M };
 
 
 int32_t uart1_init(void){
@@ -32,7 +50,7 @@ int32_t uart1_init(void){
 	__HAL_RCC_USART1_CLK_ENABLE();
 
 	/* keep many of the default settings, oversampling, word length ... */
-	/* set baud rate to 115.2 kbaud */
+	/* set baud rate to 2 Mbaud */
 	USART1->BRR = UART1_BAUD_RATE_DIVIDER;
 	/* enable the UART transmitter*/
 	USART1->CR1 |= USART_CR1_TE | USART_CR1_UE;
@@ -54,7 +72,7 @@ int32_t uart1_init_dma(void){
 	__HAL_RCC_USART1_CLK_ENABLE();
 
 	/* keep many of the default settings, oversampling, word length ... */
-	/* set baud rate to 115.2 kbaud */
+	/* set baud rate to 2 Mbaud */
 	USART1->BRR = UART1_BAUD_RATE_DIVIDER;
 	/* set DMA transmitter mode */
 	USART1->CR3 |= USART_CR3_DMAT;
@@ -109,21 +127,138 @@ int32_t uart1_wait_until_done(void){
 
 
 /**
- * Write the correct data to the vregs, and transmit it over the UART
+ * Change the baud rate to the preset in telemetry_baud.
+ * Call it when the DMA is done, it waits for the last byte to leave the UART.
+ */
+static void uart1_set_baud(void){
+	while(!(USART1->ISR & USART_ISR_TC));
+	USART1->CR1 &= ~USART_CR1_UE;
+	USART1->BRR = uart1_baud_dividers[telemetry_baud];
+	USART1->CR1 |= USART_CR1_UE;
+}
+
+/**
+ * Build a compact telemetry frame of the selected registers from the vregs
+ * buffer (a consistent snapshot), see vregs.h for the layout.
+ * Return: the length of the frame
+ */
+static uint16_t uart1_build_telemetry_frame(void){
+	uint8_t *buffer = vregs_get_buffer_address();
+	uint16_t cursor = UART1_TELEMETRY_HEADER_SIZE;
+	uint16_t i;
+	uint8_t checksum;
+
+	telemetry_frame[0] = UART1_TELEMETRY_SYNC_0;
+	telemetry_frame[1] = UART1_TELEMETRY_SYNC_1;
+	telemetry_frame[2] = telemetry_sequence;
+	telemetry_frame[3] = (uint8_t) telemetry_count;
+	checksum = telemetry_sequence + (uint8_t) telemetry_count;
+	for(i = 0; i < telemetry_count; i++){
+		telemetry_frame[cursor] = buffer[telemetry_registers[i]];
+		checksum += telemetry_frame[cursor++];
+	}
+	telemetry_frame[cursor++] = checksum;
+	telemetry_sequence++;
+
+	return cursor;
+}
+
+/**
+ * Process a write over ZebroBus to the telemetry registers
+ */
+void uart1_new_zebrobus_data(uint8_t address, uint8_t data){
+	uint16_t reg;
+
+	switch(address){
+	case VREGS_TELEMETRY_MODE:
+		if(data <= UART1_TELEMETRY_COMPACT){
+			telemetry_mode = data;
+		}
+		vregs_write(VREGS_TELEMETRY_MODE, telemetry_mode);
+		break;
+
+	case VREGS_TELEMETRY_BAUD:
+		if(data <= UART1_BAUD_3M && data != telemetry_baud){
+			telemetry_baud = data;
+			telemetry_baud_changed = 1;
+		}
+		vregs_write(VREGS_TELEMETRY_BAUD, telemetry_baud);
+		break;
+
+	case VREGS_TELEMETRY_PERIOD:
+		telemetry_period = data;
+		vregs_write(VREGS_TELEMETRY_PERIOD, telemetry_period);
+		break;
+
+	default:
+		if(address < VREGS_TELEMETRY_MASK_FIRST || address > VREGS_TELEMETRY_MASK_LAST){
+			break;
+		}
+		telemetry_mask[address - VREGS_TELEMETRY_MASK_FIRST] = data;
+		vregs_write(address, data);
+		/* list the selected registers once, not for every frame */
+		telemetry_count = 0;
+		for(reg = 0; reg < VREGS_FILE_SIZE; reg++){
+			if(telemetry_mask[reg >> 3] & (1 << (reg & 7))){
+				telemetry_registers[telemetry_count++] = (uint8_t) reg;
+			}
+		}
+		break;
+	}
+}
+
+/**
+ * Write the correct data to the vregs, and transmit it over the UART.
+ * This is either the whole register file, or in the compact telemetry mode
+ * a frame of the selected registers every VREGS_TELEMETRY_PERIOD.
  */
 int32_t uart1_trigger_dma_once(void){
+	uint16_t start_time;
+	uint16_t writeout_time;
+	int32_t copied;
+	uint16_t now;
+	uint16_t length;
+	uint32_t period;
+
+	/* called every loop pass, so the 16 bit timer does not wrap in between */
+	now = time17_get_time();
+	period = (uint32_t) telemetry_period * UART1_TELEMETRY_PERIOD_TICKS;
+	if(telemetry_elapsed < period){
+		telemetry_elapsed += (uint16_t) (now - telemetry_last_time);
+	}
+	telemetry_last_time = now;
+
 	/* if the transfer is done */
 	if(DMA1->ISR & DMA_ISR_TCIF4){
-		/* copy the right data in to the vreg data buffer */
-		vregs_writeout();
+		if(telemetry_mode == UART1_TELEMETRY_COMPACT && telemetry_elapsed < period){
+			return 0;
+		}
+		if(telemetry_baud_changed){
+			uart1_set_baud();
+			telemetry_baud_changed = 0;
+		}
+		/* copy the right data in to the vreg data buffer, and time it */
+		start_time = time17_get_time();
+		copied = vregs_writeout();
+		writeout_time = (uint16_t) (time17_get_time() - start_time) / UART1_WRITEOUT_TIME_TICKS;
+		vregs_write(VREGS_WRITEOUT_TIME, (writeout_time > 255) ? 255 : (uint8_t) writeout_time);
+		vregs_write(VREGS_WRITEOUT_COUNT, (copied > 255) ? 255 : (uint8_t) copied);
 		/* clear the flag */
 		DMA1->IFCR |= DMA_IFCR_CTCIF4;
 		/* disable the channel */
 		DMA1_Channel4->CCR &= ~DMA_CCR_EN;
-		/* set the origin of the data */
-		DMA1_Channel4->CMAR = (uint32_t) vregs_get_buffer_address();
-		/* set the number of bytes to be transfered */
-		DMA1_Channel4->CNDTR = VREGS_FILE_TOTAL_SIZE;
+		if(telemetry_mode == UART1_TELEMETRY_COMPACT){
+			length = uart1_build_telemetry_frame();
+			/* keep the rate, but do not send a burst of frames after a slow pass */
+			telemetry_elapsed = (telemetry_elapsed >= 2 * period) ? 0 : telemetry_elapsed - period;
+			DMA1_Channel4->CMAR = (uint32_t) telemetry_frame;
+			DMA1_Channel4->CNDTR = length;
+		} else {
+			/* set the origin of the data */
+			DMA1_Channel4->CMAR = (uint32_t) vregs_get_buffer_address();
+			/* set the number of bytes to be transfered */
+			DMA1_Channel4->CNDTR = VREGS_FILE_TOTAL_SIZE;
+		}
 		/* enable the channel: send the data */
 		DMA1_Channel4->CCR |= DMA_CCR_EN;
 	}
@@ -23,6 +23,17 @@
 uint8_t vregs[VREGS_FILE_TOTAL_SIZE];
 uint8_t vregs_buffer[VREGS_NUM_OF_BUFFERS][VREGS_FILE_TOTAL_SIZE];
 static int32_t buffer_selector = 0;
+/**
+ * A flag per register and per buffer, set when the register was written
+ * since it was last copied to that buffer. Every flag has its own byte, so
+ * vregs_write (also called from interrupts) sets it and vregs_writeout clears
+ * it with a single store, neither can undo the other. The union lets
+ * vregs_writeout skip four clean registers with a single word read.
+ */
+static union {
+	uint8_t flags[VREGS_FILE_SIZE];
+	uint32_t words[VREGS_FILE_SIZE / 4];
+} vregs_dirty[VREGS_NUM_OF_BUFFERS];
 
 /**
  * Initialise the virtual registers. Set all fields to their default values.
@@ -46,9 +57,16 @@ void vregs_init(){
 	vregs[VREGS_FILE_TOTAL_SIZE - 4] = VREGS_SYNC_1;
 	vregs[VREGS_FILE_TOTAL_SIZE - 5] = VREGS_SYNC_0;
 
-	/* also initialise the buffers */
-	vregs_writeout();
-	vregs_writeout();
+	/* also initialise the buffers, the sync bytes behind the registers are
+	 * only copied here */
+	for(cursor = 0; cursor < VREGS_FILE_TOTAL_SIZE; cursor++){
+		vregs_buffer[0][cursor] = vregs[cursor];
+		vregs_buffer[1][cursor] = vregs[cursor];
+	}
+	for(cursor = 0; cursor < VREGS_FILE_SIZE; cursor++){
+		vregs_dirty[0].flags[cursor] = 0;
+		vregs_dirty[1].flags[cursor] = 0;
+	}
 }
 
 /**
@@ -57,7 +75,13 @@ void vregs_init(){
  */
 int32_t vregs_write(uint32_t address, uint8_t data){
 	if (address < VREGS_FILE_SIZE){
-		vregs[address] = data;
+		/* most registers are written every loop with the same value, they
+		 * do not need to be copied again */
+		if (vregs[address] != data){
+			vregs[address] = data;
+			vregs_dirty[0].flags[address] = 1;
+			vregs_dirty[1].flags[address] = 1;
+		}
 		return 0;
 	}
 	else return 1;
@@ -88,13 +112,29 @@ uint8_t vregs_read_buffer(uint32_t address){
 
 /**
  * Copy the vregs to the buffer, where they can be accessed over ZebroBus
- * and UART1
+ * and UART1. Only the registers written since the last copy to this buffer
+ * (two writeouts ago) are copied.
+ * Return: the number of registers copied
  */
 int32_t vregs_writeout(){
+	int32_t word;
 	int32_t cursor;
-
-	for(cursor = 0; cursor < VREGS_FILE_TOTAL_SIZE; cursor++){
-		vregs_buffer[!buffer_selector][cursor] = vregs[cursor];
+	int32_t copied = 0;
+	uint8_t buffer = !buffer_selector;
+
+	for(word = 0; word < (VREGS_FILE_SIZE / 4); word++){
+		if(vregs_dirty[buffer].words[word] == 0){
+			continue;
+		}
+		for(cursor = word * 4; cursor < (word * 4) + 4; cursor++){
+			if(vregs_dirty[buffer].flags[cursor]){
+				/* clear the flag before copying: a write from an interrupt in
+				 * between sets it again, or is copied already */
+				vregs_dirty[buffer].flags[cursor] = 0;
+				vregs_buffer[buffer][cursor] = vregs[cursor];
+				copied++;
+			}
+		}
 	}
 
 	/**
@@ -109,7 +149,7 @@ int32_t vregs_writeout(){
 	 * END critical section
 	 */
 
-	return 0;
+	return copied;
 }
 
 /**
@@ -24,6 +24,7 @@
 #include "interrupts.h"
 #include "errors.h"
 #include "adc.h"
+#include "uart1.h"
 #include "globals.h"
 
 static int32_t zebrobus_is_master = 0;
@@ -34,6 +35,9 @@ static uint8_t request_address = 0x00;
 static struct zebrobus_write_request write_queue[ZEBROBUS_SIZE_OF_QUEUE];
 static int32_t queue_start = 0, queue_end = 0;
 
+static int32_t speed = ZEBROBUS_SPEED_STANDARD;
+static volatile uint8_t bus_errors = 0;
+
 //TODO: implement ignoring of read requests to a multicast address
 //TODO: implement serial nr. it can be stored in non volatile memory
 //TODO: implement motor voltage field it can be stored in non volatile memory
@@ -86,6 +90,69 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 			return return_struct;
 		}
 
+		/**
+		 * Read the bus timing preset stored in flash. A page that was never written
+		 * (or holds something else) gives the standard preset.
+		 */
+		static int32_t zebrobus_load_speed(void) {
+			uint16_t setting = *(const volatile uint16_t *) ZEBROBUS_SETTINGS_PAGE;
+
+			if ((setting >> 8) == ZEBROBUS_SETTINGS_MAGIC
+					&& (setting & 0xFF) <= ZEBROBUS_SPEED_FAST_PLUS) {
+				return setting & 0xFF;
+			}
+			return ZEBROBUS_SPEED_STANDARD;
+		}
+
+		/**
+		 * Store the bus timing preset for the next boot. Erasing the page stalls the
+		 * CPU for up to 40 ms, so the host should only do this while the leg stands
+		 * still; a preset that is already stored is not written again.
+		 */
+		static int32_t zebrobus_store_speed(uint8_t new_speed) {
+			FLASH_EraseInitTypeDef erase;
+			uint32_t page_error = 0;
+			int32_t result = 0;
+
+			if (new_speed > ZEBROBUS_SPEED_FAST_PLUS) {
+				return -1;
+			}
+			if (*(const volatile uint16_t *) ZEBROBUS_SETTINGS_PAGE
+					== ((ZEBROBUS_SETTINGS_MAGIC << 8) | new_speed)) {
+				return 0;
+			}
+
+			time_reset_watchdog();
+			HAL_FLASH_Unlock();
+			erase.TypeErase = FLASH_TYPEERASE_PAGES;
+			erase.PageAddress = ZEBROBUS_SETTINGS_PAGE;
+			erase.NbPages = 1;
+			if (HAL_FLASHEx_Erase(&erase, &page_error) != HAL_OK
+					|| HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD,
+							ZEBROBUS_SETTINGS_PAGE,
+							(ZEBROBUS_SETTINGS_MAGIC << 8) | new_speed) != HAL_OK) {
+				result = -1;
+			}
+			HAL_FLASH_Lock();
+			time_reset_watchdog();
+
+			return result;
+		}
+
+		/**
+		 * Show the active preset and the one stored for the next boot.
+		 */
+		static void zebrobus_write_speed_to_vregs(void) {
+			vregs_write(VREGS_ZEBROBUS_SPEED, (zebrobus_load_speed() << 4) | speed);
+		}
+
+		/**
+		 * Return the active bus timing preset (ZEBROBUS_SPEED_*)
+		 */
+		int32_t zebrobus_get_speed() {
+			return speed;
+		}
+
 		/**
 		 * Initialise the ZebroBus (I2C1) interface in slave mode.
 		 */
@@ -115,9 +182,23 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 			__HAL_RCC_I2C1_CLK_ENABLE()
 			;
 
+			/* the timing of the preset stored in flash, Fm+ also needs the
+			 * stronger drivers of the pins */
+			speed = zebrobus_load_speed();
+			if (speed == ZEBROBUS_SPEED_FAST_PLUS) {
+				__HAL_RCC_SYSCFG_CLK_ENABLE();
+				SYSCFG->CFGR1 |= SYSCFG_CFGR1_I2C_FMP_PB7
+						| SYSCFG_CFGR1_I2C_FMP_PB8;
+				I2C1->TIMINGR = (uint32_t) ZEBROBUS_TIMINGR_FAST_PLUS;
+			} else if (speed == ZEBROBUS_SPEED_FAST) {
+				I2C1->TIMINGR = (uint32_t) ZEBROBUS_TIMINGR_FAST;
+			} else {
+//				I2C1->TIMINGR = (uint32_t) 0x20303e5d;
+				I2C1->TIMINGR = (uint32_t) ZEBROBUS_TIMINGR_STANDARD;
+			}
+			zebrobus_write_speed_to_vregs();
+
 			/* enable and set the slave address */
-//			I2C1->TIMINGR = (uint32_t) 0x20303e5d;
-			I2C1->TIMINGR = (uint32_t) 0x0070D8FF;
 			I2C1->OAR1 = I2C_OAR1_OA1EN | (address_get_zebrobus_address() << 1);
 			I2C1->OAR2 = I2C_OAR2_OA2EN | (ADDRESS_BROADCAST_ADDRESS << 1);
 
@@ -128,10 +209,11 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 			 * * Non empty receive buffer
 			 * * Empty transmit buffer
 			 * * Stop bit
-			 * *
+			 * * Bus error, overrun (counted in VREGS_ZEBROBUS_ERRORS)
 			 */
 			I2C1->CR1 = I2C_CR1_PE | I2C_CR1_ADDRIE | I2C_CR1_RXIE
-					| I2C_CR1_TXIE | I2C_CR1_STOPIE | I2C_CR1_NOSTRETCH;
+					| I2C_CR1_TXIE | I2C_CR1_STOPIE | I2C_CR1_ERRIE
+					| I2C_CR1_NOSTRETCH;
 
 			return 0;
 		}
@@ -147,6 +229,18 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 			/* get a copy of the status register */
 			status_register = I2C1->ISR;
 
+			/* a misplaced start or stop, or a byte that came (or had to go)
+			 * before the last one was handled: count it, the stop condition
+			 * resets the state machine */
+			if (status_register & (I2C_ISR_BERR | I2C_ISR_OVR | I2C_ISR_ARLO)) {
+				I2C1->ICR |= I2C_ICR_BERRCF | I2C_ICR_OVRCF | I2C_ICR_ARLOCF;
+				bus_errors++;
+				if (!(status_register & (I2C_ISR_STOPF | I2C_ISR_ADDR
+						| I2C_ISR_RXNE | I2C_ISR_TXIS))) {
+					return;
+				}
+			}
+
 			/* on stop condition, reset state machine */
 			if (status_register & I2C_ISR_STOPF) {
 				request_address = request_address_base;
@@ -194,6 +288,9 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 					 * when more bytes are written, they are written to the next position
 					 * in the vregs */
 				case ZEBROBUS_STATE_RECEIVED_ADDR:
+					if (request_address == VREGS_CLOCK_LATCH) {
+						time_latch();	/* now, not when the request is processed */
+					}
 					zebrobus_put_write_request(request_address++, I2C1->RXDR);
 					/* the vregs are circular */
 					if (request_address)
@@ -232,6 +329,7 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 				case VREGS_MOTION_NEW_DATA_FLAG:
 				case VREGS_MOTION_CRC:
 				case VREGS_MOTION_UPDATE:
+				case VREGS_MOTION_QUEUE_FLUSH:
 					motion_new_zebrobus_data(request.address, request.data);
 					break;
 
@@ -285,6 +383,14 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 					time_set_time(request.data);
 					break;
 
+				case VREGS_CLOCK_LATCH:
+				case VREGS_CLOCK_SLEW_A:
+				case VREGS_CLOCK_SLEW_B:
+				case VREGS_CLOCK_TRIM_A:
+				case VREGS_CLOCK_TRIM_B:
+					time_new_zebrobus_data(request.address, request.data);
+					break;
+
 				case VREGS_SERIAL_ID:
 					// TODO: do this properly
 					vregs_write(VREGS_SERIAL_ID, request.data);
@@ -298,12 +404,34 @@ struct zebrobus_write_request zebrobus_get_write_request() {
 					errors_reset_emergency_stop(request.data);
 					break;
 
+				case VREGS_ZEBROBUS_SPEED:
+					zebrobus_store_speed(request.data);
+					zebrobus_write_speed_to_vregs();
+					break;
+
+				case VREGS_ZEBROBUS_REBOOT:
+					if (request.data == ZEBROBUS_REBOOT_KEY) {
+						NVIC_SystemReset();
+					}
+					break;
+
 				default:
+					/* broadcast schedule frame */
+					if (request.address >= VREGS_BROADCAST_MODE
+							&& request.address <= VREGS_BROADCAST_UPDATE) {
+						motion_new_broadcast_data(request.address,
+								request.data);
+					} else if (request.address >= VREGS_TELEMETRY_MODE
+							&& request.address <= VREGS_TELEMETRY_MASK_LAST) {
+						uart1_new_zebrobus_data(request.address, request.data);
+					}
 					break;
 
 				}
 			}
 
+			vregs_write(VREGS_ZEBROBUS_ERRORS, bus_errors);
+
 			return safety_counter;
 		}
 
@@ -0,0 +1,236 @@
+/**
+ * POOT
+ * The Zebro Project
+ * Delft University of Technology
+ *
+ * Filename: peakTest.c
+ *
+ * Description:
+ * Host test of the hall sensor peak detector (leg_module/Src/peak.c).
+ * There are no recordings of the hall sensors, so the detector is fed
+ * synthetic traces: a baseline per sensor, noise of +-30, and a magnet peak
+ * (a gaussian of 25 samples wide) every period samples, the three sensors a
+ * third of a period apart. The 200 traces differ in period (200-599
+ * samples), peak height (300-1799), noise and standard deviation (5-44).
+ * Every trace goes through the calibration phases of motion.c: 0 (turning
+ * backwards), 1 (collecting), a single pass of 2 (the threshold) and 3
+ * (detecting), with get_peak_detected polled every 5 passes like motion.c.
+ *
+ * The detector of the tree (cur_) runs next to old/peak.c (old_), the
+ * detector before the hall histories became circular buffers with running
+ * sums, which make takes from git. Both must give the same flags on every pass and the same
+ * detections. The exit code is 1 when they differ.
+ *
+ * In the block mode of the ADC (ADC_HALL_BLOCKS) the current detector gets
+ * the sequences per half of the double buffer instead, which the main loop
+ * takes from adc_block_next. The DMA makes the sample of a pass after the
+ * detectors ran, in the phase of that pass, like the ADC does while the main
+ * loop waits, and the old detector reads it in the next pass. The flags of the
+ * current detector are up to a block behind, so the detections are polled
+ * when both detectors have seen the same samples, once per block and at the
+ * end of the trace, and counted per trace. The counts must be the same.
+ *
+ * make && ./peakTest		compare the flags
+ * ./peakTest block		compare the detections in the block mode
+ * ./peakTest bench		time per main loop pass of both detectors
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "adc.h"
+
+#define PEAK_TEST_TRACES 200
+#define PEAK_TEST_POLL 5 /* passes between two get_peak_detected calls, like the main loop of motion.c */
+#define PEAK_TEST_BENCH_PASSES 2000000
+
+uint8_t old_peak_process_adc_values_sensor(uint8_t fill_up_arrays);
+uint8_t cur_peak_process_adc_values_sensor(uint8_t fill_up_arrays);
+uint8_t old_get_peak_detected(uint8_t sensor);
+uint8_t cur_get_peak_detected(uint8_t sensor);
+extern uint8_t old_peak_detected[3];
+extern uint8_t cur_peak_detected[3];
+
+static uint16_t adc_values[ADC_NUM_OF_CHANNELS];
+static uint32_t std_var;
+static uint8_t block_mode = 0;
+/* the double buffer of the block mode, filled one sequence every pass */
+static uint16_t block_buffer[2 * ADC_BLOCK_SEQUENCES][ADC_NUM_OF_CHANNELS];
+static uint16_t block_fill = 0;
+static uint8_t block_ready = 0;
+/* the phase of the main loop, and the phase each half was completed in */
+static uint8_t block_phase = 0;
+static uint8_t block_phases[2];
+
+/* The stubs of the leg module, for both detectors */
+uint16_t old_adc_get_value(int32_t index) { return adc_values[index]; }
+uint16_t cur_adc_get_value(int32_t index) { return adc_values[index]; }
+uint32_t old_get_std_var(void) { return std_var; }
+uint32_t cur_get_std_var(void) { return std_var; }
+uint8_t cur_adc_block_mode_active(void) { return block_mode; }
+int32_t cur_interrupts_disable(void) { return 0; }
+int32_t cur_interrupts_enable(void) { return 0; }
+int32_t old_vregs_write(uint32_t address, uint8_t data) { return 0; }
+int32_t cur_vregs_write(uint32_t address, uint8_t data) { return 0; }
+void *old_memmove(void *to, const void *from, size_t n) { return memmove(to, from, n); }
+void *cur_memmove(void *to, const void *from, size_t n) { return memmove(to, from, n); }
+
+void cur_adc_block_set_phase(uint8_t phase) { block_phase = phase; }
+
+const uint16_t *cur_adc_block_next(uint8_t *phase) {
+	if (block_ready & 1) {
+		*phase = block_phases[0];
+		return &block_buffer[0][0];
+	}
+	if (block_ready & 2) {
+		*phase = block_phases[1];
+		return &block_buffer[ADC_BLOCK_SEQUENCES][0];
+	}
+	return NULL;
+}
+
+const uint16_t *cur_adc_block_filling(uint16_t *sequences) {
+	*sequences = block_fill % ADC_BLOCK_SEQUENCES;
+	return &block_buffer[block_fill - *sequences][0];
+}
+
+void cur_adc_block_done(const uint16_t *block) {
+	block_ready &= (block == &block_buffer[0][0]) ? ~1 : ~2;
+}
+
+/**
+ * What the DMA does in the block mode: the sequence goes to the double buffer,
+ * a half that is full is ready for the main loop, with the phase of the main
+ * loop (adc_dma_block_handler)
+ */
+static void peak_test_dma(void) {
+	memcpy(block_buffer[block_fill], adc_values, sizeof(adc_values));
+	block_fill++;
+	if (block_fill == ADC_BLOCK_SEQUENCES) {
+		block_phases[0] = block_phase;
+		block_ready |= 1;
+	}
+	if (block_fill == 2 * ADC_BLOCK_SEQUENCES) {
+		block_phases[1] = block_phase;
+		block_ready |= 2;
+		block_fill = 0;
+	}
+}
+
+/**
+ * The value of hall sensor *sensor* at sample *t* of a trace
+ */
+static uint16_t peak_test_sample(int sensor, long t, int period, int height,
+		unsigned *seed) {
+	double phase = fmod(t + sensor * period / 3.0, period) - period / 2.0;
+	double value = 2000 + sensor * 40
+			+ height * exp(-phase * phase / (2 * 25.0 * 25.0))
+			+ ((int) (rand_r(seed) % 61) - 30);
+
+	if (value < 0) value = 0;
+	if (value > 4095) value = 4095;
+	return (uint16_t) value;
+}
+
+static void peak_test_fill(long t, int period, int height, unsigned *seed) {
+	adc_values[ADC_HAL_1_INDEX] = peak_test_sample(0, t, period, height, seed);
+	adc_values[ADC_HAL_2_INDEX] = peak_test_sample(1, t, period, height, seed);
+	adc_values[ADC_HAL_3_INDEX] = peak_test_sample(2, t, period, height, seed);
+}
+
+static int peak_test_compare(void) {
+	long passes = 0, detections = 0, mismatches = 0;
+	long block_detections = 0, block_mismatches = 0;
+	int trace, phase, sensor;
+
+	for (trace = 0; trace < PEAK_TEST_TRACES; trace++) {
+		unsigned seed = trace;
+		int period = 200 + trace * 7 % 400;
+		int height = 300 + trace * 37 % 1500;
+		long t = 0, k, n;
+		long old_trace = 0, cur_trace = 0;
+
+		std_var = 0;
+		block_fill = 0;
+		block_ready = 0;
+		for (phase = 0; phase < 4; phase++) {
+			/* the whole trace is a whole number of blocks */
+			n = (phase == 0) ? 2000 : (phase == 1) ? 3008 : (phase == 2) ? 1 : 19999;
+			if (phase == 2) std_var = 5 + trace % 40;
+			for (k = 0; k < n; k++, t++) {
+				/* in the block mode both have seen the samples up to the last block here: the old detector before this pass */
+				uint8_t poll = (phase == 3) && ((!block_mode && k % PEAK_TEST_POLL == 0)
+						|| (block_mode && block_fill % ADC_BLOCK_SEQUENCES == 0));
+				peak_test_fill(t, period, height, &seed);
+				if (poll && block_mode) old_trace += old_get_peak_detected(2);
+				old_peak_process_adc_values_sensor(phase);
+				cur_peak_process_adc_values_sensor(phase);
+				for (sensor = 0; sensor < 3 && !block_mode; sensor++) {
+					if (old_peak_detected[sensor] != cur_peak_detected[sensor]) mismatches++;
+				}
+				if (poll && block_mode) cur_trace += cur_get_peak_detected(2);
+				if (poll && !block_mode) {
+					uint8_t old_detected = old_get_peak_detected(2);
+					uint8_t cur_detected = cur_get_peak_detected(2);
+					if (old_detected != cur_detected) mismatches++;
+					old_trace += old_detected;
+				}
+				if (block_mode) peak_test_dma();
+				passes++;
+			}
+		}
+		if (block_mode) {
+			/* the last block, which the DMA completed in the last pass */
+			cur_peak_process_adc_values_sensor(3);
+			old_trace += old_get_peak_detected(2);
+			cur_trace += cur_get_peak_detected(2);
+			if (cur_trace != old_trace) block_mismatches++;
+		}
+		detections += old_trace;
+		block_detections += cur_trace;
+	}
+	if (block_mode) {
+		printf("block: %d traces, %ld passes, %ld detections (old %ld), %ld mismatches\n",
+				PEAK_TEST_TRACES, passes, block_detections, detections, block_mismatches);
+		return block_mismatches != 0;
+	}
+	printf("%d traces, %ld passes, %ld detections, %ld mismatches\n",
+			PEAK_TEST_TRACES, passes, detections, mismatches);
+	return mismatches != 0;
+}
+
+static int peak_test_bench(void) {
+	int which;
+	long k;
+
+	std_var = 20;
+	for (which = 0; which < 2; which++) {
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (k = 0; k < PEAK_TEST_BENCH_PASSES; k++) {
+			adc_values[ADC_HAL_1_INDEX] = 2000 + k % 97;
+			adc_values[ADC_HAL_2_INDEX] = 2040 + k % 89;
+			adc_values[ADC_HAL_3_INDEX] = 2080 + k % 83;
+			if (which == 0) old_peak_process_adc_values_sensor(3);
+			else cur_peak_process_adc_values_sensor(3);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		printf("%s: %.1f ns per pass\n", (which == 0) ? "old" : "cur",
+				((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec))
+						/ PEAK_TEST_BENCH_PASSES);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv) {
+	if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+		return peak_test_bench();
+	}
+	if (argc > 1 && strcmp(argv[1], "block") == 0) {
+		block_mode = 1;
+	}
+	return peak_test_compare();
+}
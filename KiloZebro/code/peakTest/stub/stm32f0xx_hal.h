@@ -0,0 +1,12 @@
+/**
+ * POOT
+ * The Zebro Project
+ * Delft University of Technology
+ *
+ * Filename: stm32f0xx_hal.h
+ *
+ * Description:
+ * Empty stand-in for the HAL, so peak.c compiles on the host (peakTest.c).
+ * The peak detector does not use the hardware: the ADC values, the
+ * standard deviation and the vregs come from peakTest.c.
+ */
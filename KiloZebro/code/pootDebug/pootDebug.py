@@ -13,6 +13,8 @@
 # It receives the debug information transmitten over the UART of the
 # leg module. If provided, it will use the vref.h header file to
 # label the debug information
+# With --telemetry it decodes the compact telemetry frames of the leg
+# module (VREGS_TELEMETRY_MODE 1) instead of the whole register file.
 #
 # Authors:
 # Piet De Vaere -- Piet@DeVae.re
@@ -44,6 +46,7 @@ class Debugger:
                     udp_ip,                 # ip to send udp packages to
                     udp_port,               # port to send udp packages to
                     history_depth,          # how many packages to keep in memory
+                    telemetry = False,      # when True we decode compact telemetry frames of view_data
                     align_value = [0xFF, 0x45, 0x12, 0xEA, 0x4B],     # sequence used to find the beginning of a frame
                     package_length = 261):  # length of a frame
     
@@ -61,7 +64,13 @@ class Debugger:
         else:
             self.udp_enabled = False
             self.udp_socket = None
-        self.serial = SerialInterface(  port_name = self.serial_port,
+        if telemetry:
+            self.serial = TelemetryInterface(port_name = self.serial_port,
+                                        baudrate = self.baudrate,
+                                        package_length = self.package_length,
+                                        registers = view_data)
+        else:
+            self.serial = SerialInterface(  port_name = self.serial_port,
                                         baudrate = self.baudrate,
                                         package_length = self.package_length,
                                         align_value = self.align_value);
@@ -207,6 +216,8 @@ class Debugger:
             
         self.screen.addstr(0,0, serial_data.get_time().isoformat())
         self.screen.addstr(0, total_width - 1, "|")
+        if isinstance(self.serial, TelemetryInterface):
+            self.screen.addstr(0, total_width, "lost: {} ".format(self.serial.lost))
             
         y_cursor = 1
         x_cursor = 0
@@ -292,6 +303,73 @@ class SerialInterface:
 
         return SerialPackage(serial_package)
 
+"""
+class to interface the serial port in the compact telemetry mode of the leg
+module. A frame is: sync 0, sync 1, sequence number, number of registers,
+the registers in increasing order, checksum (see vregs.h). The registers are
+put in a whole register file, so the rest of the tools work as before.
+"""
+class TelemetryInterface(SerialInterface):
+    sync = [0xA5, 0x5A]
+    mask_first = 213    # VREGS_TELEMETRY_MASK_FIRST
+
+    def __init__(self, port_name, baudrate, package_length, registers):
+        SerialInterface.__init__(self, port_name, baudrate, package_length, self.sync)
+        self.registers = sorted(set(registers))
+        self.package = bytearray(package_length)
+        self.sequence = None
+        self.lost = 0
+
+    """
+    Return the ZebroBus writes (register, value) of the mask that selects
+    *registers*
+    """
+    @staticmethod
+    def mask_writes(registers):
+        mask = [0] * 32
+        for register in registers:
+            mask[register >> 3] |= 1 << (register & 7)
+        return [(TelemetryInterface.mask_first + i, mask[i]) for i in range(32)]
+
+    """
+    Align the receiver with the sync bytes at the start of a frame
+    """
+    def align(self):
+        state = 0
+        while(state < len(self.align_value)):
+            serial_data = self.port.read()[0]
+            if serial_data == self.align_value[state]:
+                state = state + 1
+            elif serial_data == self.align_value[0]:
+                state = 1
+            else:
+                state = 0
+
+    """
+    Read a frame from the leg module, the sync bytes are read already
+    """
+    def read_package(self):
+        while(True):
+            header = self.port.read(2)
+            count = header[1]
+            # another selection than ours, or not aligned
+            if count == len(self.registers) % 256:
+                data = self.port.read(count + 1)
+                if (sum(header) + sum(data[:count])) % 256 == data[count]:
+                    break
+            self.align()
+
+        sequence = header[0]
+        if self.sequence is not None:
+            self.lost = self.lost + ((sequence - self.sequence - 1) % 256)
+        self.sequence = sequence
+        for index in range(count):
+            self.package[self.registers[index]] = data[index]
+        # the next frame starts with the sync bytes
+        if list(self.port.read(2)) != self.align_value:
+            self.align()
+        return SerialPackage(bytes(self.package))
+
 """
 Wrapper class for a serial data frame
 """
@@ -347,7 +425,8 @@ def main(stdscr, args):
             udp_ip = args.udp_ip,
             udp_port = args.udp_port,
             history_depth = args.history_depth,
-            write_log = args.write_log)
+            write_log = args.write_log,
+            telemetry = args.telemetry)
     debugger.start()
 
 if __name__ == "__main__":
@@ -395,7 +474,24 @@ if __name__ == "__main__":
             type = int,
             help = "Only watch a subset of virtual registers",
             dest = "view_data")
+    parser.add_argument("-m", "--telemetry",
+            action = "store_true",
+            default = False,
+            help = "Decode compact telemetry frames of the registers given with -r",
+            dest = "telemetry")
+    parser.add_argument("-s", "--show-mask",
+            action = "store_true",
+            default = False,
+            help = "Print the ZebroBus writes that select the registers given with -r for the telemetry, and exit",
+            dest = "show_mask")
     args = parser.parse_args()
+
+    if (args.telemetry or args.show_mask) and not args.view_data:
+        parser.error("the telemetry needs the registers, give them with -r")
+    if args.show_mask:
+        for register, value in TelemetryInterface.mask_writes(args.view_data):
+            print("{} {}".format(register, value))
+        exit(0)
     
     curses.wrapper(main, args)
     
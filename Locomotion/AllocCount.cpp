@@ -0,0 +1,57 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <atomic>
+#include <new>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "AllocCount.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE ALLOCATION COUNTER
+// The walking loop should not allocate memory once it runs: an allocation can take long at an unlucky moment (and the loop has to
+// be in time for the legs, see Deadline.cpp). Every operator new of the program goes through the replacement below, which only
+// counts it. ./Walking alloccheck runs the loop on simulated legs, and fails when one of the ALLOCCHECK_PASSES passes after the
+// warm up allocated anything.
+
+
+static std::atomic<long> allocations(0);
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The replacements of the global operator new and delete (new[] and delete[] use these as well)
+void *operator new(size_t size)
+{
+	allocations++;
+	void *p = malloc(size == 0 ? 1 : size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Amount of operator new calls since the start of the program
+long AllocCount()
+{
+	return allocations.load();
+}
@@ -0,0 +1,13 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+using namespace std;
+
+// HEADER FILE FOR THE ALLOCATION COUNTER! See the .cpp file for the extended explanations
+
+#define ALLOCCHECK_WARMUP 1000		// Loop passes before counting starts (the robot starts walking and the schedule fills up)
+#define ALLOCCHECK_PASSES 10000		// Loop passes that are counted, none of them may allocate
+
+long AllocCount(); // Amount of operator new calls since the start of the program
+
+#endif
@@ -0,0 +1,387 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <map>
+#ifdef WIRINGPI
+#include <wiringPi.h>
+#include <wiringPiI2C.h>
+#endif
+#include "Bus.h"
+#include "SimBus.h"
+#include "MultiBus.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BUS BACKENDS
+// Communications.cpp does not talk to wiringPi directly, but to a Bus. There are three backends:
+//  - wiringpi: the wiringPi I2C functions (only when compiled with -DWIRINGPI)
+//  - i2c:      the Linux I2C driver (/dev/i2c-N) with the same SMBus commands wiringPi uses, works on any Linux board
+//  - sim:      the simulated legs of SimBus.cpp, no hardware needed
+// The backend is chosen with the ZEBRO_BUS environment variable, for example ZEBRO_BUS=i2c:/dev/i2c-1 or ZEBRO_BUS=sim:100
+// Next to the single register functions of wiringPi, every backend can write a block of registers in one transaction: the leg
+// firmware (zebrobus.c) increments the register address after every received byte, so a whole motion command is one I2C write.
+// The commands of all six legs can also be combined in one batch: one I2C_RDWR call with a message per leg, separated by repeated
+// starts, so a stride update costs one kernel call instead of six. Adapters that can only do SMBus get the writes one by one.
+// Reads work the same way: the leg sends the registers from the requested one on, so the telemetry (110-113) of a leg is one
+// block read, and the telemetry of all legs is one batch (a register write and a read per leg, all with repeated starts).
+// A list of backends, for example ZEBRO_BUS=i2c:/dev/i2c-1,i2c:/dev/i2c-3, puts the legs on more buses that work at the same time (see MultiBus.cpp).
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// A backend without block writes writes the registers one by one
+int Bus::writeBlock(int fd, int reg, const uint8_t *data, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		if (writeReg8(fd, reg + i, data[i]) < 0)
+			return -1;
+	}
+	return 0;
+}
+
+// A backend without batches does the block writes one by one (a failed write does not stop the others)
+int Bus::writeBatch(BusWrite *writes, int count)
+{
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		writes[i].result = writeBlock(writes[i].fd, writes[i].reg, writes[i].data, writes[i].n);
+		if (writes[i].result < 0)
+			result = -1;
+	}
+	return result;
+}
+
+// A backend without block reads reads the registers one by one
+int Bus::readBlock(int fd, int reg, uint8_t *data, int n)
+{
+	for (int i = 0; i < n; i++)
+	{
+		int value = readReg8(fd, reg + i);
+		if (value < 0)
+			return -1;
+		data[i] = value;
+	}
+	return 0;
+}
+
+// A backend without batches does the block reads one by one
+int Bus::readBatch(BusRead *reads, int count)
+{
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reads[i].result = readBlock(reads[i].fd, reads[i].reg, reads[i].data, reads[i].n);
+		if (reads[i].result < 0)
+			result = -1;
+	}
+	return result;
+}
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The part of the Linux I2C driver and wiringPi backends that makes batches. Both have a /dev/i2c file descriptor per leg, and
+// I2C_RDWR can be called on any of them, because every message carries its own address.
+class I2CDevBus : public Bus
+{
+public:
+	I2CDevBus() : rdwr(-1) {}
+
+	int writeBatch(BusWrite *writes, int count)
+	{
+		if (count <= 0)
+			return 0;
+		if (combine(writes[0].fd) == 0 || count > BUS_BATCH_MAX)
+			return Bus::writeBatch(writes, count);
+
+		uint8_t buffers[BUS_BATCH_MAX][BUS_BLOCK_MAX + 1];
+		struct i2c_msg messages[BUS_BATCH_MAX];
+		for (int i = 0; i < count; i++)
+		{
+			map<int, int>::iterator found = adresses.find(writes[i].fd);
+			if (found == adresses.end() || writes[i].n > BUS_BLOCK_MAX)
+				return Bus::writeBatch(writes, count);
+			buffers[i][0] = writes[i].reg;				// Register first, the leg increments it after every byte
+			for (int j = 0; j < writes[i].n; j++)
+				buffers[i][j + 1] = writes[i].data[j];
+			messages[i].addr = found->second;
+			messages[i].flags = 0;
+			messages[i].len = writes[i].n + 1;
+			messages[i].buf = buffers[i];
+		}
+		struct i2c_rdwr_ioctl_data batch;
+		batch.msgs = messages;
+		batch.nmsgs = count;
+		syscalls++;
+		if (ioctl(writes[0].fd, I2C_RDWR, &batch) >= 0)
+		{
+			for (int i = 0; i < count; i++)
+				writes[i].result = 0;
+			return 0;
+		}
+		// The transfer stops at the first leg that does not answer and the ioctl does not tell which one that was, so everything is sent
+		// again one by one: the others still get their command, and a leg ignores a queue command (LEG_UPDATE_QUEUE) it has queued already
+		return Bus::writeBatch(writes, count);
+	}
+
+	int readBlock(int fd, int reg, uint8_t *data, int n)
+	{
+		if (n > BUS_BLOCK_MAX)
+			return -1;
+		union i2c_smbus_data value;
+		value.block[0] = n;					// i2c_smbus_read_i2c_block_data: the amount of registers to read
+		if (smbus(fd, I2C_SMBUS_READ, reg, I2C_SMBUS_I2C_BLOCK_DATA, &value) < 0)
+			return -1;
+		for (int i = 0; i < n; i++)
+			data[i] = value.block[i + 1];
+		return 0;
+	}
+
+	int readBatch(BusRead *reads, int count)
+	{
+		if (count <= 0)
+			return 0;
+		if (combine(reads[0].fd) == 0 || 2 * count > BUS_BATCH_MAX)
+			return Bus::readBatch(reads, count);
+
+		uint8_t registers[BUS_BATCH_MAX / 2];
+		struct i2c_msg messages[BUS_BATCH_MAX];
+		for (int i = 0; i < count; i++)
+		{
+			map<int, int>::iterator found = adresses.find(reads[i].fd);
+			if (found == adresses.end() || reads[i].n > BUS_BLOCK_MAX)
+				return Bus::readBatch(reads, count);
+			registers[i] = reads[i].reg;
+			messages[2 * i].addr = found->second;			// Sets the register the leg starts reading from
+			messages[2 * i].flags = 0;
+			messages[2 * i].len = 1;
+			messages[2 * i].buf = &registers[i];
+			messages[2 * i + 1].addr = found->second;		// Repeated start, the leg sends the registers
+			messages[2 * i + 1].flags = I2C_M_RD;
+			messages[2 * i + 1].len = reads[i].n;
+			messages[2 * i + 1].buf = reads[i].data;
+		}
+		struct i2c_rdwr_ioctl_data batch;
+		batch.msgs = messages;
+		batch.nmsgs = 2 * count;
+		syscalls++;
+		if (ioctl(reads[0].fd, I2C_RDWR, &batch) >= 0)
+		{
+			for (int i = 0; i < count; i++)
+				reads[i].result = 0;
+			return 0;
+		}
+		return Bus::readBatch(reads, count);			// The transfer stops at the first leg that does not answer, the others are read one by one
+	}
+
+protected:
+	map<int, int> adresses;		// I2C address of every file descriptor made by setup
+	int rdwr;			// 1 if the adapter can do I2C_RDWR, 0 if not, -1 if not asked yet
+
+	// Returns 1 if the adapter can combine transactions with I2C_RDWR. The first call asks the adapter.
+	int combine(int fd)
+	{
+		if (rdwr == -1)
+		{
+			unsigned long funcs = 0;
+			syscalls++;
+			rdwr = (ioctl(fd, I2C_FUNCS, &funcs) >= 0 && (funcs & I2C_FUNC_I2C) != 0) ? 1 : 0;
+			if (rdwr == 0)
+				cout << "\n The I2C adapter can not combine transactions, the legs are written and read one by one \n";
+		}
+		return rdwr;
+	}
+
+	int smbus(int fd, char rw, uint8_t command, int size, union i2c_smbus_data *data)
+	{
+		struct i2c_smbus_ioctl_data args;
+		args.read_write = rw;
+		args.command = command;
+		args.size = size;
+		args.data = data;
+		syscalls++;
+		return ioctl(fd, I2C_SMBUS, &args);
+	}
+};
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The Linux I2C driver. Every leg gets its own file descriptor with its address set, like wiringPiI2CSetup does.
+class LinuxI2CBus : public I2CDevBus
+{
+public:
+	LinuxI2CBus(string device) : device(device) {}
+
+	int setup(int adress)
+	{
+		int fd = open(device.c_str(), O_RDWR);
+		if (fd < 0)
+		{
+			cout << "\n Can not open " << device << "\n";
+			return -1;
+		}
+		if (ioctl(fd, I2C_SLAVE, adress) < 0)
+		{
+			cout << "\n Can not select I2C address " << adress << " on " << device << "\n";
+			close(fd);
+			return -1;
+		}
+		adresses[fd] = adress;
+		return fd;
+	}
+
+	int writeReg8(int fd, int reg, int data)
+	{
+		union i2c_smbus_data value;
+		value.byte = data;
+		return smbus(fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_BYTE_DATA, &value);
+	}
+
+	int readReg8(int fd, int reg)
+	{
+		union i2c_smbus_data value;
+		if (smbus(fd, I2C_SMBUS_READ, reg, I2C_SMBUS_BYTE_DATA, &value) < 0)
+			return -1;
+		return value.byte & 0xFF;
+	}
+
+	int writeBlock(int fd, int reg, const uint8_t *data, int n)
+	{
+		if (n > BUS_BLOCK_MAX)
+			return -1;
+		union i2c_smbus_data value;
+		value.block[0] = n;					// i2c_smbus_write_i2c_block_data: the length, then the data
+		for (int i = 0; i < n; i++)
+			value.block[i + 1] = data[i];
+		return smbus(fd, I2C_SMBUS_WRITE, reg, I2C_SMBUS_I2C_BLOCK_DATA, &value);
+	}
+
+	string name() { return "i2c:" + device; }
+
+private:
+	string device;
+};
+
+#ifdef WIRINGPI
+//-----------------------------------------------------------------------------------------------------------------------------
+// The wiringPi I2C functions, as they were used before the backends existed
+class WiringPiBus : public I2CDevBus
+{
+public:
+	WiringPiBus(string device) : device(device) { wiringPiSetupGpio(); }
+	int setup(int adress)
+	{
+		int fd = (device == "") ? wiringPiI2CSetup(adress) : wiringPiI2CSetupInterface(device.c_str(), adress);
+		if (fd >= 0)
+			adresses[fd] = adress;
+		return fd;
+	}
+	int writeReg8(int fd, int reg, int data) { syscalls++; return wiringPiI2CWriteReg8(fd, reg, data); }
+	int readReg8(int fd, int reg) { syscalls++; return wiringPiI2CReadReg8(fd, reg); }
+	int writeBlock(int fd, int reg, const uint8_t *data, int n)
+	{
+		uint8_t buffer[BUS_BLOCK_MAX + 1];			// wiringPi has no block write, but its handle is a normal /dev/i2c file descriptor
+		if (n > BUS_BLOCK_MAX)
+			return -1;
+		buffer[0] = reg;
+		for (int i = 0; i < n; i++)
+			buffer[i + 1] = data[i];
+		syscalls++;
+		return (::write(fd, buffer, n + 1) == n + 1) ? 0 : -1;
+	}
+	string name() { return (device == "") ? "wiringpi" : "wiringpi:" + device; }
+
+private:
+	string device;			// Empty for the bus of the header pins
+};
+#endif
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes the backend described by *spec*
+Bus *BusOpen(string spec)
+{
+	if (spec.find(',') != string::npos)
+	{
+		vector<Bus *> buses;
+		size_t from = 0;
+		while (from <= spec.size())
+		{
+			size_t to = spec.find(',', from);
+			if (to == string::npos)
+				to = spec.size();
+			Bus *bus = BusOpen(spec.substr(from, to - from));
+			if (bus == NULL)
+				return NULL;
+			buses.push_back(bus);
+			from = to + 1;
+		}
+		if (buses.size() > MULTIBUS_LANES_MAX)
+		{
+			cout << "\n At most " << MULTIBUS_LANES_MAX << " buses \n";
+			return NULL;
+		}
+		return new MultiBus(buses);
+	}
+	string kind = spec.substr(0, spec.find(':'));
+	string option = "";
+	if (spec.find(':') != string::npos)
+		option = spec.substr(spec.find(':') + 1);
+
+	if (kind == "i2c")
+		return new LinuxI2CBus(option == "" ? BUS_DEFAULT_DEVICE : option);
+	if (kind == "sim")
+	{
+		int byteTime = 0;
+		if (option.find(':') != string::npos)
+			byteTime = atoi(option.substr(option.find(':') + 1).c_str());
+		return new SimBus(option == "" ? 0 : atoi(option.c_str()), byteTime);
+	}
+#ifdef WIRINGPI
+	if (kind == "wiringpi")
+		return new WiringPiBus(option);
+#endif
+	cout << "\n Unknown bus " << spec << "\n";
+	return NULL;
+}
+
+static Bus *current = NULL;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Returns the bus used by Communications.cpp, and opens it the first time
+Bus *BusGet()
+{
+	if (current == NULL)
+	{
+		const char *spec = getenv("ZEBRO_BUS");
+#ifdef WIRINGPI
+		if (spec == NULL) spec = "wiringpi";		// Default on the Pi, the same as before the backends existed
+#else
+		if (spec == NULL) spec = "i2c";
+#endif
+		current = BusOpen(spec);
+		if (current == NULL)
+			exit(1);
+		cout << "Bus: " << current->name() << "\n";
+	}
+	return current;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Replaces the bus used by Communications.cpp
+void BusSet(Bus *bus)
+{
+	current = bus;
+}
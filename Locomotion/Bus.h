@@ -0,0 +1,58 @@
+#ifndef BUS_H
+#define BUS_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+using namespace std;
+
+// HEADER FILE FOR THE BUS BACKENDS! See the .cpp file for the extended explanations
+// Only the standard headers are included here, so the program does not depend on wiringPi when another backend is used.
+
+#define BUS_DEFAULT_DEVICE "/dev/i2c-1"	// I2C device of the Pi header pins
+#define BUS_BLOCK_MAX 32		// Most registers one block write can hold (I2C_SMBUS_BLOCK_MAX)
+#define BUS_BATCH_MAX 42		// Most writes one batch can hold (I2C_RDWR_IOCTL_MAX_MSGS)
+
+struct BusWrite
+{
+	int fd;				// Handle of the leg (from setup)
+	int reg;			// First register
+	const uint8_t *data;		// Values of the registers from reg on
+	int n;				// Amount of registers
+	int result;			// 0 if the leg acknowledged, -1 if not (set by writeBatch)
+};
+
+struct BusRead
+{
+	int fd;				// Handle of the leg (from setup)
+	int reg;			// First register
+	uint8_t *data;			// Filled with the values of the registers from reg on
+	int n;				// Amount of registers
+	int result;			// 0 if the leg answered, -1 if not (set by readBatch)
+};
+
+class Bus
+{
+public:
+	Bus() : syscalls(0) {}
+	virtual ~Bus() {}
+	virtual int setup(int adress) = 0;			// Opens the leg at I2C address *adress*, returns the handle used for the other calls (-1 on failure)
+	virtual int setup(int adress, int /* bus */) { return setup(adress); }	// Same, on bus *bus* of a backend with more buses (see MultiBus.cpp), a backend with one bus ignores it
+	virtual int lanes() { return 1; }			// Amount of buses of the backend
+	virtual int writeReg8(int fd, int reg, int data) = 0;	// Writes one register of a leg, returns -1 on failure
+	virtual int readReg8(int fd, int reg) = 0;		// Reads one register of a leg, returns the value or -1 on failure
+	virtual int writeBlock(int fd, int reg, const uint8_t *data, int n);	// Writes n registers starting at reg in one transaction (the leg increments the register itself), returns -1 on failure
+	virtual int writeBatch(BusWrite *writes, int count);		// Does *count* block writes (to different legs) in one transaction with repeated starts, returns -1 if one failed (see the result of every write)
+	virtual int readBlock(int fd, int reg, uint8_t *data, int n);		// Reads n registers starting at reg in one transaction (the leg increments the register itself), returns -1 on failure
+	virtual int readBatch(BusRead *reads, int count);			// Does *count* block reads (from different legs) in one transaction with repeated starts, returns -1 if one failed
+	virtual string name() = 0;				// Name of the backend, for printing
+	long syscalls;						// Amount of kernel calls (or simulated transactions) made for the transactions (benchmark)
+};
+
+Bus *BusOpen(string spec); // Makes the backend described by *spec*: "wiringpi[:device]", "i2c[:device]" or "sim[:latency in us[:us per byte]]", or a comma separated list of these (one per bus). Returns NULL if unknown
+
+Bus *BusGet(); // Returns the bus used by Communications.cpp. The first call opens the backend given by the ZEBRO_BUS environment variable
+
+void BusSet(Bus *bus); // Replaces the bus used by Communications.cpp (the old bus is not deleted)
+
+#endif
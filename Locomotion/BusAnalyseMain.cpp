@@ -0,0 +1,24 @@
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+#include "BusCapture.h"
+using namespace std;
+
+// MAIN FILE OF THE BUS CAPTURE ANALYSER
+// Reads a ring file made with ZEBRO_CAPTURE=<file> ./Walking (see BusCapture.cpp), also on a computer without the robot.
+//
+// ./BusAnalyse <capture file> [timeline.csv]
+// Prints per leg the transactions and commands and how far ahead of their touchdown time the commands arrived, the late commands
+// and the bus utilisation peaks. With a second file every decoded command is written to it (CSV).
+
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		cout << " Usage: ./BusAnalyse <capture file> [timeline.csv] \n";
+		return 1;
+	}
+	return (BusCaptureAnalyse(argv[1], (argc > 2) ? argv[2] : NULL) == 1) ? 0 : 1;
+}
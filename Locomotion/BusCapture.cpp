@@ -0,0 +1,391 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <mutex>
+#include <algorithm>
+#include <time.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "BusCapture.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BUS CAPTURE AND ITS ANALYSER
+// When the timing goes wrong on the robot, the counters of BusStats.cpp tell how much went wrong, but not what went over the bus.
+// With ZEBRO_CAPTURE=<file>[:records] every transaction of Communications.cpp is kept in a ring file: the start time, latency,
+// address, register, length, result and the first 28 data bytes (48 bytes per transaction, 65536 transactions by default). The
+// file is mapped in memory, so a capture is a copy of 48 bytes without a system call, and the file is complete also when the
+// program crashes: the kernel writes the pages back. When the ring is full the oldest transactions are overwritten, so the file
+// always has the last minutes before the problem.
+// Next to the transactions the loop time (the time of the schedule, which the legs are synchronised to) is marked now and then, so
+// the analyser can put the transactions on the time line of the commands.
+//   ./BusAnalyse capture.zbc [timeline.csv]
+// decodes the motion commands (registers 30-37 per leg, the broadcast frame 170-195 whole or per bus, staged commands with their commit) as
+// MotionFrame made them (mode, position = high * 255 + low, see rewritePos, touchdown time = seconds + ms/4, see rewriteTime),
+// prints per leg the commands and how far ahead of their touchdown time they arrived, lists the commands that arrived after it
+// (late), and the 10 ms windows in which a bus was busy for more than 80 % of the time (utilisation peaks).
+
+
+static std::mutex captureLock;
+static int captureFile = -1;
+static BusCaptureHeader *ring = NULL; static BusCaptureRecord *records = NULL; static size_t ringBytes = 0;
+static std::chrono::steady_clock::time_point captureStart;
+static int marked = 0; static double markTime = 0; static double markSteady = 0;	// The last time mark
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes the ring file and maps it
+int BusCaptureStart()
+{
+	const char *spec = getenv("ZEBRO_CAPTURE");
+	if (spec == NULL)
+		return 0;
+	string filename = spec;
+	long capacity = BUSCAPTURE_RECORDS;
+	size_t colon = filename.rfind(':');
+	if (colon != string::npos)
+	{
+		capacity = atol(filename.c_str() + colon + 1);
+		filename = filename.substr(0, colon);
+	}
+	if (capacity < 16)
+		capacity = 16;
+	ringBytes = sizeof(BusCaptureHeader) + capacity * sizeof(BusCaptureRecord);
+	captureFile = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (captureFile < 0 || ftruncate(captureFile, ringBytes) != 0)
+	{
+		cout << "\n Can not make the bus capture file " << filename << " \n";
+		if (captureFile >= 0) {close(captureFile); captureFile = -1;}
+		return 0;
+	}
+	void *mapped = mmap(NULL, ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, captureFile, 0);
+	if (mapped == MAP_FAILED)
+	{
+		cout << "\n Can not map the bus capture file " << filename << " \n";
+		close(captureFile); captureFile = -1;
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(captureLock);
+	ring = (BusCaptureHeader *) mapped;
+	records = (BusCaptureRecord *) ((char *) mapped + sizeof(BusCaptureHeader));
+	memset(ring, 0, sizeof(BusCaptureHeader));
+	memcpy(ring->magic, BUSCAPTURE_MAGIC, strlen(BUSCAPTURE_MAGIC));
+	ring->recordSize = sizeof(BusCaptureRecord);
+	ring->capacity = capacity;
+	captureStart = std::chrono::steady_clock::now();
+	ring->wallStart = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	marked = 0;
+	cout << "\n Bus capture to " << filename << ", the last " << capacity << " transactions (" << ringBytes / 1000 << " kB) \n";
+	return 1;
+}
+
+int BusCaptureActive()
+{
+	return (ring != NULL);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Fills the next record of the ring, the caller holds captureLock. The counter goes up when the record is complete.
+static BusCaptureRecord &nextRecord()
+{
+	BusCaptureRecord &R = records[ring->written % ring->capacity];
+	memset(&R, 0, sizeof(R));
+	return R;
+}
+
+void BusCaptureAdd(std::chrono::steady_clock::time_point start, int adress, int leg, int lane, int reg, const uint8_t *data, int n, int flags, int retries)
+{
+	if (ring == NULL)
+		return;
+	auto now = std::chrono::steady_clock::now();
+	std::lock_guard<std::mutex> guard(captureLock);
+	BusCaptureRecord &R = nextRecord();
+	R.time = (start > captureStart) ? std::chrono::duration_cast<std::chrono::microseconds>(start - captureStart).count() : 0;
+	R.latency = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+	R.adress = adress; R.reg = reg; R.n = n; R.flags = flags;
+	R.leg = leg; R.lane = lane; R.retries = retries;
+	if (data != NULL)
+		memcpy(R.data, data, min(n, BUSCAPTURE_DATA));
+	ring->written++;
+}
+
+// Only writes a mark when the loop time moved away from the steady clock (a schedule move, or the clock of the program without
+// ClockSync) or the last mark is a second old, most loop passes cost nothing
+void BusCaptureMark(double time)
+{
+	if (ring == NULL)
+		return;
+	double steady = std::chrono::duration<double>(std::chrono::steady_clock::now() - captureStart).count();
+	std::lock_guard<std::mutex> guard(captureLock);
+	if (marked == 1 && fabs((time - markTime) - (steady - markSteady)) < BUSCAPTURE_MARK_DRIFT && steady - markSteady < BUSCAPTURE_MARK_EVERY)
+		return;
+	BusCaptureRecord &R = nextRecord();
+	R.time = (uint64_t) (steady * 1e6);
+	R.flags = BUSCAPTURE_MARK; R.n = sizeof(double); R.leg = 7;
+	memcpy(R.data, &time, sizeof(double));
+	ring->written++;
+	marked = 1; markTime = time; markSteady = steady;
+}
+
+void BusCaptureStop()
+{
+	std::lock_guard<std::mutex> guard(captureLock);
+	if (ring == NULL)
+		return;
+	cout << " Bus capture: " << ring->written << " records written \n";
+	munmap(ring, ringBytes);
+	close(captureFile);
+	ring = NULL; records = NULL; captureFile = -1;
+}
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// THE ANALYSER
+static const char *legNames[8] = {"LF", "RF", "LM", "RM", "LH", "RH", "all", "other"};
+
+struct CaptureTarget
+{
+	int leg; int lane;
+	long transactions; long nacks; long retries;
+	long commands; long changed; long late; long timed;	// Commands, the ones that differ from the previous command, arrived late, and with a loop time to check them against
+	double marginMin; double marginSum;
+	uint8_t last[5]; int haveLast;		// Mode, position (2), time (2) of the previous command
+	uint8_t staged[5]; int haveStaged;	// A command without the update register, waiting for its commit
+};
+
+struct CaptureAnalysis
+{
+	CaptureTarget targets[256];		// Per address
+	uint8_t broadcast[256][BUSCAPTURE_FRAME]; uint8_t written[256][BUSCAPTURE_FRAME];	// The broadcast frame per bus, and its registers written since the last update
+	int haveMark; double markTime; double markSteady;
+	FILE *timeline;
+	vector<string> lateLines; long lateTotal;
+};
+
+// The loop time at steady time *steady* (s), from the last mark
+static double loopTime(CaptureAnalysis &A, double steady)
+{
+	return A.markTime + (steady - A.markSteady);
+}
+
+// One command that reached leg *adress*: Frame is mode, position high, position low, touchdown seconds, touchdown ms/4 (MotionFrame)
+static void captureCommand(CaptureAnalysis &A, int adress, const uint8_t Frame[5], int update, const char *source, double arrival)
+{
+	CaptureTarget &T = A.targets[adress];
+	T.commands++;
+	int changed = (T.haveLast == 0 || memcmp(T.last, Frame, 5) != 0);
+	T.changed += changed;
+	memcpy(T.last, Frame, 5); T.haveLast = 1;
+	int position = Frame[1] * 255 + Frame[2];		// rewritePos divides by 255
+	double schedule = -1; double target = -1; double margin = 0; int late = 0;
+	if (A.haveMark == 1)
+	{
+		schedule = loopTime(A, arrival);
+		target = Frame[3] + Frame[4] * 0.004;		// rewriteTime: whole seconds (8 bits) and ms/4
+		target += 256 * floor((schedule - target) / 256 + 0.5);	// The seconds wrap at 256, the command is for the nearest one
+		margin = target - schedule;
+		late = (margin < -BUSCAPTURE_TIME_STEP);
+		T.timed++; T.marginSum += margin;
+		if (T.timed == 1 || margin < T.marginMin) {T.marginMin = margin;}
+	}
+	if (late == 1)
+	{
+		T.late++; A.lateTotal++;
+		if ((int) A.lateLines.size() < BUSCAPTURE_SHOW)
+		{
+			char line[160];
+			snprintf(line, sizeof(line), " %s 0x%02x at %.3f s (loop %.3f s): touchdown %.3f s, %.1f ms late (%s, position %d) \n", legNames[T.leg & 7], adress,
+			         arrival, schedule, target, -margin * 1000, source, position);
+			A.lateLines.push_back(line);
+		}
+	}
+	if (A.timeline != NULL)
+		fprintf(A.timeline, "%.6f,%.6f,%s,0x%02x,%d,%s,%d,%d,%d,%d,%.6f,%.3f,%d\n", arrival, schedule, legNames[T.leg & 7], adress, T.lane, source, update, Frame[0],
+		        position, changed, target, margin * 1000, late);
+}
+
+// Decodes the motion commands in a write that the leg acknowledged
+static void captureWrite(CaptureAnalysis &A, const BusCaptureRecord &R)
+{
+	double arrival = (R.time + R.latency) / 1e6;
+	CaptureTarget &T = A.targets[R.adress];
+	uint8_t Frame[5];
+	if (R.adress != 0 && R.reg == 30 && R.n >= 8)		// Registers 30-37: the command and its update register
+	{
+		captureCommand(A, R.adress, R.data, R.data[7], (R.data[7] == 1) ? "command" : "queued", arrival);
+	}
+	else if (R.adress != 0 && R.reg == 30 && R.n == 7)	// Staged, without the update register
+	{
+		memcpy(T.staged, R.data, 5); T.haveStaged = 1;
+	}
+	else if (R.adress != 0 && R.reg == 37 && R.n == 1 && T.haveStaged == 1)
+	{
+		captureCommand(A, R.adress, T.staged, R.data[0], "staged", arrival);
+		T.haveStaged = 0;
+	}
+	else if (R.adress == 0 && R.reg >= 170 && R.reg + R.n <= 170 + BUSCAPTURE_FRAME && R.n > 0)	// The broadcast frame: the mode and a slice of 4 bytes per even position
+	{
+		uint8_t *B = A.broadcast[R.lane]; uint8_t *W = A.written[R.lane];
+		memcpy(&B[R.reg - 170], R.data, R.n); memset(&W[R.reg - 170], 1, R.n);
+		if (R.reg + R.n < 170 + BUSCAPTURE_FRAME || W[0] == 0)
+			return;						// The legs take the frame on the update register (195)
+		int slices = 0;
+		for (int s = 0; s < 6; s++)
+			slices += (W[1 + 4 * s] & W[2 + 4 * s] & W[3 + 4 * s] & W[4 + 4 * s]);
+		const char *source = (R.n == BUSCAPTURE_FRAME) ? "broadcast" : (slices == 6) ? "broadcast staged" : "broadcast part";
+		for (int s = 0; s < 6; s++)
+		{
+			if ((W[1 + 4 * s] & W[2 + 4 * s] & W[3 + 4 * s] & W[4 + 4 * s]) == 0)
+				continue;				// The leg of this slice is on another bus
+			Frame[0] = B[0]; memcpy(&Frame[1], &B[1 + 4 * s], 4);
+			captureCommand(A, 0x10 + 2 * s, Frame, B[BUSCAPTURE_FRAME - 1], source, arrival);
+		}
+		memset(W, 0, BUSCAPTURE_FRAME);
+	}
+}
+
+// Adds the busy time [from, to) (s) to the windows of a bus
+static void captureBusy(vector<double> &windows, double from, double to)
+{
+	for (size_t w = (size_t) (from / BUSCAPTURE_WINDOW); from < to && w < windows.size(); w++)
+	{
+		double end = min(to, (w + 1) * BUSCAPTURE_WINDOW);
+		if (end > from)
+			windows[w] += end - from;
+		from = max(from, end);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads the ring from the oldest record to the newest, decodes the commands and adds up the bus time
+int BusCaptureAnalyse(const char *filename, const char *timeline)
+{
+	FILE *file = fopen(filename, "rb");
+	BusCaptureHeader H;
+	if (file == NULL || fread(&H, sizeof(H), 1, file) != 1 || memcmp(H.magic, BUSCAPTURE_MAGIC, strlen(BUSCAPTURE_MAGIC)) != 0 || H.recordSize != sizeof(BusCaptureRecord))
+	{
+		cout << " " << filename << " is not a bus capture \n";
+		if (file != NULL) {fclose(file);}
+		return 0;
+	}
+	vector<BusCaptureRecord> ring(H.capacity);
+	size_t stored = fread(ring.data(), sizeof(BusCaptureRecord), H.capacity, file);
+	fclose(file);
+	uint64_t count = min((uint64_t) stored, H.written);
+	uint64_t first = (H.written > H.capacity) ? H.written % H.capacity : 0;
+	if (count == 0)
+	{
+		cout << " " << filename << " has no transactions \n";
+		return 1;
+	}
+
+	CaptureAnalysis *A = new CaptureAnalysis();		// Too big for the stack
+	for (int a = 0; a < 256; a++)
+	{
+		CaptureTarget &T = A->targets[a];
+		T.leg = 7; T.lane = 0; T.transactions = 0; T.nacks = 0; T.retries = 0;
+		T.commands = 0; T.changed = 0; T.late = 0; T.timed = 0; T.marginMin = 0; T.marginSum = 0; T.haveLast = 0; T.haveStaged = 0;
+	}
+	memset(A->written, 0, sizeof(A->written)); A->haveMark = 0; A->markTime = 0; A->markSteady = 0; A->lateTotal = 0;
+	A->timeline = NULL;
+	if (timeline != NULL)
+	{
+		A->timeline = fopen(timeline, "w");
+		if (A->timeline == NULL) {cout << " Can not write " << timeline << " \n";}
+		else {fprintf(A->timeline, "time,loop,leg,adress,bus,source,update,mode,position,changed,touchdown,margin_ms,late\n");}
+	}
+
+	int lanes = 1; double begin = ring[first].time / 1e6; double end = begin;	// First pass: the buses and the time span
+	for (uint64_t k = 0; k < count; k++)
+	{
+		const BusCaptureRecord &R = ring[(first + k) % H.capacity];
+		if ((R.flags & BUSCAPTURE_MARK) == 0 && R.lane != BUSCAPTURE_ALL_LANES && R.lane + 1 > lanes) {lanes = R.lane + 1;}
+		if ((R.flags & BUSCAPTURE_MARK) == 0) {A->targets[R.adress].leg = R.leg; A->targets[R.adress].lane = (R.adress == 0) ? BUSCAPTURE_ALL_LANES : R.lane;}
+		end = max(end, (R.time + R.latency) / 1e6);
+	}
+	vector<vector<double> > busy(lanes, vector<double>((size_t) ((end - begin) / BUSCAPTURE_WINDOW) + 1, 0));
+
+	long transactions = 0; long marks = 0;
+	int groupLanes = 0; double groupFrom = 0; double groupTo = 0;		// The batch so far, a batch takes the bus once
+	for (uint64_t k = 0; k <= count; k++)
+	{
+		int last = (k == count);
+		const BusCaptureRecord &R = ring[(first + (last ? 0 : k)) % H.capacity];
+		if (last == 0 && (R.flags & BUSCAPTURE_MARK) != 0)
+		{
+			memcpy(&A->markTime, R.data, sizeof(double));
+			A->markSteady = R.time / 1e6; A->haveMark = 1; marks++;
+			continue;
+		}
+		if (last == 1 || (R.flags & BUSCAPTURE_FIRST) != 0)
+		{
+			for (int l = 0; l < lanes; l++)
+			{
+				if ((groupLanes >> l) & 1) {captureBusy(busy[l], groupFrom - begin, groupTo - begin);}
+			}
+			if (last == 1) {break;}
+			groupLanes = 0; groupFrom = R.time / 1e6; groupTo = (R.time + R.latency) / 1e6;
+		}
+		groupLanes |= (R.lane == BUSCAPTURE_ALL_LANES) ? (1 << lanes) - 1 : (1 << R.lane);
+		transactions++;
+		CaptureTarget &T = A->targets[R.adress];
+		T.transactions++; T.retries += R.retries;
+		T.nacks += ((R.flags & BUSCAPTURE_NACK) != 0);
+		if ((R.flags & (BUSCAPTURE_READ | BUSCAPTURE_NACK)) == 0)
+			captureWrite(*A, R);
+	}
+
+	time_t wall = H.wallStart / 1000000;
+	printf("\n Bus capture %s: %ld transactions in %.3f s", filename, transactions, end - begin);
+	if (H.written > H.capacity)
+		printf(" (the oldest %llu records were overwritten)", (unsigned long long) (H.written - H.capacity));
+	printf(", started %s", ctime(&wall));
+	if (A->haveMark == 0)
+		cout << " No loop time marks: the commands can not be compared with their touchdown times \n";
+
+	cout << "\n Per leg (transactions, NACKs, retries, commands, changed commands, late, margin before the touchdown min/mean): \n";
+	for (int a = 0; a < 256; a++)
+	{
+		CaptureTarget &T = A->targets[a];
+		if (T.transactions == 0 && T.commands == 0)
+			continue;
+		printf(" %-5s 0x%02x bus %s: %ld, %ld, %ld, %ld, %ld, %ld", legNames[T.leg & 7], a, (T.lane == BUSCAPTURE_ALL_LANES) ? "all" : to_string(T.lane).c_str(),
+		       T.transactions, T.nacks, T.retries, T.commands, T.changed, T.late);
+		if (T.timed > 0)
+			printf(", %.1f/%.1f ms", T.marginMin * 1000, T.marginSum / T.timed * 1000);
+		printf(" \n");
+	}
+
+	cout << "\n Late commands: " << A->lateTotal << " \n";
+	for (size_t i = 0; i < A->lateLines.size(); i++)
+		cout << A->lateLines[i];
+
+	printf("\n Bus utilisation per %.0f ms window (above %.0f %% is a peak): \n", BUSCAPTURE_WINDOW * 1000, BUSCAPTURE_PEAK * 100);
+	for (int l = 0; l < lanes; l++)
+	{
+		double total = 0; double peak = 0; vector<pair<double, size_t> > peaks;
+		for (size_t w = 0; w < busy[l].size(); w++)
+		{
+			total += busy[l][w];
+			peak = max(peak, busy[l][w]);
+			if (busy[l][w] > BUSCAPTURE_PEAK * BUSCAPTURE_WINDOW) {peaks.push_back(make_pair(busy[l][w], w));}
+		}
+		printf(" bus %d: %.1f %% on average, %.1f %% in the busiest window, %zu peaks", l, 100 * total / max(end - begin, BUSCAPTURE_WINDOW),
+		       100 * peak / BUSCAPTURE_WINDOW, peaks.size());
+		sort(peaks.begin(), peaks.end(), [](const pair<double, size_t> &a, const pair<double, size_t> &b) { return (a.first != b.first) ? a.first > b.first : a.second < b.second; });
+		for (size_t p = 0; p < peaks.size() && p < BUSCAPTURE_SHOW; p++)
+			printf("%s %.2f s %.0f %%", (p == 0) ? ":" : ",", begin + peaks[p].second * BUSCAPTURE_WINDOW, 100 * peaks[p].first / BUSCAPTURE_WINDOW);
+		printf(" \n");
+	}
+	if (A->timeline != NULL)
+	{
+		fclose(A->timeline);
+		cout << "\n Every command written to " << timeline << " \n";
+	}
+	delete A;
+	return 1;
+}
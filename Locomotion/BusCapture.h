@@ -0,0 +1,60 @@
+#ifndef BUSCAPTURE_H
+#define BUSCAPTURE_H
+
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+// HEADER FILE FOR THE BUS CAPTURE! See the .cpp file for the extended explanations
+
+#define BUSCAPTURE_MAGIC "ZBCAP1"	// First bytes of a capture file
+#define BUSCAPTURE_RECORDS 65536	// Transactions the ring holds when ZEBRO_CAPTURE does not say (3 MB)
+#define BUSCAPTURE_DATA 28		// Data bytes kept per transaction, enough for the broadcast frame (170-195)
+#define BUSCAPTURE_MARK_DRIFT 0.001	// A new time mark is written when the loop time moved this much (s) from the steady clock
+#define BUSCAPTURE_MARK_EVERY 1.0	// and at least this often (s)
+#define BUSCAPTURE_WINDOW 0.01		// Window (s) of the bus utilisation in the analyser, one loop pass
+#define BUSCAPTURE_PEAK 0.8		// A window busier than this is a utilisation peak
+#define BUSCAPTURE_TIME_STEP 0.004	// The touchdown time in a motion frame is in steps of 4 ms (rewriteTime), a command is late when it arrives more than a step after it
+#define BUSCAPTURE_SHOW 10		// Late commands and peaks that are printed in full
+
+#define BUSCAPTURE_READ 0x01		// Flags of a record: a read (otherwise a write)
+#define BUSCAPTURE_NACK 0x02		// not acknowledged, also after the retries
+#define BUSCAPTURE_FIRST 0x04		// first transaction of a batch (a single transaction is a batch of one)
+#define BUSCAPTURE_MARK 0x08		// no transaction: the loop time at this moment (a double in data)
+#define BUSCAPTURE_ALL_LANES 0xFF	// Lane of the broadcast address, it goes over every bus
+#define BUSCAPTURE_FRAME 26		// The broadcast frame, registers 170-195 (BROADCAST_FRAME_SIZE of Communications.h)
+
+struct BusCaptureHeader
+{
+	char magic[8];
+	uint32_t recordSize;		// sizeof(BusCaptureRecord)
+	uint32_t capacity;		// Records in the ring
+	uint64_t written;		// Records written since the start, the next one goes to written % capacity
+	int64_t wallStart;		// Wall clock at time 0 of the records (us since 1970)
+	uint8_t spare[32];
+};
+
+struct BusCaptureRecord
+{
+	uint64_t time;			// Start of the transaction (us since the capture started)
+	uint32_t latency;		// Time of the transaction or the whole batch, retries included (us)
+	uint8_t adress; uint8_t reg; uint8_t n; uint8_t flags;	// n is the length of the transaction, only BUSCAPTURE_DATA bytes of it are kept
+	uint8_t leg;			// 0-5, 6 = all legs, 7 = other address (as in BusStats.cpp)
+	uint8_t lane;			// Bus (MultiBus.cpp), BUSCAPTURE_ALL_LANES for the broadcast address
+	uint8_t retries; uint8_t spare;
+	uint8_t data[BUSCAPTURE_DATA];
+};
+
+int BusCaptureStart(); // Starts capturing to the ring file of ZEBRO_CAPTURE=<file>[:records]. Returns 0 if it is not set or the file can not be made
+
+int BusCaptureActive(); // 1 while capturing
+
+void BusCaptureAdd(std::chrono::steady_clock::time_point start, int adress, int leg, int lane, int reg, const uint8_t *data, int n, int flags, int retries); // Captures one transaction that started at *start* and ended now
+
+void BusCaptureMark(double time); // Captures the loop time (the time of the schedule) when it moved away from the steady clock, so the analyser can compare with the command times
+
+void BusCaptureStop(); // Unmaps and closes the file
+
+int BusCaptureAnalyse(const char *filename, const char *timeline); // Prints the command timeline summary per leg, the late commands and the utilisation peaks. Writes every command to *timeline* (CSV) if not NULL. Returns 0 if the file can not be read
+
+#endif
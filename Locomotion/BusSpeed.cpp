@@ -0,0 +1,215 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Bus.h"
+#include "SimBus.h"
+#include "BusSpeed.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BUS SPEED PRESETS
+// The legs used to run the ZebroBus with one fixed timing (TIMINGR 0x0070D8FF), made for 100 kHz. The firmware now has three presets:
+// standard (100 kHz, the old timing), fast mode (400 kHz) and fast mode plus (1 MHz). A leg keeps its preset in flash and takes it
+// when it starts, so changing it is: write the preset to register 8 of every leg, reboot them (register 9), and set the host bus to
+// the same rate. The host can not set the rate of its own bus: on the Pi that is dtparam=i2c_arm_baudrate in /boot/config.txt.
+// ZEBRO_BUSSPEED tells the program what the host bus runs at, so it can check that the legs match (BusSpeedCheck).
+//   ./Walking busspeed 400      stores the 400 kHz preset in all legs and reboots them
+//   ./Walking busstress [s]     streams motion frames and telemetry reads and prints the error rates
+// The stress test writes the motion registers 30-36 without the update register (37), so the legs never take these commands and it
+// can run on a robot that stands still. Every transaction is counted as it comes from the bus, without the retries of
+// Communications.cpp: a failed transaction is one the leg did not acknowledge, a corrupted one is a read of the identity registers
+// (1-7, they never change) that differs from the first read, and the leg counts the bus errors and overruns it saw (register 14).
+// On simulated legs the test runs at all three rates (only the byte time changes, the simulated bus makes no errors).
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+int BusSpeedPreset(int kHz)
+{
+	if (kHz == 100) {return 0;}
+	if (kHz == 400) {return 1;}
+	if (kHz == 1000) {return 2;}
+	return -1;
+}
+
+int BusSpeedHost()
+{
+	const char *speed = getenv("ZEBRO_BUSSPEED");
+	return (speed == NULL) ? 100 : atoi(speed);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Stores the preset in every leg, reboots all legs at once and reads the preset they run at
+int BusSpeedProgram(const vector<int> &ard, int kHz)
+{
+	int preset = BusSpeedPreset(kHz);
+	if (preset < 0)
+	{
+		cout << "\n There is no preset for " << kHz << " kHz, only 100, 400 and 1000 \n";
+		return 0;
+	}
+	for (int i=0;i<6;i++)
+	{
+		i2cWrite(ard[i],BUSSPEED_REG,preset);
+	}
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));	// Writing the flash page stops the leg for up to 40 ms
+	for (int i=0;i<6;i++)
+	{
+		int value = i2cRead(ard[i],BUSSPEED_REG);
+		if (value < 0 || (value >> 4) != preset)
+			cout << "\n Leg " << i << " did not store the preset";
+	}
+	i2cWrite(ard[6],BUSSPEED_REBOOT_REG,BUSSPEED_REBOOT_KEY);
+	std::this_thread::sleep_for(std::chrono::milliseconds(BUSSPEED_BOOT_MS));
+	int running = 0;
+	cout << "\n Bus speed preset per leg after the reboot:";
+	for (int i=0;i<6;i++)
+	{
+		int value = i2cRead(ard[i],BUSSPEED_REG);
+		cout << " " << ((value < 0) ? -1 : (value & 0x0F));
+		running += (value >= 0 && (value & 0x0F) == preset);
+	}
+	cout << " (" << running << " of 6 legs at " << kHz << " kHz) \n";
+	cout << " Set the host bus to the same rate: dtparam=i2c_arm_baudrate=" << kHz * 1000 << " in /boot/config.txt (and reboot the Pi),"
+	     << " and run with ZEBRO_BUSSPEED=" << kHz << " \n";
+	return running;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads the preset of all legs in one batch and compares it with the rate of the host
+int BusSpeedCheck(const vector<int> &ard)
+{
+	int preset = BusSpeedPreset(BusSpeedHost());
+	uint8_t Data[6]; BusRead Reads[6];
+	for (int i=0;i<6;i++)
+	{
+		Reads[i].fd = ard[i]; Reads[i].reg = BUSSPEED_REG; Reads[i].data = &Data[i]; Reads[i].n = 1;
+	}
+	i2cReadBatch(Reads,6);
+	int match = 0;
+	for (int i=0;i<6;i++)
+	{
+		if (Reads[i].result == 0 && (Data[i] & 0x0F) == preset)
+		{
+			match++;
+			continue;
+		}
+		cout << "\n Leg " << i << " does not run at the " << BusSpeedHost() << " kHz of ZEBRO_BUSSPEED";
+		if (Reads[i].result == 0)
+			cout << " (preset " << (Data[i] & 0x0F) << ", ./Walking busspeed " << BusSpeedHost() << " sets it)";
+	}
+	if (match < 6){cout << "\n";}
+	return match;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Streams for *seconds* on the bus of BusGet and prints one line with the error rates. Straight on the bus, without the retries.
+static void stressRun(const vector<int> &ard, double seconds, int kHz)
+{
+	Bus *bus = BusGet();
+	uint8_t Identity[6][BUSSPEED_IDENTITY_SIZE]; uint8_t Check[6][BUSSPEED_IDENTITY_SIZE];
+	uint8_t Telemetry[6][TELEMETRY_SIZE]; uint8_t Frames[6][8];
+	int Errors[6];
+	BusWrite Writes[6]; BusRead Reads[6];
+	long transactions = 0; long failed = 0; long corrupt = 0; long bytes = 0;
+
+	for (int i=0;i<6;i++)
+	{
+		Errors[i] = bus->readReg8(ard[i],BUSSPEED_ERRORS_REG);
+		Reads[i].fd = ard[i]; Reads[i].reg = BUSSPEED_IDENTITY_REG; Reads[i].data = Identity[i]; Reads[i].n = BUSSPEED_IDENTITY_SIZE;
+	}
+	bus->readBatch(Reads,6);
+	int known[6];
+	for (int i=0;i<6;i++){known[i] = (Reads[i].result == 0);}
+
+	auto start = std::chrono::steady_clock::now();
+	double elapsed = 0;
+	for (long pass = 0; elapsed < seconds; pass++)
+	{
+		for (int i=0;i<6;i++)
+		{
+			float Vec[3] = {(float) ((pass*37 + i*151) % 910), (float) (pass % 2560) * 0.1f, 1};
+			MotionFrame(Vec,Frames[i]);
+			Writes[i].fd = ard[i]; Writes[i].reg = 30; Writes[i].data = Frames[i]; Writes[i].n = 7;	// Registers 30-36, never 37
+		}
+		bus->writeBatch(Writes,6);
+		for (int i=0;i<6;i++)
+		{
+			failed += (Writes[i].result < 0);
+			Reads[i].fd = ard[i]; Reads[i].reg = TELEMETRY_REG; Reads[i].data = Telemetry[i]; Reads[i].n = TELEMETRY_SIZE;
+		}
+		bus->readBatch(Reads,6);
+		for (int i=0;i<6;i++){failed += (Reads[i].result < 0);}
+		transactions += 12; bytes += 6*(2+7) + 6*(3+TELEMETRY_SIZE);
+
+		if (pass % 8 == 0)
+		{
+			for (int i=0;i<6;i++)
+			{
+				Reads[i].fd = ard[i]; Reads[i].reg = BUSSPEED_IDENTITY_REG; Reads[i].data = Check[i]; Reads[i].n = BUSSPEED_IDENTITY_SIZE;
+			}
+			bus->readBatch(Reads,6);
+			for (int i=0;i<6;i++)
+			{
+				failed += (Reads[i].result < 0);
+				corrupt += (Reads[i].result == 0 && known[i] == 1 && memcmp(Check[i],Identity[i],BUSSPEED_IDENTITY_SIZE) != 0);
+			}
+			transactions += 6; bytes += 6*(3+BUSSPEED_IDENTITY_SIZE);
+		}
+		elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	memset(Frames,0,sizeof(Frames));				// Leaves the motion registers as a leg has them after an update
+	int legErrors = 0;
+	for (int i=0;i<6;i++)
+	{
+		bus->writeBlock(ard[i],30,Frames[i],7);
+		int after = bus->readReg8(ard[i],BUSSPEED_ERRORS_REG);
+		if (after >= 0 && Errors[i] >= 0){legErrors += (after - Errors[i] + 256) % 256;}
+	}
+	printf(" %4d kHz: %ld transactions, %.1f kB/s, %ld failed (%.4f %%), %ld corrupted reads, %d bus errors on the legs \n", kHz, transactions,
+	       bytes / elapsed / 1000, failed, transactions > 0 ? 100.0 * failed / transactions : 0.0, corrupt, legErrors);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// On simulated legs every rate gets its own simulated bus, otherwise the test runs at the rate of ZEBRO_BUSSPEED
+void BusStress(double seconds)
+{
+	cout << "\n Bus stress test, " << seconds << " s per rate: staged motion frames (30-36) and telemetry reads (110-113) to six legs \n";
+	if (BusGet()->name().compare(0,3,"sim") != 0)
+	{
+		vector<int> ard = connectLegs();
+		BusSpeedCheck(ard);
+		stressRun(ard, seconds, BusSpeedHost());
+		return;
+	}
+	const int Rates[3] = {100, 400, 1000};
+	for (int r=0;r<3;r++)
+	{
+		SimBus *sim = new SimBus(BUSSPEED_SIM_LATENCY, 9000 / Rates[r]);
+		BusSet(sim);
+		vector<int> ard = connectLegs();
+		for (int i=0;i<6;i++){i2cWrite(ard[i],BUSSPEED_REG,BusSpeedPreset(Rates[r]));}
+		i2cWrite(ard[6],BUSSPEED_REBOOT_REG,BUSSPEED_REBOOT_KEY);
+		stressRun(ard, seconds, Rates[r]);
+		BusSet(NULL);
+		delete sim;
+	}
+}
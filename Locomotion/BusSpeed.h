@@ -0,0 +1,28 @@
+#ifndef BUSSPEED_H
+#define BUSSPEED_H
+
+#include <vector>
+using namespace std;
+
+// HEADER FILE FOR THE BUS SPEED PRESETS! See the .cpp file for the extended explanations
+
+#define BUSSPEED_REG 8			// VREGS_ZEBROBUS_SPEED of the leg firmware: active preset (low nibble), stored for the next boot (high nibble)
+#define BUSSPEED_REBOOT_REG 9		// VREGS_ZEBROBUS_REBOOT: BUSSPEED_REBOOT_KEY restarts the leg
+#define BUSSPEED_REBOOT_KEY 0xB0	// ZEBROBUS_REBOOT_KEY
+#define BUSSPEED_ERRORS_REG 14		// VREGS_ZEBROBUS_ERRORS: bus errors and overruns the leg saw (wraps at 255)
+#define BUSSPEED_BOOT_MS 500		// Time a leg needs to start again after the reboot
+#define BUSSPEED_IDENTITY_REG 1		// Product id up to the leg address (1-7): never changes, so a read that differs was corrupted
+#define BUSSPEED_IDENTITY_SIZE 7
+#define BUSSPEED_SIM_LATENCY 50		// Simulated bus of the stress test: 50 us per transaction plus 9 bits per byte at the rate
+
+int BusSpeedPreset(int kHz); // The preset of 100, 400 or 1000 kHz (0, 1, 2), -1 for any other rate
+
+int BusSpeedHost(); // The rate the host bus runs at in kHz: ZEBRO_BUSSPEED, 100 if not set
+
+int BusSpeedProgram(const vector<int> &ard, int kHz); // Stores the preset of *kHz* in all legs, reboots them and checks them. Returns the amount of legs that run at it
+
+int BusSpeedCheck(const vector<int> &ard); // Warns about the legs whose preset differs from ZEBRO_BUSSPEED. Returns the amount of legs that match
+
+void BusStress(double seconds); // Streams staged motion frames and telemetry reads for *seconds* and prints the error rates (on simulated legs at 100, 400 and 1000 kHz)
+
+#endif
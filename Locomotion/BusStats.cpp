@@ -0,0 +1,190 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <signal.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "BusStats.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BUS TRANSACTION STATISTICS
+// Every transaction of Communications.cpp is counted here, per leg and per register range: the amount of transactions, the bytes,
+// the transactions the leg did not acknowledge (NACK) after all retries, the retries, and a histogram of the latency (the time of
+// the transaction including its retries). A batch counts once for every leg in it, with the latency of the whole batch.
+// A transaction that is not acknowledged is tried again at most BUS_RETRIES times, waiting BUS_BACKOFF us before the first retry
+// and twice as long before every next one, so a leg that is busy for a moment (or a disturbance on the bus) does not lose a
+// command, while a leg that is gone costs at most 0.7 ms of waiting. The retries wait with busLock held, so all waiting together is
+// limited to BUS_BACKOFF_BUDGET us within BUS_BACKOFF_WINDOW (one loop pass): a few legs that are gone do not keep the loop and the
+// priority commands from the bus for longer than that.
+// Press t (or send SIGUSR1) to print the counters and write them to busstats.csv (ZEBRO_BUSSTATS=<file> for another file):
+//   leg,first,last,range,ops,bytes,nacks,retries,lt50us,lt100us,lt200us,lt500us,lt1ms,lt2ms,lt5ms,lt10ms,ge10ms
+
+
+struct BusRange
+{
+	int first; int last;		// Registers
+	const char *name;
+};
+
+static const BusRange ranges[BUSSTATS_RANGES] = {
+	{0, 29, "status"},		// Identification, sync counter, errors
+	{30, 39, "motion"},		// Motion command (30-37)
+	{40, 109, "config"},
+	{110, 169, "telemetry"},	// Encoder position, direction, FSM flag (110-113)
+	{170, 199, "broadcast"},	// Broadcast schedule frame (170-195)
+	{200, 255, "other"}
+};
+static const char *legNames[BUSSTATS_LEGS] = {"LF", "RF", "LM", "RM", "LH", "RH", "all", "other"};
+static const int bucketLimits[BUSSTATS_BUCKETS - 1] = {50, 100, 200, 500, 1000, 2000, 5000, 10000};	// us
+
+static BusCounter counters[BUSSTATS_LEGS][BUSSTATS_RANGES];
+static std::mutex statsLock;
+static std::chrono::steady_clock::time_point backoffWindow;	// Start of the current backoff window
+static long backoffSpent = 0;					// Waiting for retries in that window (us)
+static long backoffRefused = 0;					// Retries that were not done because the budget was used
+static volatile sig_atomic_t requested = 0;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Counts one transaction
+void BusStatsAdd(int leg, int reg, int bytes, int result, int retries, double latency)
+{
+	int range = 0;
+	while (range < BUSSTATS_RANGES - 1 && reg > ranges[range].last)
+		range++;
+	if (leg < 0 || leg >= BUSSTATS_LEGS)
+		leg = BUSSTATS_LEGS - 1;
+	int bucket = 0;
+	while (bucket < BUSSTATS_BUCKETS - 1 && latency * 1e6 >= bucketLimits[bucket])
+		bucket++;
+	std::lock_guard<std::mutex> guard(statsLock);
+	BusCounter &C = counters[leg][range];
+	C.ops++;
+	C.bytes += bytes;
+	C.nacks += (result < 0);
+	C.retries += retries;
+	C.histogram[bucket]++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Waits BUS_BACKOFF us before the first retry, twice as long before the second and so on, as long as the budget of the window allows it
+int BusStatsRetry(int &tries)
+{
+	if (tries >= BUS_RETRIES)
+		return 0;
+	long wait = BUS_BACKOFF << tries;
+	{
+		std::lock_guard<std::mutex> guard(statsLock);
+		auto now = std::chrono::steady_clock::now();
+		if (std::chrono::duration_cast<std::chrono::microseconds>(now - backoffWindow).count() >= BUS_BACKOFF_WINDOW)
+		{
+			backoffWindow = now;
+			backoffSpent = 0;
+		}
+		if (backoffSpent + wait > BUS_BACKOFF_BUDGET)
+		{
+			backoffRefused++;
+			return 0;
+		}
+		backoffSpent += wait;
+	}
+	std::this_thread::sleep_for(std::chrono::microseconds(wait));
+	tries++;
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints a line for every leg and register range that had transactions
+void BusStatsPrint()
+{
+	std::lock_guard<std::mutex> guard(statsLock);
+	cout << "\n Bus transactions (leg range: ops, bytes, NACKs, retries, latency histogram <50us <100us <200us <500us <1ms <2ms <5ms <10ms >=10ms), "
+	     << backoffRefused << " retries left out (backoff budget) \n";
+	for (int leg = 0; leg < BUSSTATS_LEGS; leg++)
+	{
+		for (int range = 0; range < BUSSTATS_RANGES; range++)
+		{
+			BusCounter &C = counters[leg][range];
+			if (C.ops == 0)
+				continue;
+			cout << " " << legNames[leg] << " " << ranges[range].name << ": " << C.ops << ", " << C.bytes << ", " << C.nacks << ", " << C.retries << ",";
+			for (int b = 0; b < BUSSTATS_BUCKETS; b++)
+				cout << " " << C.histogram[b];
+			cout << " \n";
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Writes all counters as CSV
+int BusStatsWrite(const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (file == NULL)
+		return 0;
+	std::lock_guard<std::mutex> guard(statsLock);
+	fprintf(file, "leg,first,last,range,ops,bytes,nacks,retries,lt50us,lt100us,lt200us,lt500us,lt1ms,lt2ms,lt5ms,lt10ms,ge10ms\n");
+	for (int leg = 0; leg < BUSSTATS_LEGS; leg++)
+	{
+		for (int range = 0; range < BUSSTATS_RANGES; range++)
+		{
+			BusCounter &C = counters[leg][range];
+			fprintf(file, "%s,%d,%d,%s,%ld,%ld,%ld,%ld", legNames[leg], ranges[range].first, ranges[range].last, ranges[range].name, C.ops, C.bytes, C.nacks, C.retries);
+			for (int b = 0; b < BUSSTATS_BUCKETS; b++)
+				fprintf(file, ",%ld", C.histogram[b]);
+			fprintf(file, "\n");
+		}
+	}
+	fclose(file);
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the counters and writes the file
+void BusStatsDump()
+{
+	const char *filename = getenv("ZEBRO_BUSSTATS");
+	if (filename == NULL)
+		filename = BUSSTATS_FILE;
+	BusStatsPrint();
+	if (BusStatsWrite(filename) == 1)
+		cout << " Written to " << filename << " \n";
+	else
+		cout << " Can not write " << filename << " \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// SIGUSR1 only sets a flag, the loop does the dump (printing and files are not allowed in a signal handler)
+static void onSignal(int)
+{
+	requested = 1;
+}
+
+void BusStatsSignal()
+{
+	signal(SIGUSR1, onSignal);
+}
+
+int BusStatsRequested()
+{
+	if (requested == 0)
+		return 0;
+	requested = 0;
+	return 1;
+}
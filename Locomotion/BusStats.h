@@ -0,0 +1,42 @@
+#ifndef BUSSTATS_H
+#define BUSSTATS_H
+
+#include <vector>
+using namespace std;
+
+// HEADER FILE FOR THE BUS TRANSACTION STATISTICS! See the .cpp file for the extended explanations
+
+#define BUSSTATS_LEGS 8			// Leg 0-5 (the order of ard), all legs (address 0x00) and any other address
+#define BUSSTATS_RANGES 6		// Register ranges, see the table in BusStats.cpp
+#define BUSSTATS_BUCKETS 9		// Latency histogram: < 50, 100, 200, 500, 1000, 2000, 5000, 10000 us and longer
+#define BUSSTATS_FILE "busstats.csv"	// File written by BusStatsDump (ZEBRO_BUSSTATS=<file> to change)
+
+#define BUS_RETRIES 3			// A transaction that was not acknowledged is tried at most this many times more
+#define BUS_BACKOFF 100			// Wait before the first retry (us), doubled for every next retry
+#define BUS_BACKOFF_WINDOW 10000	// The retries are done with busLock held, so their waiting is limited per window of this long (us, one loop pass)
+#define BUS_BACKOFF_BUDGET 1500		// Waiting for retries allowed within one window (us), after that a failed transaction is not tried again
+
+struct BusCounter
+{
+	long ops;			// Transactions (a batch counts once for every leg in it)
+	long bytes;			// Bytes on the bus (address, register and data)
+	long nacks;			// Transactions that still failed after the retries
+	long retries;			// Retries done
+	long histogram[BUSSTATS_BUCKETS];	// Latency of the transactions, including the retries
+};
+
+void BusStatsAdd(int leg, int reg, int bytes, int result, int retries, double latency); // Counts one transaction of leg (0-7) from register reg on
+
+int BusStatsRetry(int &tries); // Waits before the next retry and returns 1, or returns 0 when BUS_RETRIES retries were done or the backoff budget is used
+
+void BusStatsPrint(); // Prints the counters per leg and register range
+
+int BusStatsWrite(const char *filename); // Writes the counters as CSV, one line per leg and register range. Returns 0 if the file can not be written
+
+void BusStatsDump(); // Prints the counters and writes them to ZEBRO_BUSSTATS (or BUSSTATS_FILE)
+
+void BusStatsSignal(); // Makes SIGUSR1 ask for a dump (kill -USR1 <pid>)
+
+int BusStatsRequested(); // Returns 1 once after every SIGUSR1
+
+#endif
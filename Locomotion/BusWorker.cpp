@@ -0,0 +1,284 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "BusWorker.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BUS WORKER
+// Sending the stride commands takes as long as the bus does (several ms at 100 kHz), and the loop used to wait for it. When the loop
+// plans a newer command for a leg before the previous one was on the bus, both were sent, the old one first. The worker thread
+// sends the commands instead:
+//  - every leg has a mailbox with room for one command. BusWorkerPost puts the newest command in it; a command that was not sent
+//    yet is replaced (coalesced), because the legs only need to know the newest one.
+//  - the worker takes everything that is in the mailboxes and sends it with SendFrames (one broadcast frame or one batch).
+// So the bus never has more than one command per leg waiting, whatever the rate of the loop, and the loop never waits for the bus.
+// Priority commands (stop, panic stop 255, reset, see SpecOps) do not go through the mailboxes: they throw the waiting commands
+// away (dropped) and wait until the send the worker is doing has stopped, then go to the bus.
+// When recording or replaying, the commands are sent directly, so the bus traffic stays in the order of the loop.
+
+
+static BusWorker *current = NULL;
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The worker thread: waits for commands, takes them out of the mailboxes and sends them
+static void work(BusWorker *B)
+{
+	uint8_t Frames[6][8];
+	int Legs[6];
+	while (1 == 1)
+	{
+		std::chrono::steady_clock::time_point oldest;
+		{
+			std::unique_lock<std::mutex> guard(B->lock);
+			B->wake.wait(guard, [B]() { return B->stop == 1 || B->pending[0] + B->pending[1] + B->pending[2] + B->pending[3] + B->pending[4] + B->pending[5] > 0; });
+			if (B->pending[0] + B->pending[1] + B->pending[2] + B->pending[3] + B->pending[4] + B->pending[5] == 0)
+				return;						// Stopped, and everything is sent
+			oldest = std::chrono::steady_clock::now();
+			for (int i = 0; i < 6; i++)
+			{
+				Legs[i] = B->pending[i];
+				if (B->pending[i] == 1)
+				{
+					memcpy(Frames[i], B->Frames[i], 8);
+					if (B->posted[i] < oldest)
+						oldest = B->posted[i];
+				}
+				B->pending[i] = 0;
+			}
+			B->busy = 1;
+		}
+
+		SendFrames(Frames, Legs, B->ard);				// The loop can post new commands meanwhile
+
+		{
+			std::lock_guard<std::mutex> guard(B->lock);
+			double latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - oldest).count();
+			B->sends++;
+			B->latencyTotal += latency;
+			if (latency > B->latencyMax)
+				B->latencyMax = latency;
+			B->busy = 0;
+		}
+		B->idle.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts the worker thread
+void BusWorkerStart(BusWorker &B, const vector<int> &ard)
+{
+	B.ard = ard;
+	for (int i = 0; i < 6; i++)
+		B.pending[i] = 0;
+	B.busy = 0; B.stop = 0;
+	B.posts = 0; B.sends = 0; B.coalesced = 0; B.dropped = 0; B.latencyTotal = 0; B.latencyMax = 0;
+	B.thread = std::thread(work, &B);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Puts the commands in the mailboxes. A command that is still in a mailbox is replaced, it keeps its posting time for the latency.
+void BusWorkerPost(BusWorker &B, uint8_t Frames[6][8])
+{
+	auto now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> guard(B.lock);
+		for (int i = 0; i < 6; i++)
+		{
+			if (B.pending[i] == 1)
+				B.coalesced++;
+			else
+				B.posted[i] = now;
+			memcpy(B.Frames[i], Frames[i], 8);
+			B.pending[i] = 1;
+		}
+		B.posts += 6;
+	}
+	B.wake.notify_one();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Empties the mailboxes and waits until the worker is not sending anymore, so no older command reaches the legs after (or in between the
+// writes of) the priority command that follows. The loop is the only one that posts, so the worker stays idle until the next post.
+// The send in flight stops at its next write when the priority command forgot the shadow first (the epoch in SendFrames).
+void BusWorkerDrop(BusWorker &B)
+{
+	std::unique_lock<std::mutex> guard(B.lock);
+	for (int i = 0; i < 6; i++)
+	{
+		B.dropped += B.pending[i];
+		B.pending[i] = 0;
+	}
+	B.idle.wait(guard, [&B]() { return B.busy == 0; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Waits until the mailboxes are empty and the worker is not sending
+void BusWorkerFlush(BusWorker &B)
+{
+	std::unique_lock<std::mutex> guard(B.lock);
+	B.idle.wait(guard, [&B]() { return B.busy == 0 && B.pending[0] + B.pending[1] + B.pending[2] + B.pending[3] + B.pending[4] + B.pending[5] == 0; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Stops the worker thread. The commands still in the mailboxes are sent first.
+void BusWorkerStop(BusWorker &B)
+{
+	{
+		std::lock_guard<std::mutex> guard(B.lock);
+		B.stop = 1;
+	}
+	B.wake.notify_one();
+	if (B.thread.joinable())
+		B.thread.join();
+	if (current == &B)
+		current = NULL;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the amount of posted commands, how often the worker sent, how many commands were coalesced or dropped, and the latency
+void BusWorkerPrintStats(BusWorker &B)
+{
+	std::lock_guard<std::mutex> guard(B.lock);
+	double average = 0;
+	if (B.sends > 0)
+		average = B.latencyTotal / B.sends;
+	cout << "\n Bus worker: " << B.posts << " commands, " << B.sends << " sends, " << B.coalesced << " coalesced, " << B.dropped << " dropped, latency "
+	     << average * 1e6 << " us average, worst " << B.latencyMax * 1e6 << " us \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The worker SendVecUpdaterS posts to
+void BusWorkerSet(BusWorker *B)
+{
+	current = B;
+}
+
+BusWorker *BusWorkerGet()
+{
+	return current;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Helpers of the check: the same command for all legs (walk to *position*), waiting until the worker is sending, and the position
+// the legs were commanded last (-1 when they differ)
+static void checkFrames(uint8_t Frames[6][8], int position)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		uint8_t Data[8] = {2, (uint8_t) (position >> 8), (uint8_t) (position & 0xFF), 10, 0, 1, 0, 1};
+		memcpy(Frames[i], Data, 8);
+	}
+}
+
+static int checkSending(BusWorker &B, long sends)
+{
+	for (int k = 0; k < 1000; k++)
+	{
+		{
+			std::lock_guard<std::mutex> guard(B.lock);
+			if (B.busy == 1 && B.sends == sends)
+				return 1;
+			if (B.sends > sends)
+				return 0;					// The send is over already
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+	return 0;
+}
+
+static int checkCommanded(const vector<int> &ard)
+{
+	int position = -2;
+	for (int i = 0; i < 6; i++)
+	{
+		int p = (i2cRead(ard[i], 31) << 8) + i2cRead(ard[i], 32);
+		if (position != -2 && p != position)
+			return -1;
+		position = p;
+	}
+	return position;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The check of ./Walking busworkercheck [latency]. The legs are simulated (SimBus) with *latency* us per transaction, so a send
+// takes long enough to post behind it:
+//  - post A and wait until the worker sends it, post B and C: B is coalesced into C and never reaches the legs, the legs end on C
+//  - post D and wait until the worker sends it, post E and drop: E is dropped, the drop only returns when the worker is idle, and
+//    the worker stays idle afterwards. The legs end on D.
+long BusWorkerCheck(int latency)
+{
+	long errors = 0;
+	BusSet(BusOpen("sim:" + to_string(latency)));
+	vector<int> ard = DiscoverLegs();
+	if (ard.size() == 0)
+	{
+		cout << "\n Bus worker check: the simulated legs were not found \n";
+		return 1;
+	}
+	BusWorker B; BusWorkerStart(B, ard);
+	uint8_t Frames[6][8];
+
+	checkFrames(Frames, 100); BusWorkerPost(B, Frames);
+	if (checkSending(B, 0) == 0)
+	{
+		cout << " The worker did not send the first command in time \n";
+		errors++;
+	}
+	checkFrames(Frames, 200); BusWorkerPost(B, Frames);
+	checkFrames(Frames, 300); BusWorkerPost(B, Frames);
+	BusWorkerFlush(B);
+	int commanded = checkCommanded(ard);
+	if (B.sends != 2 || B.coalesced != 6 || commanded != 300)
+	{
+		cout << " Coalescing: " << B.sends << " sends and " << B.coalesced << " coalesced, expected 2 and 6, the legs walk to " << commanded
+		     << ", expected 300 \n";
+		errors++;
+	}
+
+	checkFrames(Frames, 400); BusWorkerPost(B, Frames);
+	if (checkSending(B, 2) == 0)
+	{
+		cout << " The worker did not send the fourth command in time \n";
+		errors++;
+	}
+	checkFrames(Frames, 500); BusWorkerPost(B, Frames);
+	BusWorkerDrop(B);
+	int busy;
+	{
+		std::lock_guard<std::mutex> guard(B.lock);
+		busy = B.busy;
+	}
+	std::this_thread::sleep_for(std::chrono::microseconds(3 * latency));	// Time for a send that should not happen
+	BusWorkerFlush(B);
+	commanded = checkCommanded(ard);
+	if (busy != 0 || B.dropped != 6 || B.sends != 3 || commanded != 400)
+	{
+		cout << " Dropping: the worker was " << ((busy == 0) ? "idle" : "busy") << " after the drop, " << B.dropped << " dropped and " << B.sends
+		     << " sends, expected 6 and 3, the legs walk to " << commanded << ", expected 400 \n";
+		errors++;
+	}
+
+	BusWorkerStop(B);
+	BusWorkerPrintStats(B);
+	cout << "\n Bus worker check: " << errors << " errors \n";
+	return errors;
+}
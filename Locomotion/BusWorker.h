@@ -0,0 +1,56 @@
+#ifndef BUSWORKER_H
+#define BUSWORKER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <stdint.h>
+using namespace std;
+
+// HEADER FILE FOR THE BUS WORKER! See the .cpp file for the extended explanations
+
+#define BUSWORKER_CHECK_LATENCY 20000	// ./Walking busworkercheck: time (us) of a transaction of the simulated legs, so commands can be posted behind a send
+
+struct BusWorker
+{
+	uint8_t Frames[6][8];		// Mailbox: the newest motion command per leg that is not on the bus yet
+	int pending[6];			// 1 if the mailbox of the leg holds a command
+	std::chrono::steady_clock::time_point posted[6];	// When the command in the mailbox was posted (first post since the last send)
+	vector<int> ard;		// The legs (from connectLegs)
+
+	std::mutex lock;		// Protects the mailbox
+	std::condition_variable wake;	// Wakes the worker for new commands
+	std::condition_variable idle;	// Wakes BusWorkerFlush when the worker is done
+	int busy;			// The worker is sending
+	int stop;
+	std::thread thread;
+
+	long posts;			// Amount of commands posted (per leg)
+	long sends;			// Amount of times the worker went to the bus
+	long coalesced;			// Commands replaced by a newer command for the same leg before they were sent
+	long dropped;			// Commands thrown away because a priority command (stop, reset) went first
+	double latencyTotal;		// Total time from posting to the end of sending, of the oldest command of every send (s)
+	double latencyMax;		// Longest of these (s)
+};
+
+void BusWorkerStart(BusWorker &B, const vector<int> &ard); // Starts the worker thread
+
+void BusWorkerPost(BusWorker &B, uint8_t Frames[6][8]); // Posts the motion commands of the six legs, replacing the commands that were not sent yet. Never waits for the bus
+
+void BusWorkerDrop(BusWorker &B); // Throws the commands that were not sent yet away and waits until the worker is idle (before a priority command)
+
+void BusWorkerFlush(BusWorker &B); // Waits until all posted commands are sent
+
+void BusWorkerStop(BusWorker &B); // Sends what is left, then stops and joins the worker thread
+
+void BusWorkerPrintStats(BusWorker &B); // Prints the posted, sent, coalesced and dropped commands and the latency
+
+void BusWorkerSet(BusWorker *B); // Makes SendVecUpdaterS post its commands to *B* (NULL = send them directly)
+
+BusWorker *BusWorkerGet(); // The worker used by SendVecUpdaterS, or NULL
+
+long BusWorkerCheck(int latency); // Checks coalescing and dropping on simulated legs with *latency* us per transaction. Returns the amount of errors
+
+#endif
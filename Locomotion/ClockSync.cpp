@@ -0,0 +1,288 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Recorder.h"
+#include "ClockSync.h"
+#include "SimBus.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE CLOCK SYNCHRONISATION
+// The legs used to get one byte every second: the whole seconds (register 11), which zeroes the counter of the leg, so every leg
+// was off by the bus latency of that write, plus whatever its crystal drifted in the second before. Now the legs count the seconds
+// themselves and every second the host does a two-way exchange with all of them:
+//  - the host writes a sequence number to register 200 of all legs (one broadcast write). Every leg latches its clock in the
+//    interrupt of that byte, so all legs latch at the same moment, near the end of the write.
+//  - the host reads the latched time and the sequence number back (201-204, one batch). A leg that did not process the latch yet
+//    still has the old sequence number and is read again.
+//  - offset = latched time - host time at the end of the write. The error is at most the time the write took, so a write that
+//    took long (it waited for the bus worker, or the host was interrupted) is not used, and the latch is done again.
+//  - the offset goes back to the leg as a slew (205-206): the leg makes its next seconds a little longer or shorter until it is
+//    gone (at most 5 ms per second), so the clock never jumps during a stride. Above 10 ms the leg steps, above 0.45 s the host
+//    sets the seconds again.
+//  - what the offset changed from one round to the next, minus the slew, is the drift of the crystal. Every CLOCKSYNC_WINDOW
+//    rounds the average drift is added to the trim of the leg (207-208), so the leg stops drifting instead of being slewed back.
+// The leg shows the slew it did not apply yet in register 209. The host time is the steady clock, not the loop counter, because
+// a leg can only be as close to the host as the host clock is smooth.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Host time 0 is now; the first round sets the seconds of the legs
+void ClockSyncInit(ClockSync &C)
+{
+	C.start = std::chrono::steady_clock::now();
+	C.sequence = 0; C.bestTrip = 1; C.coarse = 1;
+	C.rounds = 0; C.exchanges = 0; C.steps = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		ClockLeg &L = C.legs[i];
+		L.offset = 0; L.slew = 0; L.lastHost = -1; L.driftSum = 0; L.driftCount = 0; L.trim = 0;
+		L.residualSum = 0; L.residualMax = 0; L.residuals = 0; L.misses = 0;
+	}
+}
+
+double ClockSyncNow(ClockSync &C)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - C.start).count();
+}
+
+// Two-way unless ZEBRO_SYNC=step (legs with older firmware). A recording keeps the old sync, because the slew values depend on the timing
+int ClockSyncMode()
+{
+	const char *sync = getenv("ZEBRO_SYNC");
+	if (sync != NULL && string(sync) == "step")
+		return 0;
+	return (RecorderMode() == RECORDER_OFF) ? 1 : 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Sets the seconds of all legs to the nearest whole second of the host; the slew takes the rest in the next rounds
+static void setSeconds(ClockSync &C, const vector<int> &ard)
+{
+	double now = ClockSyncNow(C);
+	i2cWrite(ard[6], 11, ((long) floor(now + 0.5)) % 256);
+	C.coarse = 0; C.steps++;
+	for (int i = 0; i < 6; i++)
+	{
+		C.legs[i].lastHost = -1; C.legs[i].slew = 0; C.legs[i].driftSum = 0; C.legs[i].driftCount = 0;
+	}
+}
+
+// Writes the latch and returns the host time at the end of the write. The first write with a round trip close to the shortest one is taken.
+static double latch(ClockSync &C, const vector<int> &ard)
+{
+	double end = 0;
+	for (int k = 0; k < CLOCKSYNC_EXCHANGES; k++)
+	{
+		C.sequence++; C.exchanges++;
+		double begin = ClockSyncNow(C);
+		i2cWrite(ard[6], CLOCKSYNC_LATCH_REG, C.sequence);
+		end = ClockSyncNow(C);
+		double trip = end - begin;
+		int good = (trip <= 1.5 * C.bestTrip + 100e-6);
+		if (trip < C.bestTrip){C.bestTrip = trip;}
+		if (good == 1){break;}
+	}
+	return end;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// One round: latch, read back, and send the slew and trim of every leg
+int ClockSyncRound(ClockSync &C, const vector<int> &ard)
+{
+	if (C.coarse == 1)
+	{
+		setSeconds(C, ard);
+		return 0;
+	}
+	C.rounds++;
+	double host = latch(C, ard);
+
+	uint8_t Data[6][4];
+	int fresh[6] = {0, 0, 0, 0, 0, 0};
+	for (int r = 0; r < CLOCKSYNC_READS; r++)
+	{
+		BusRead Reads[6]; int Index[6]; int count = 0;
+		for (int i = 0; i < 6; i++)
+		{
+			if (fresh[i] == 1){continue;}
+			Reads[count].fd = ard[i]; Reads[count].reg = CLOCKSYNC_LATCH_REG + 1; Reads[count].data = Data[i]; Reads[count].n = 4;
+			Index[count] = i; count++;
+		}
+		if (count == 0){break;}
+		if (r > 0){std::this_thread::sleep_for(std::chrono::milliseconds(1));}	// The leg processes the latch in its main loop
+		i2cReadBatch(Reads, count);
+		for (int k = 0; k < count; k++)
+		{
+			fresh[Index[k]] = (Reads[k].result >= 0 && Data[Index[k]][3] == C.sequence);
+		}
+	}
+
+	uint8_t Frames[6][4]; BusWrite Writes[6]; int count = 0; int answered = 0;
+	for (int i = 0; i < 6; i++)
+	{
+		ClockLeg &L = C.legs[i];
+		if (fresh[i] == 0)
+		{
+			L.misses++;
+			continue;
+		}
+		answered++;
+		double leg = Data[i][0] + ((Data[i][1] << 8) + Data[i][2]) / (double) CLOCKSYNC_TICKS;
+		double offset = fmod(leg - fmod(host, 256) + 256 + 128, 256) - 128;		// Rollover of the seconds, like time_calculate_delta
+		if (fabs(offset) > CLOCKSYNC_COARSE)
+		{
+			C.coarse = 1;								// The next round sets the seconds
+			continue;
+		}
+		if (L.lastHost >= 0)
+		{
+			double most = CLOCKSYNC_SLEW_MAX / (double) CLOCKSYNC_TICKS * (host - L.lastHost);
+			double applied = L.slew;						// What the leg slewed (or stepped) since the last round
+			if (fabs(L.slew) * CLOCKSYNC_TICKS <= CLOCKSYNC_STEP_TICKS && fabs(L.slew) > most){applied = copysign(most, L.slew);}
+			L.driftSum += (offset - (L.offset - applied)) / (host - L.lastHost);
+			L.driftCount++;
+			if (fabs(L.slew) * CLOCKSYNC_TICKS <= CLOCKSYNC_SLEW_MAX)
+			{
+				L.residualSum += fabs(offset); L.residuals++;				// The leg was already tracking, this is the error it walks with
+				if (fabs(offset) > L.residualMax){L.residualMax = fabs(offset);}
+			}
+		}
+		if (L.driftCount >= CLOCKSYNC_WINDOW)
+		{
+			L.trim += (int) lround(L.driftSum / L.driftCount * CLOCKSYNC_TICKS * 16);	// A fast leg (drift > 0) gets longer seconds
+			if (L.trim > CLOCKSYNC_TRIM_MAX){L.trim = CLOCKSYNC_TRIM_MAX;}
+			if (L.trim < -CLOCKSYNC_TRIM_MAX){L.trim = -CLOCKSYNC_TRIM_MAX;}
+			L.driftSum = 0; L.driftCount = 0;
+		}
+		int ticks = (int) lround(offset * CLOCKSYNC_TICKS);
+		L.offset = offset; L.slew = ticks / (double) CLOCKSYNC_TICKS; L.lastHost = host;
+		Frames[i][0] = (uint8_t) ((ticks >> 8) & 0xFF); Frames[i][1] = (uint8_t) (ticks & 0xFF);
+		Frames[i][2] = (uint8_t) ((L.trim >> 8) & 0xFF); Frames[i][3] = (uint8_t) (L.trim & 0xFF);
+		Writes[count].fd = ard[i]; Writes[count].reg = CLOCKSYNC_SLEW_REG; Writes[count].data = Frames[i]; Writes[count].n = 4;
+		count++;
+	}
+	if (count > 0)
+	{
+		i2cWriteBatch(Writes, count);
+	}
+	return answered;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the rounds, the shortest round trip, and per leg the offset while tracking (average/worst), the drift and the misses
+void ClockSyncPrintStats(ClockSync &C)
+{
+	cout << "\n Clock sync: " << C.rounds << " rounds, " << C.exchanges << " latch writes, " << C.steps << " second settings, shortest write "
+	     << C.bestTrip * 1e6 << " us \n";
+	cout << " Clock offset per leg (average/worst us, drift ppm, missed rounds):";
+	for (int i = 0; i < 6; i++)
+	{
+		ClockLeg &L = C.legs[i];
+		double average = (L.residuals > 0) ? L.residualSum / L.residuals : 0;
+		double drift = L.trim / (16.0 * CLOCKSYNC_TICKS) + ((L.driftCount > 0) ? L.driftSum / L.driftCount : 0);
+		printf(" %.0f/%.0f %+.0f %ld", average * 1e6, L.residualMax * 1e6, drift * 1e6, L.misses);
+		if (i < 5){cout << ",";}
+	}
+	cout << " \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The error of the clock of every simulated leg (leg time minus host time, s) and the time the sample was taken (s). A leg is read
+// again when reading it took long, so a preemption in between does not count as an error of the clock.
+static void checkErrors(ClockSync &C, SimBus *sim, const vector<int> &ard, double Error[6], double Leg[6], double &host)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		double begin = 0; double end = 1;
+		for (int k = 0; k < CLOCKSYNC_EXCHANGES && end - begin > 20e-6; k++)
+		{
+			begin = ClockSyncNow(C);
+			Leg[i] = sim->legTime(ard[i] - SIM_ADDRESS_OFFSET);
+			end = ClockSyncNow(C);
+		}
+		host = (begin + end) / 2;
+		Error[i] = fmod(Leg[i] - fmod(host, 256) + 256 + 128, 256) - 128;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The self check of ./Walking clocksynccheck [rounds]. Simulated legs with drifting crystals are synchronised every
+// CLOCKSYNC_CHECK_PERIOD seconds. The host clock starts just before a whole second, so the seconds that the first round sets put the
+// legs CLOCKSYNC_CHECK_AHEAD seconds ahead, which the legs have to slew away: between two rounds no leg clock may run much faster or
+// slower than the slew allows (it would have stepped). After *rounds* rounds every leg has to be within CLOCKSYNC_CHECK_LIMIT of the host, and
+// during a pause without rounds the trim has to keep it there (at most CLOCKSYNC_CHECK_DRIFT). The errors are taken from the clocks of
+// the simulated legs, not from what the latch measured. Returns the amount of errors.
+long ClockSyncCheck(int rounds)
+{
+	SimBus *sim = new SimBus(CLOCKSYNC_CHECK_LATENCY, CLOCKSYNC_CHECK_BYTE);
+	BusSet(sim);
+	vector<int> ard = DiscoverLegs();
+	if (ard.size() == 0)
+	{
+		cout << "\n Clock sync check: the simulated legs were not found \n";
+		return 1;
+	}
+	ClockSync C; ClockSyncInit(C);
+	C.start -= std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1 - CLOCKSYNC_CHECK_AHEAD));
+
+	double Error[6]; double Leg[6]; double PrevLeg[6]; double host = 0; double prevHost = 0;
+	double rateMax = 0; long errors = 0;
+	for (int r = 0; r < rounds; r++)
+	{
+		ClockSyncRound(C, ard);
+		checkErrors(C, sim, ard, Error, Leg, host);
+		for (int i = 0; i < 6 && r > 0; i++)				// Round 0 sets the seconds
+		{
+			double rate = fabs(fmod(Leg[i] - PrevLeg[i] + 256 + 128, 256) - 128 - (host - prevHost)) / (host - prevHost);
+			if (rate > rateMax){rateMax = rate;}
+		}
+		memcpy(PrevLeg, Leg, sizeof(Leg)); prevHost = host;
+		std::this_thread::sleep_for(std::chrono::duration<double>(CLOCKSYNC_CHECK_PERIOD));
+	}
+	double rateLimit = 2 * CLOCKSYNC_SLEW_MAX / (double) CLOCKSYNC_TICKS;	// The slew plus the crystal and the sampling; stepping CLOCKSYNC_CHECK_AHEAD is far more
+	if (rateMax > rateLimit)
+	{
+		cout << " A leg clock ran " << rateMax * 1e6 << " ppm off the host between two rounds, more than twice the slew (it stepped) \n";
+		errors++;
+	}
+
+	double errorMax = 0; double driftMax = 0;
+	checkErrors(C, sim, ard, Error, Leg, host);
+	double Before[6]; memcpy(Before, Error, sizeof(Error)); double before = host;
+	std::this_thread::sleep_for(std::chrono::duration<double>(CLOCKSYNC_CHECK_PAUSE));
+	checkErrors(C, sim, ard, Error, Leg, host);
+	for (int i = 0; i < 6; i++)
+	{
+		if (fabs(Before[i]) > errorMax){errorMax = fabs(Before[i]);}
+		double drift = fabs(Error[i] - Before[i]) / (host - before);
+		if (drift > driftMax){driftMax = drift;}
+		if (fabs(Before[i]) > CLOCKSYNC_CHECK_LIMIT || drift > CLOCKSYNC_CHECK_DRIFT)
+		{
+			cout << " Leg " << i << ": " << Before[i] * 1e6 << " us off the host, drifts " << drift * 1e6 << " ppm after the trim \n";
+			errors++;
+		}
+	}
+	ClockSyncPrintStats(C);
+	cout << "\n Clock sync check: " << rounds << " rounds, fastest slew " << rateMax * 1e6 << " ppm, worst leg " << errorMax * 1e6
+	     << " us off the host, drifting " << driftMax * 1e6 << " ppm without rounds \n";
+	return errors;
+}
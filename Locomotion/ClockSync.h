@@ -0,0 +1,64 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+// HEADER FILE FOR THE CLOCK SYNCHRONISATION! See the .cpp file for the extended explanations
+
+#define CLOCKSYNC_LATCH_REG 200		// VREGS_CLOCK_LATCH of the leg firmware, followed by the latched seconds, counter (2 bytes) and sequence number (201-204)
+#define CLOCKSYNC_SLEW_REG 205		// VREGS_CLOCK_SLEW_A: slew (205-206) and trim (207-208), signed, high byte first
+#define CLOCKSYNC_TICKS 64000		// TIME_ONE_SECOND_COUNTER_VALUE of the leg firmware
+#define CLOCKSYNC_SLEW_MAX 320		// TIME_SLEW_MAX_TICKS: most ticks a leg slews per second
+#define CLOCKSYNC_STEP_TICKS 640	// TIME_SLEW_STEP_TICKS: a larger slew steps the clock of the leg at once
+#define CLOCKSYNC_TRIM_MAX 10240	// TIME_TRIM_MAX: 1 %
+#define CLOCKSYNC_COARSE 0.45		// Offset (s) above which the seconds are set again (register 11), the slew register only reaches 0.5 s
+#define CLOCKSYNC_EXCHANGES 4		// Most latch writes per round, the first one with a short round trip is read back
+#define CLOCKSYNC_READS 3		// Times the latched time is read again when a leg did not process the latch yet
+#define CLOCKSYNC_WINDOW 8		// Rounds the drift is averaged over before the trim of the leg is corrected
+#define CLOCKSYNC_CHECK_ROUNDS 30	// ./Walking clocksynccheck: rounds before the clocks are checked
+#define CLOCKSYNC_CHECK_PERIOD 0.1	// ./Walking clocksynccheck: seconds between two rounds
+#define CLOCKSYNC_CHECK_AHEAD 0.004	// ./Walking clocksynccheck: the first round sets the legs this far ahead (s), less than a step
+#define CLOCKSYNC_CHECK_PAUSE 0.5	// ./Walking clocksynccheck: seconds without rounds in which the trimmed legs may not drift
+#define CLOCKSYNC_CHECK_LIMIT 100e-6	// ./Walking clocksynccheck: most a leg may be off the host after the rounds (s)
+#define CLOCKSYNC_CHECK_DRIFT 50e-6	// ./Walking clocksynccheck: most drift left after the trim (s/s), the crystals drift up to 300e-6. The rounds are 10 times as
+					// frequent as in the loop, so every drift sample is 10 times as noisy
+#define CLOCKSYNC_CHECK_LATENCY 50	// ./Walking clocksynccheck: time (us) of a transaction of the simulated legs
+#define CLOCKSYNC_CHECK_BYTE 90		// ./Walking clocksynccheck: time (us) of a byte on the simulated bus (100 kHz)
+
+struct ClockLeg
+{
+	double offset;			// Leg clock minus host clock at the last round (s)
+	double slew;			// Slew sent at the last round (s)
+	double lastHost;		// Host time of the last offset (s), -1 = none yet
+	double driftSum; int driftCount;	// Drift left after the trim, measured since the last trim correction (s/s)
+	int trim;			// Trim sent to the leg (1/16 ticks per second)
+	double residualSum; double residualMax; long residuals;	// |offset| of the rounds when the leg was already slewing (s)
+	long misses;			// Rounds the leg did not answer or did not latch
+};
+
+struct ClockSync
+{
+	ClockLeg legs[6];
+	std::chrono::steady_clock::time_point start;	// Host time 0
+	uint8_t sequence;		// Of the last latch write
+	double bestTrip;		// Shortest latch write so far (s)
+	int coarse;			// 1 when the seconds of the legs have to be set (register 11)
+	long rounds; long exchanges; long steps;
+};
+
+void ClockSyncInit(ClockSync &C); // Host time starts at 0, the first round sets the seconds of the legs
+
+double ClockSyncNow(ClockSync &C); // Host time in seconds since ClockSyncInit (the time of the schedule)
+
+int ClockSyncMode(); // 1 = two-way synchronisation, 0 = the old sync counter every second (ZEBRO_SYNC=step, and when recording or replaying)
+
+int ClockSyncRound(ClockSync &C, const vector<int> &ard); // Measures the offset of all legs and sends them their slew and trim. Returns the amount of legs that answered
+
+void ClockSyncPrintStats(ClockSync &C); // Prints the rounds, round trips and the offset and drift per leg
+
+long ClockSyncCheck(int rounds); // The check of ./Walking clocksynccheck: slew, offset and trim of simulated legs with drifting crystals. Returns the amount of errors
+
+#endif
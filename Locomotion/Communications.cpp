@@ -1,309 +1,1242 @@
-#include <iostream>
-#include <sys/types.h>
-#include <sys/time.h>
-#include <vector>
-#include <wiringPi.h>
-#include <time.h>
-#include <ctime>
-#include <chrono>
-#include <thread>
-#include <wiringPiI2C.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <math.h>
-#include <ncurses.h> 
-#include <termios.h>
-#include <fcntl.h>
-#include "MaxPlusCalc.h"
-#include "Gaits.h"
-#include "Decisions.h"
-#include "Supporting.h"
-#include "Communications.h"
-using namespace std;
-
-// THIS FILE IS FOR THE COMMUNICATION WITH THE KILO ZEBRO 
-// The functions are made to have a working communications between the PI and Zebro. It can be noted that certain conversion functions are included.
-
-
-//-----------------------------------------------------------------------------------------------------------------------------
-// The time rewrite function (time -> Zebro Time)
-vector<unsigned int> rewriteTime(vector<float> Vec) // Rewrites the time to make sure it can be passed on to the KILO
-{
-        unsigned int Tlb = floor(Vec[0]); //liftoff time in whole seconds
-        unsigned int Ttb = floor(Vec[1]); //touchdown time in whole seconds
-       // unsigned int Tla = floor(((time-Tlb)*1000)/4); // behind the comma
-       // unsigned int Tta = floor(((time-Ttb)*1000)/4);// behind the comma
-        unsigned int Tla = int(floor(((Vec[0]-Tlb)*1000)/4));
-        unsigned int Tta = int(floor(((Vec[1]-Ttb)*1000)/4));
-        vector<unsigned int> rewriteTime (4,0);
-        rewriteTime[0] = Tlb;rewriteTime[1] = Ttb;rewriteTime[2] = Tla;rewriteTime[3] = Tta;
-        return rewriteTime;
-}
-//----------------------------------------------------------------------------------------------------------------------------
-vector<unsigned int> rewritePos(vector<float> Vec) // Rewrites the position to make sure it can be passed on to the KILO
-{
-	div_t divresult;
-        unsigned int Posi = floor(Vec[0]); 
-        divresult = div (Posi,255);
-	unsigned int grootPosi = floor(divresult.quot);
-	unsigned int kleinPosi = floor(divresult.rem);
-        vector<unsigned int> rewritePos (2,0);
-        rewritePos[0] = grootPosi;rewritePos[1] = kleinPosi;
-        return rewritePos;
-}
-
-
-
-//-----------------------------------------------------------------------------------------------------------------------------
-// Sends the liftoff and touchdown times to the seperate legs, as well as the operation modus. This is for forward walking
-void SendToLeg(vector<float> Vec,double time,int adress)
-{
-	vector<unsigned int> TimeVec = rewriteTime(Vec); // [0] = tlb (sec), [1] = ttb (sec), [2] = tla (ms/4), [3] = tta (ms/4)
-	vector<unsigned int> PosVec = rewritePos(Vec);
-	uint8_t Data[8] = {2,(uint8_t) PosVec[0],(uint8_t) PosVec[1],(uint8_t) TimeVec[1],(uint8_t) TimeVec[3],1,0,1};
-	for (uint8_t i=0;i<9;i++)
-	{
-	wiringPiI2CWriteReg8(adress,30+i,Data[i]);
-	delayMicroseconds(1);
-	}
-}
-//-----------------------------------------------------------------------------------------------------------------------------
-// Calculates the lift off and touchdown data that needs to be send, and sends it.
-vector<float> SendVecUpdater(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard)
-{
-	vector<float> Vec(3,0);
-	vector<float> OutPutVec(12,0);
-	for (int i=0;i<6;i++)
-	{
-		Vec[0] =0;Vec[1]=0;Vec[2]=0;
-		if (time<CurVec[i+6])
-		{
-			Vec[0] = CurVec[i+6]; Vec[1] = CurVec[i]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
-		}
-		else if (time<CurVec[i] && time>=CurVec[i+6])
-		{
-			Vec[0] = NextVec[i+6]; Vec[1] = CurVec[i]; Vec[2] = 3;
-		}
-		else if (time>=CurVec[i] &&  time<=NextVec[i+6])
-		{
-			Vec[0] = NextVec[i+6]; Vec[1]= NextVec[i]; Vec[2] = 3;
-		}
-		else
-		{
-			cout<< " Error in SendVecUpdater";
-		}
-		SendToLeg(Vec,time,ard[i]);
-		OutPutVec[i] = Vec[0];
-		OutPutVec[i+6]=Vec[1]; 
-	}
-	return OutPutVec;
-}
-
-//-----------------------------------------------------------------------------------------------------------------------------
-// Calculates the lift off and touchdown data that needs to be send, and sends it.
-vector<float> SendVecUpdaterS(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard)
-{
-	vector<float> Vec(3,0);
-	vector<float> OutPutVec(12,0);
-	float liftoffleft = 650;
-	int lor=0; int lo; int stand; int td;
-	float standleft = 610;
-	float touchdownleft = 570;
-	float liftoffright = 650;
-	float standright =610;
-	float touchdownright=570;
-	for (int i=0;i<6;i++)
-	{
-		lor = i%2;
-		if (lor==0){lo = liftoffleft;stand=standleft;td=touchdownleft;}
-		if (lor==1){lo = liftoffright;stand=standright;td=touchdownright;}
-		Vec[0] =0;Vec[1]=0;Vec[2]=0;
-		if (time<CurVec[i+6] && time>PrevVec[i])
-		{
-			Vec[0] = lo; Vec[1] = CurVec[i+6]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
-		}
-		else if (time<CurVec[i] && time>=CurVec[i+6])
-		{
-			Vec[0] = td; Vec[1] = CurVec[i]; Vec[2] = 3;
-		}
-		else if (time>=CurVec[i] &&  time<=NextVec[i+6])
-		{
-			Vec[0] = lo; Vec[1]= NextVec[i+6]; Vec[2] = 3;
-		}
-		else
-		{
-			Vec[0] = stand; Vec[1] = time+1; Vec[2]=2;
-		}
-		//printVec(Vec);
-		SendToLeg(Vec,time,ard[i]);
-		OutPutVec[i] = Vec[0];
-		OutPutVec[i+6]=Vec[1]; 
-	}
-	return OutPutVec;
-}
-
-//-----------------------------------------------------------------------------------------------------------------------------
-// Calculates the lift off and touchdown data that needs to be send, but does not send it. This function is made to reduce the amount of sent instructions
-vector<float> SendVecCalc(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard)
-{
-        vector<float> Vec(3,0);
-        vector<float> OutSendVec(12,0);
-        for (int i=0;i<6;i++)
-        {
-                Vec[0] =0;Vec[1]=0;Vec[2]=0;
-                if (time<CurVec[i+6])
-                {
-                        Vec[0] = CurVec[i+6]; Vec[1] = CurVec[i]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
-                }
-                else if (time<CurVec[i] && time>=CurVec[i+6])
-                {
-                        Vec[0] = NextVec[i+6]; Vec[1] = CurVec[i]; Vec[2] = 3;
-                }
-                else if (time>=CurVec[i] &&  time<=NextVec[i+6])
-                {
-                        Vec[0] = NextVec[i+6]; Vec[1]= NextVec[i]; Vec[2] = 3;
-                }
-                else
-                {
-                        cout<< " Error in SendVecCalculator";
-                }
-                OutSendVec[i] = Vec[0]; 
-                OutSendVec[i+6]=Vec[1]; 
-        }
-        return OutSendVec;
-}
-//-----------------------------------------------------------------------------------------------------------------------------
-// Connects the legs to the right I2C adresses
-vector <int>  connectLegs()  // Function to connect the legs to give the legs an adress that the PI can operate with
-{
-	wiringPiSetupGpio();
-	vector<int> ard (7,0);
-	ard[0] = wiringPiI2CSetup(0x10); // Left front leg
-	ard[1] = wiringPiI2CSetup(0x16); // Right front leg
-	ard[2] = wiringPiI2CSetup(0x12); // Left middle leg
-	ard[3] = wiringPiI2CSetup(0x18); // Right middle leg
-	ard[4] = wiringPiI2CSetup(0x14); // Left hind leg
-	ard[5] = wiringPiI2CSetup(0x1a); // Right hind leg
-	ard[6] = wiringPiI2CSetup(0x00); // Adress to send a command to all legs simultanuously
-	return ard;
-}
-//-----------------------------------------------------------------------------------------------------------------------------
-// Reads the angles to of the legs, and rewrites them in degrees (0 to 360)
-vector<int> readAngleState(int adress, int pos) //1 = right , 0 = left
-{
-	int Angle1=wiringPiI2CReadReg8 (adress, 110) ; // Read angle (110 & 111)
-	int Angle2=wiringPiI2CReadReg8 (adress, 111) ;
-	int Dir =wiringPiI2CReadReg8 (adress, 112) ; // Read direction (112)
-	int StepStat = wiringPiI2CReadReg8 (adress, 113) ; // Read current step
-	int TotAngle = Angle2*256 + Angle1;
-	if (pos == 1)					//       2pi/0 (360/0)
-	{						//             |
-		TotAngle = 910-TotAngle;		//1/2*pi(90)---|-----3/2*pi (270)
-	}						//	       |
-	double CalcAngle =(double) TotAngle/910*360;    //	    pi(180)
-	int CorAngle = (int) floor(CalcAngle);
-	vector <int> Stat (3,0);
-	Stat[0] = CorAngle; Stat[1] = Dir; Stat[2]= StepStat;
-	return Stat;
-}
-
-//----------------------------------------------------------------------------------------------------------------------------
-// This function checks if the legs are in the correct place. They should listen to what I say.
-vector<int> LegCheck(vector<float> CurVec, vector<float> NextVec,double time, vector<int> ard)
-{
-	vector<int> curStat(6,0); int tda=140;int loa=95; int deltaa =10;
-	vector<int> legStat(3,0);
-	int pos=0;
-	int bugCheck =0;
-	for (int i=3;i<4;i++)
-        {
-		if (i%2==0){pos=0;}else{pos=1;}
-		legStat = readAngleState(ard[i],pos);
-                if (time<CurVec[i+6] &&  (legStat[0]<(tda+deltaa) || legStat[0]>(loa- deltaa)))
-                {
-                        curStat[i]=1;
-			bugCheck =1;
-			cout<< bugCheck;
-                }
-                else if (time<CurVec[i] && time>=CurVec[i+6]&& (legStat[0]>(tda-deltaa) && legStat[0]<(loa+deltaa)))
-                {
-                        curStat[i]=1;
-			bugCheck =2;
-			cout<< bugCheck;
-                }
-                else if (time>=CurVec[i] &&  time<=NextVec[i+6] && (legStat[0]<(tda+deltaa) || legStat[0]>(loa-deltaa)))
-                {
-                        curStat[i]=1;
-			bugCheck =3;
-			cout<< " Deze gaat goed:   " << bugCheck;
-                }
-                else
-                {
-                        curStat[i]=0; cout<<" Too slow or other error in leg   " << i << "     " << legStat[0] << "Curvec     " << CurVec[i];
-                }
-	}
-	return curStat;
-}
-
-//----------------------------------------------------------------------------------------------------------------------------
-// This function uses the input to start a special operation, like calibrating or stopping
-int SpecOps(int ch, vector<int> ard, uint8_t syncTime) // hoi
-{
-	int walkingstop ;
-		if ( ch== 115)		// Stop Walking
-		{
-			walkingstop = 0;
-			cout<<  "         Stop Sending New Data";
-		}
-		if (ch ==99) 	// Calibrate
-		{
-			
-			wiringPiI2CWriteReg8(ard[6],30,1);
-			wiringPiI2CWriteReg8(ard[6],37,1);
-			cout<<  "         Calibrate";
-		}
-		if (ch ==122) 	// Standup
-		{
-			vector<float> PosVec(1,0);
-			PosVec[0] = 610;
-			uint8_t writeTime = (uint8_t) syncTime;
-			vector<unsigned int> PosiVec = rewritePos(PosVec);
-			uint8_t Data[8] = {2,(uint8_t) PosiVec[0],(uint8_t) PosiVec[1],(uint8_t) (writeTime+3),0,1,0,1}; 
-        		for (uint8_t i=0;i<9;i++)
-        		{
-        			wiringPiI2CWriteReg8(ard[6],30+i,Data[i]);
-        			delayMicroseconds(1);
-       			 }
-
-			cout<<  "         Stand Up";
-		}
-		if (ch ==101)
-		{
-		        // Reset Emergency Stop
- 		       wiringPiI2CWriteReg8 (ard[6], 22, 0x12) ;
-			cout<<  "         Reset Emergency Stop";
-
-		}
-		if (ch == 32)
-		{
-			// Stop Moving
-			wiringPiI2CWriteReg8 (ard[6], 30, 255) ;
-			wiringPiI2CWriteReg8 (ard[6], 37, 1) ;
-			walkingstop =0;
-			cout<< "       PANIC STOP"  ;
-		}
-		if (ch == 114)
-                {
-                        // Go back to the idle state
-                        wiringPiI2CWriteReg8 (ard[6], 30, 0) ;
-                        wiringPiI2CWriteReg8 (ard[6], 37, 1) ;
-                        walkingstop =0;
-                        cout<< "       RESET"  ;
-                }
-
-	return walkingstop;
-}
-
-
-
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <string.h>
+#include <ncurses.h> 
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Recorder.h"
+#include "Bus.h"
+#include "MultiBus.h"
+#include "BusWorker.h"
+#include "BusStats.h"
+#include "BusCapture.h"
+#include "SimBus.h"
+#include <map>
+using namespace std;
+
+// THIS FILE IS FOR THE COMMUNICATION WITH THE KILO ZEBRO 
+// The functions are made to have a working communications between the PI and Zebro. It can be noted that certain conversion functions are included.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// All I2C transactions go through these functions, so they can be recorded and replayed (see Recorder.cpp) and the bus time is counted.
+// The bus itself is the backend chosen with ZEBRO_BUS (see Bus.cpp). The stride commands are sent by the bus worker thread
+// (BusWorker.cpp) and the rest by the loop, so one transaction at a time holds busLock.
+static std::mutex busLock;
+static long busTransactions = 0; static long busBytes = 0; static double busTime = 0; static long busSyscalls = 0;	// All transactions (benchmark)
+static int legAdresses[6] = {0x10, 0x16, 0x12, 0x18, 0x14, 0x1a};	// I2C address of leg 0-5 (the order of ard, see connectLegs), changed by DiscoverLegs
+static long strideUpdates = 0; static double strideUpdateTime = 0; static long strideSyscalls = 0;		// Commands sent by SendVecUpdaterS (benchmark)
+static long strideBytes = 0; static long strideFullBytes = 0; static long strideSkipped = 0;		// Bytes sent by SendFrames, the bytes without the change-only check, and the unchanged leg commands it left out
+static uint8_t shadowFrames[6][8]; static int shadowValid[6] = {0}; static long shadowEpoch = 0;	// The last command each leg acknowledged (valid = 1), see SendFrames
+static long legChecks = 0; static long legMisplaced[6] = {0}; static long legSilent[6] = {0};		// Results of LegCheck
+
+static int legLanes[6] = {0, 0, 0, 0, 0, 0};	// Bus of every leg (see connectLegs and MultiBus.cpp)
+static int laneBroadcast[MULTIBUS_LANES_MAX];	// The broadcast address on one bus (connectLanes)
+static int lanePrefix[MULTIBUS_LANES_MAX]; static int laneSuffix[MULTIBUS_LANES_MAX];	// Registers of the broadcast frame a bus gets from 170 on and up to 195
+static int laneFrame = 0;			// Bytes of the broadcast frame on every bus, 0 = every bus gets the whole frame
+static map<int, int> fdLegs;	// Leg (0-5, 6 = all legs, 7 = other address) of every file descriptor made by i2cSetup, for BusStats.cpp
+static map<int, int> fdTargets;	// Address + 256 * bus of every file descriptor, for BusCapture.cpp
+
+static void countBus(std::chrono::steady_clock::time_point start, long syscalls, int bytes)
+{
+	busTransactions++;
+	busBytes += bytes;
+	busSyscalls += BusGet()->syscalls - syscalls;
+	busTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Counts a transaction of the leg of *fd* in the statistics per leg and register range (see BusStats.cpp)
+static void countLeg(int fd, int reg, int bytes, int result, int retries, std::chrono::steady_clock::time_point start)
+{
+	map<int, int>::iterator found = fdLegs.find(fd);
+	BusStatsAdd((found == fdLegs.end()) ? BUSSTATS_LEGS - 1 : found->second, reg, bytes, result, retries, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+// Keeps the transaction in the capture ring when ZEBRO_CAPTURE is set (see BusCapture.cpp). *first* is 1 for the first transaction of a batch.
+static void captureLeg(int fd, int reg, const uint8_t *data, int n, int read, int first, int result, int retries, std::chrono::steady_clock::time_point start)
+{
+	if (BusCaptureActive() == 0)
+		return;
+	map<int, int>::iterator leg = fdLegs.find(fd);
+	map<int, int>::iterator target = fdTargets.find(fd);
+	int flags = (read ? BUSCAPTURE_READ : 0) | (first ? BUSCAPTURE_FIRST : 0) | ((result < 0) ? BUSCAPTURE_NACK : 0);
+	BusCaptureAdd(start, (target == fdTargets.end()) ? 0 : target->second % 256, (leg == fdLegs.end()) ? BUSSTATS_LEGS - 1 : leg->second,
+	              (target == fdTargets.end()) ? 0 : target->second / 256, reg, (result < 0 && read) ? NULL : data, n, flags, retries);
+}
+
+int i2cSetup(int adress)
+{
+	return i2cSetup(adress, -1);
+}
+
+int i2cSetup(int adress, int bus)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	int fd;
+	if (RecorderMode() == RECORDER_REPLAY)
+		fd = 1000 + adress;			// There is no bus when replaying, the number is only used to find the address back
+	else if (bus < 0)
+		fd = BusGet()->setup(adress);
+	else
+		fd = BusGet()->setup(adress, bus);
+	RecordSetup(fd, adress);
+	fdLegs[fd] = (adress == 0) ? 6 : 7;
+	fdTargets[fd] = adress + 256 * ((adress == 0 && bus < 0) ? BUSCAPTURE_ALL_LANES : (bus < 0) ? 0 : bus);
+	for (int i = 0; i < 6; i++)
+	{
+		if (legAdresses[i] == adress)
+			fdLegs[fd] = i;
+	}
+	return fd;
+}
+
+// A transaction that is not acknowledged is tried again, at most BUS_RETRIES times with a growing wait (BusStatsRetry). The counters
+// in BusStats.cpp get the result after the retries.
+int i2cWrite(int fd, int reg, int data)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	int result = 0;
+	RecordWrite(fd, reg, data);
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls; int tries = 0;
+		do { result = BusGet()->writeReg8(fd, reg, data); } while (result < 0 && BusStatsRetry(tries) == 1);
+		countBus(start, syscalls, 3);			// Address, register, data
+		countLeg(fd, reg, 3 * (1 + tries), result, tries, start);
+		uint8_t value = data; captureLeg(fd, reg, &value, 1, 0, 1, result, tries, start);
+	}
+	return (result < 0) ? -1 : 0;
+}
+
+// The block write itself, the caller holds busLock
+static int writeBlock(int fd, int reg, const uint8_t *data, int n)
+{
+	int result = 0;
+	for (int i = 0; i < n; i++)
+		RecordWrite(fd, reg + i, data[i]);		// Recorded register by register, like the single writes
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls; int tries = 0;
+		do { result = BusGet()->writeBlock(fd, reg, data, n); } while (result < 0 && BusStatsRetry(tries) == 1);
+		countBus(start, syscalls, 2 + n);		// Address, register, data
+		countLeg(fd, reg, (2 + n) * (1 + tries), result, tries, start);
+		captureLeg(fd, reg, data, n, 0, 1, result, tries, start);
+	}
+	return result;
+}
+
+int i2cWriteBlock(int fd, int reg, const uint8_t *data, int n)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	return writeBlock(fd, reg, data, n);
+}
+
+// The batch write itself, the caller holds busLock
+static int writeBatch(BusWrite *writes, int count)
+{
+	int result = 0;
+	int bytes = 0;
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = 0; j < writes[i].n; j++)
+			RecordWrite(writes[i].fd, writes[i].reg + j, writes[i].data[j]);
+		bytes += 2 + writes[i].n;			// Address, register, data of every leg
+		writes[i].result = 0;
+	}
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls;
+		int Tries[BUS_BATCH_MAX] = {0};
+		BusWrite Retry[BUS_BATCH_MAX]; int Index[BUS_BATCH_MAX];
+		result = BusGet()->writeBatch(writes, count);
+		int tries = 0;
+		while (result < 0 && count <= BUS_BATCH_MAX && BusStatsRetry(tries) == 1)	// Only the legs that did not acknowledge are tried again
+		{
+			// All writes of such a leg go again, in their order. A burst of QueueStrides would otherwise get the failed command queued
+			// behind the ones after it; its first write starts a new command, which empties the queue of the leg, so the queue is
+			// built up again in the right order.
+			int failed = 0;
+			for (int i = 0; i < count; i++)
+			{
+				int again = 0;
+				for (int j = 0; j < count && again == 0; j++)
+					again = (writes[j].fd == writes[i].fd && writes[j].result < 0);
+				if (again == 1)
+				{
+					Retry[failed] = writes[i]; Index[failed] = i; Tries[i]++; failed++;
+				}
+			}
+			result = BusGet()->writeBatch(Retry, failed);
+			for (int k = 0; k < failed; k++)
+				writes[Index[k]].result = Retry[k].result;
+		}
+		countBus(start, syscalls, bytes);
+		for (int i = 0; i < count; i++)
+		{
+			int retries = (i < BUS_BATCH_MAX) ? Tries[i] : 0;
+			countLeg(writes[i].fd, writes[i].reg, (2 + writes[i].n) * (1 + retries), writes[i].result, retries, start);
+			captureLeg(writes[i].fd, writes[i].reg, writes[i].data, writes[i].n, 0, i == 0, writes[i].result, retries, start);
+		}
+	}
+	return result;
+}
+
+int i2cWriteBatch(BusWrite *writes, int count)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	return writeBatch(writes, count);
+}
+
+int i2cRead(int fd, int reg)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	int value = 0;
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls; int tries = 0;
+		do { value = BusGet()->readReg8(fd, reg); } while (value < 0 && BusStatsRetry(tries) == 1);
+		countBus(start, syscalls, 4);			// Address, register, address, data
+		countLeg(fd, reg, 4 * (1 + tries), value, tries, start);
+		uint8_t data = value; captureLeg(fd, reg, &data, 1, 1, 1, value, tries, start);
+	}
+	return RecordRead(fd, reg, value);		// Gives the recorded value back when replaying
+}
+
+// Records the registers of a block read register by register, like the single reads. A leg that did not answer is recorded as -1 for every register.
+static int recordBlock(int fd, int reg, uint8_t *data, int n, int result)
+{
+	for (int i = 0; i < n; i++)
+	{
+		int value = RecordRead(fd, reg + i, (result < 0) ? -1 : data[i]);
+		if (value < 0)
+			result = -1;
+		else
+			data[i] = value;
+	}
+	return (result < 0) ? -1 : 0;
+}
+
+int i2cReadBlock(int fd, int reg, uint8_t *data, int n)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	int result = 0;
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls; int tries = 0;
+		do { result = BusGet()->readBlock(fd, reg, data, n); } while (result < 0 && BusStatsRetry(tries) == 1);
+		countBus(start, syscalls, 3 + n);		// Address, register, address, data
+		countLeg(fd, reg, (3 + n) * (1 + tries), result, tries, start);
+		captureLeg(fd, reg, data, n, 1, 1, result, tries, start);
+	}
+	return recordBlock(fd, reg, data, n, result);
+}
+
+// Reads are not retried in a batch: a leg that does not answer to a poll is read again at the next poll anyway
+int i2cReadBatch(BusRead *reads, int count)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	int bytes = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reads[i].result = 0;
+		bytes += 3 + reads[i].n;			// Address, register, address, data of every leg
+	}
+	if (RecorderMode() != RECORDER_REPLAY)
+	{
+		auto start = std::chrono::steady_clock::now(); long syscalls = BusGet()->syscalls;
+		BusGet()->readBatch(reads, count);
+		countBus(start, syscalls, bytes);
+		for (int i = 0; i < count; i++)
+		{
+			countLeg(reads[i].fd, reads[i].reg, 3 + reads[i].n, reads[i].result, 0, start);
+			captureLeg(reads[i].fd, reads[i].reg, reads[i].data, reads[i].n, 1, i == 0, reads[i].result, 0, start);
+		}
+	}
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reads[i].result = recordBlock(reads[i].fd, reads[i].reg, reads[i].data, reads[i].n, reads[i].result);
+		if (reads[i].result < 0)
+			result = -1;
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the bus benchmark: all transactions, and the wall time and kernel calls per stride update (the commands to all six legs)
+void i2cPrintStats()
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	cout << "\n Bus: " << busTransactions << " transactions, " << busBytes << " bytes, " << busSyscalls << " syscalls, " << busTime * 1000 << " ms";
+	if (strideUpdates > 0)
+		cout << ", " << strideUpdates << " stride updates of " << strideUpdateTime / strideUpdates * 1e6 << " us and "
+		     << (double) strideSyscalls / strideUpdates << " syscalls";
+	if (strideFullBytes > 0)
+		cout << ", " << strideBytes << " command bytes instead of " << strideFullBytes << " (" << strideSkipped << " unchanged leg commands left out, "
+		     << 100 - strideBytes * 100 / strideFullBytes << "% saved)";
+	cout << " \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The time rewrite function (time -> Zebro Time)
+void rewriteTime(const float Vec[], unsigned int rewriteTime[4]) // Rewrites the time to make sure it can be passed on to the KILO
+{
+        unsigned int Tlb = floor(Vec[0]); //liftoff time in whole seconds
+        unsigned int Ttb = floor(Vec[1]); //touchdown time in whole seconds
+       // unsigned int Tla = floor(((time-Tlb)*1000)/4); // behind the comma
+       // unsigned int Tta = floor(((time-Ttb)*1000)/4);// behind the comma
+        unsigned int Tla = int(floor(((Vec[0]-Tlb)*1000)/4));
+        unsigned int Tta = int(floor(((Vec[1]-Ttb)*1000)/4));
+        rewriteTime[0] = Tlb;rewriteTime[1] = Ttb;rewriteTime[2] = Tla;rewriteTime[3] = Tta;
+}
+
+vector<unsigned int> rewriteTime(vector<float> Vec) // Same, but returns a new vector
+{
+        vector<unsigned int> Time (4,0);
+        rewriteTime(Vec.data(),Time.data());
+        return Time;
+}
+//----------------------------------------------------------------------------------------------------------------------------
+void rewritePos(const float Vec[], unsigned int rewritePos[2]) // Rewrites the position to make sure it can be passed on to the KILO
+{
+	div_t divresult;
+        unsigned int Posi = floor(Vec[0]); 
+        divresult = div (Posi,255);
+	unsigned int grootPosi = floor(divresult.quot);
+	unsigned int kleinPosi = floor(divresult.rem);
+        rewritePos[0] = grootPosi;rewritePos[1] = kleinPosi;
+}
+
+vector<unsigned int> rewritePos(vector<float> Vec) // Same, but returns a new vector
+{
+        vector<unsigned int> Pos (2,0);
+        rewritePos(Vec.data(),Pos.data());
+        return Pos;
+}
+
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes the motion command for registers 30-37 of a leg: mode, position (2 bytes), time (seconds, ms/4), new data flag, crc, update
+void MotionFrame(const float Vec[3], uint8_t Data[8])
+{
+	unsigned int TimeVec[4]; rewriteTime(Vec,TimeVec); // [0] = tlb (sec), [1] = ttb (sec), [2] = tla (ms/4), [3] = tta (ms/4)
+	unsigned int PosVec[2]; rewritePos(Vec,PosVec);
+	Data[0] = 2; Data[1] = (uint8_t) PosVec[0]; Data[2] = (uint8_t) PosVec[1]; Data[3] = (uint8_t) TimeVec[1];
+	Data[4] = (uint8_t) TimeVec[3]; Data[5] = 1; Data[6] = 0; Data[7] = 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Sends the liftoff and touchdown times to the seperate legs, as well as the operation modus. This is for forward walking
+void SendToLeg(const float Vec[3],int adress)
+{
+	uint8_t Data[8];
+	MotionFrame(Vec,Data);
+	i2cWriteBlock(adress,30,Data,8);	// Registers 30-37 in one transaction, the leg takes the command on register 37
+}
+//-----------------------------------------------------------------------------------------------------------------------------
+// Calculates the lift off and touchdown data that needs to be send, and sends it.
+vector<float> SendVecUpdater(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard)
+{
+	vector<float> Vec(3,0);
+	vector<float> OutPutVec(12,0);
+	for (int i=0;i<6;i++)
+	{
+		Vec[0] =0;Vec[1]=0;Vec[2]=0;
+		if (time<CurVec[i+6])
+		{
+			Vec[0] = CurVec[i+6]; Vec[1] = CurVec[i]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
+		}
+		else if (time<CurVec[i] && time>=CurVec[i+6])
+		{
+			Vec[0] = NextVec[i+6]; Vec[1] = CurVec[i]; Vec[2] = 3;
+		}
+		else if (time>=CurVec[i] &&  time<=NextVec[i+6])
+		{
+			Vec[0] = NextVec[i+6]; Vec[1]= NextVec[i]; Vec[2] = 3;
+		}
+		else
+		{
+			cout<< " Error in SendVecUpdater";
+		}
+		SendToLeg(Vec.data(),ard[i]);
+		OutPutVec[i] = Vec[0];
+		OutPutVec[i+6]=Vec[1]; 
+	}
+	return OutPutVec;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Puts the motion commands of the six legs (MotionFrame) in one broadcast schedule frame for registers 170-195: the mode, a slice of
+// 4 bytes (position, time) per leg and the update byte. Every leg takes the slice of its own position (motion_new_broadcast_data in motion.c).
+void BroadcastFrame(uint8_t Frames[6][8], uint8_t Frame[BROADCAST_FRAME_SIZE])
+{
+	Frame[0] = Frames[0][0];					// The mode is the same for all legs
+	for (int i=0;i<6;i++)
+	{
+		int slice = (legAdresses[i]-0x10)/2;			// The KiloZebro legs are on the even positions
+		for (int j=0;j<4;j++)
+		{
+			Frame[1+4*slice+j] = Frames[i][1+j];		// Position a, position b, time a, time b
+		}
+	}
+	Frame[BROADCAST_FRAME_SIZE-1] = 1;				// Update: all legs start their command now
+}
+
+// Returns 1 when SendVecUpdaterS sends broadcast frames, 0 when every leg gets its own frame (ZEBRO_FRAMES=unicast, for legs with older firmware)
+static int broadcastMode = -1;
+static int broadcastFrames()
+{
+	if (broadcastMode == -1)
+	{
+		const char *frames = getenv("ZEBRO_FRAMES");
+		broadcastMode = (frames != NULL && string(frames) == "unicast") ? 0 : 1;
+	}
+	return broadcastMode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The writes of SendFrames: not when a priority command (SpecOps) came after SendFrames took its commands, the epoch of the shadow has changed
+// then. The check and the write are in one hold of busLock, so a stride command never goes out after (or between the writes of) a priority
+// command. Returns -1 when the commands were too old.
+static int sendBatch(BusWrite *writes, int count, long epoch)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	if (epoch != shadowEpoch)
+	{
+		for (int i = 0; i < count; i++)
+			writes[i].result = -1;
+		return -1;
+	}
+	return writeBatch(writes, count);
+}
+
+static int sendBlock(int fd, int reg, const uint8_t *data, int n, long epoch)
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	if (epoch != shadowEpoch)
+		return -1;
+	return writeBlock(fd, reg, data, n);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Sends the motion commands of the legs with Legs[i] = 1, but only the ones that differ from the last command the leg acknowledged (the shadow).
+// Every SEND_REFRESH-th stride update sends all of them anyway, in case a leg lost its command (a reset of the leg for example).
+// The commands go in one broadcast frame when that is fewer bytes than the busiest bus would get (all six legs are in it, so all legs start
+// at the same moment). Otherwise, or with ZEBRO_FRAMES=unicast, the changed legs go in one batch (one I2C transaction with repeated starts
+// when the bus can do it, see Bus.cpp).
+// When the legs are on more buses (MultiBus.cpp) the buses do not finish at the same moment, so the commands of a batch are staged: everything
+// but the update register (37 of every leg) first, and when all buses are done the update registers, which start the legs together. The
+// broadcast frame is not staged: every bus gets only the mode, the slices of its own legs and register 195, and as many bytes as every
+// other bus (connectLanes), so the legs on all buses get register 195 at the same moment anyway.
+void SendFrames(uint8_t Frames[6][8], const int Legs[6], const vector<int> &ard)
+{
+	BusWrite Writes[6];
+	int Send[6]; int Leg[6];						// Leg[k]: the leg of Writes[k]
+	int Acked[6] = {0,0,0,0,0,0};						// The legs that got the new command
+	int count = 0; int legs = 0;
+	long syscalls; long epoch;
+	{
+		std::lock_guard<std::mutex> guard(busLock);
+		syscalls = busSyscalls; epoch = shadowEpoch;
+		int refresh = (strideUpdates % SEND_REFRESH == 0);
+		for (int i=0;i<6;i++)
+		{
+			Send[i] = (Legs[i]==1 && (refresh==1 || shadowValid[i]==0 || memcmp(shadowFrames[i],Frames[i],8)!=0));
+			if (Send[i]==1)
+			{
+				Writes[count].fd = ard[i]; Writes[count].reg = 30; Writes[count].data = Frames[i]; Writes[count].n = 8;	// Registers 30-37, the leg takes the command on register 37
+				Leg[count] = i;
+				count++;
+			}
+			legs += Legs[i];
+		}
+	}
+	int staged = (RecorderMode()==RECORDER_OFF && BusGet()->lanes()>1);	// A recording keeps the traffic of one bus
+	int commit = 2+1;							// The extra transaction of a staged send: address, update register, value
+	int buses = (staged==1) ? BusGet()->lanes() : 1;
+	int frame = (staged==1 && laneFrame>0) ? laneFrame : 2+BROADCAST_FRAME_SIZE;	// The broadcast frame on every bus, all buses at the same time
+	int full = (legs==6 && broadcastFrames()==1) ? buses*frame : legs*(2+8+staged*commit);	// What sending every leg would cost
+	int bytes = count*(2+8+staged*commit);
+	int laneBytes[6] = {0,0,0,0,0,0}; int busiest = 0;			// The buses work at the same time, the one with the most bytes takes longest
+	for (int k=0;k<6;k++)
+	{
+		if (Send[k]==0){continue;}
+		laneBytes[legLanes[k]] += 2+8+staged*commit;
+		if (laneBytes[legLanes[k]] > busiest){busiest = laneBytes[legLanes[k]];}
+	}
+	int result = 0;
+	auto start = std::chrono::steady_clock::now();
+	if (count>0 && legs==6 && broadcastFrames()==1 && frame<=busiest)
+	{
+		uint8_t Frame[BROADCAST_FRAME_SIZE];
+		BroadcastFrame(Frames,Frame);
+		if (staged==1 && laneFrame>0)
+		{
+			BusWrite Parts[2*MULTIBUS_LANES_MAX]; int parts = 0;		// The front and the back of the frame for every bus
+			for (int l=0;l<buses && l<MULTIBUS_LANES_MAX;l++)
+			{
+				if (lanePrefix[l]>0)
+				{
+					Parts[parts].fd = laneBroadcast[l]; Parts[parts].reg = BROADCAST_FRAME_REG; Parts[parts].data = Frame; Parts[parts].n = lanePrefix[l];
+					parts++;
+				}
+				if (laneSuffix[l]>0)
+				{
+					Parts[parts].fd = laneBroadcast[l]; Parts[parts].reg = BROADCAST_FRAME_REG+BROADCAST_FRAME_SIZE-laneSuffix[l];
+					Parts[parts].data = &Frame[BROADCAST_FRAME_SIZE-laneSuffix[l]]; Parts[parts].n = laneSuffix[l];
+					parts++;
+				}
+			}
+			result = sendBatch(Parts,parts,epoch);				// Every bus at the same time, returns when all are done
+		}
+		else
+		{
+			result = sendBlock(ard[6],BROADCAST_FRAME_REG,Frame,BROADCAST_FRAME_SIZE,epoch);
+		}
+		bytes = buses*frame; count = 6;
+		for (int i=0;i<6;i++){Send[i]=1; Acked[i] = (result==0);}	// One transaction for all legs
+	}
+	else if (count>0 && staged==1)
+	{
+		BusWrite Updates[6]; int UpdateLeg[6]; int updates = 0;
+		for (int k=0;k<count;k++){Writes[k].n = 7;}			// Registers 30-36
+		result = sendBatch(Writes,count,epoch);
+		for (int k=0;k<count;k++)
+		{
+			if (Writes[k].result<0){continue;}			// A leg without the new command does not start the old one again
+			Updates[updates] = Writes[k]; Updates[updates].reg = 37; Updates[updates].data = &Writes[k].data[7]; Updates[updates].n = 1;
+			UpdateLeg[updates] = Leg[k];
+			updates++;
+		}
+		if (updates>0 && sendBatch(Updates,updates,epoch)<0){result = -1;}
+		for (int k=0;k<updates;k++){Acked[UpdateLeg[k]] = (Updates[k].result==0);}
+	}
+	else if (count>0)
+	{
+		result = sendBatch(Writes,count,epoch);
+		for (int k=0;k<count;k++){Acked[Leg[k]] = (Writes[k].result==0);}
+	}
+	std::lock_guard<std::mutex> guard(busLock);
+	for (int i=0;i<6;i++)
+	{
+		if (Send[i]==1 && epoch==shadowEpoch)			// Not when the commands were forgotten meanwhile (a priority command came after them)
+		{
+			memcpy(shadowFrames[i],Frames[i],8);
+			shadowValid[i] = Acked[i];				// A leg that failed gets its command again next time
+		}
+	}
+	strideUpdates++;
+	strideSyscalls += busSyscalls - syscalls;
+	strideUpdateTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	strideBytes += bytes; strideFullBytes += full; strideSkipped += legs - count;
+}
+
+// Forgets the shadow: the legs got another command (see SpecOps), so the next stride update sends every leg again
+static void forgetFrames()
+{
+	std::lock_guard<std::mutex> guard(busLock);
+	for (int i=0;i<6;i++){shadowValid[i]=0;}
+	shadowEpoch++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Calculates the lift off and touchdown data that needs to be send, and sends it. The positions and times that were sent are written in OutPutVec (12 long).
+// When the bus worker runs, the commands are only posted to it and the loop does not wait for the bus (see BusWorker.cpp).
+void SendVecUpdaterS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,const vector<int> &ard,vector<float> &OutPutVec)
+{
+	float Vec[3];
+	uint8_t Frames[6][8];
+	const int Legs[6] = {1,1,1,1,1,1};
+	for (int i=0;i<6;i++)
+	{
+		LegVecS(PrevVec,CurVec,NextVec,time,i,Vec);
+		MotionFrame(Vec,Frames[i]);
+		OutPutVec[i] = Vec[0];
+		OutPutVec[i+6]=Vec[1]; 
+	}
+	if (BusWorkerGet()!=NULL && RecorderMode()==RECORDER_OFF)
+	{
+		BusWorkerPost(*BusWorkerGet(),Frames);		// A recording keeps the bus traffic in the order of the loop, so it sends directly
+	}
+	else
+	{
+		SendFrames(Frames,Legs,ard);
+	}
+}
+
+// Same, but returns a new vector
+vector<float> SendVecUpdaterS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,const vector<int> &ard)
+{
+	vector<float> OutPutVec(12,0);
+	SendVecUpdaterS(PrevVec,CurVec,NextVec,time,ard,OutPutVec);
+	return OutPutVec;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The lift off, stand and touchdown positions of leg i
+static void legPositions(int i, int &lo, int &stand, int &td)
+{
+	float liftoffleft = 650;
+	int lor=0;
+	float standleft = 610;
+	float touchdownleft = 570;
+	float liftoffright = 650;
+	float standright =610;
+	float touchdownright=570;
+	lor = i%2;
+	if (lor==0){lo = liftoffleft;stand=standleft;td=touchdownleft;}
+	if (lor==1){lo = liftoffright;stand=standright;td=touchdownright;}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Calculates the position, time and mode that SendVecUpdaterS sends to leg i, into Vec
+void LegVecS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,int i,float Vec[3])
+{
+	int lo; int stand; int td;
+	legPositions(i,lo,stand,td);
+	int phase = LegPhaseS(PrevVec,CurVec,NextVec,time,i);
+	if (phase==1)
+	{
+		Vec[0] = lo; Vec[1] = CurVec[i+6]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
+	}
+	else if (phase==2)
+	{
+		Vec[0] = td; Vec[1] = CurVec[i]; Vec[2] = 3;
+	}
+	else if (phase==3)
+	{
+		Vec[0] = lo; Vec[1]= NextVec[i+6]; Vec[2] = 3;
+	}
+	else
+	{
+		Vec[0] = stand; Vec[1] = time+1; Vec[2]=2;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Returns which part of the stride leg i is in: 1 = until the lift off of CurVec, 2 = until the touchdown of CurVec,
+// 3 = until the lift off of NextVec, 0 = none of these (the leg is told to stand, see LegVecS)
+int LegPhaseS(const vector<float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,int i)
+{
+	if (time<CurVec[i+6] && time>PrevVec[i]){return 1;}
+	if (time<CurVec[i] && time>=CurVec[i+6]){return 2;}
+	if (time>=CurVec[i] && time<=NextVec[i+6]){return 3;}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Same as SendVecUpdaterS, but takes PrevVec, CurVec and NextVec from the lookahead schedule
+void SendVecUpdaterS(Schedule &S,double time,const vector<int> &ard,vector<float> &SendVec)
+{
+	SendVecUpdaterS(S.PrevVec,ScheduleAt(S,0),ScheduleAt(S,1),time,ard,SendVec);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The commands of leg i from the lift off of CurVec on: command 2k goes to the lift off position at the lift off time of the vector
+// k strides ahead (ScheduleAt(S,k)), command 2k+1 to the touchdown position at its touchdown time. Returns 0 when the schedule does not reach that far.
+int LegEventS(Schedule &S, int i, int e, float Vec[3])
+{
+	int lo; int stand; int td;
+	legPositions(i,lo,stand,td);
+	if (e/2>=S.count){return 0;}
+	const vector<float> &V = ScheduleAt(S,e/2);
+	if (e%2==0)
+	{
+		Vec[0] = lo; Vec[1] = V[i+6]; Vec[2] = 3;
+	}
+	else
+	{
+		Vec[0] = td; Vec[1] = V[i]; Vec[2] = 3;
+	}
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Sends every leg its current command (the one SendVecUpdaterS would send, it empties the queue of the leg) followed by the commands of the
+// next *strides* strides, which the leg queues (update value LEG_UPDATE_QUEUE) and starts one after the other when the command before reaches
+// its time. Everything goes in one batch, so the bus only has to be on time once per burst instead of at every lift off and touchdown.
+// A leg gets at most LEG_QUEUE_BURST commands. A leg that is told to stand (phase 0) gets no queue. Use this instead of SendVecUpdaterS,
+// not next to it: every command SendVecUpdaterS sends empties the queues. Returns the amount of commands of the leg with the fewest.
+int QueueStrides(Schedule &S,double time,const vector<int> &ard,int strides,vector<float> &SendVec)
+{
+	uint8_t Frames[6*LEG_QUEUE_BURST][8];
+	BusWrite Writes[6*LEG_QUEUE_BURST];
+	int count = 0; int fewest = LEG_QUEUE_BURST;
+	const vector<float> &CurVec = ScheduleAt(S,0);
+	const vector<float> &NextVec = ScheduleAt(S,1);
+	for (int i=0;i<6;i++)
+	{
+		float Vec[3];
+		LegVecS(S.PrevVec,CurVec,NextVec,time,i,Vec);
+		SendVec[i] = Vec[0];
+		SendVec[i+6] = Vec[1];
+		int phase = LegPhaseS(S.PrevVec,CurVec,NextVec,time,i);
+		int n = (phase==0) ? 1 : 1+2*strides;			// The current command, then a lift off and a touchdown per stride
+		if (n>LEG_QUEUE_BURST){n=LEG_QUEUE_BURST;}
+		for (int k=0;k<n;k++)
+		{
+			if (k>0 && LegEventS(S,i,phase-1+k,Vec)==0){n=k;break;}	// Phase 1 starts at command 0, phase 2 at 1, phase 3 at 2
+			MotionFrame(Vec,Frames[count]);
+			Frames[count][7] = (k==0) ? 1 : LEG_UPDATE_QUEUE;
+			Writes[count].fd = ard[i]; Writes[count].reg = 30; Writes[count].data = Frames[count]; Writes[count].n = 8;
+			count++;
+		}
+		if (n<fewest){fewest=n;}
+	}
+	forgetFrames();							// The shadow of SendFrames does not know about the queued commands
+	i2cWriteBatch(Writes,count);
+	return fewest;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads the queue depth of all six legs in one batch, into Depth (-1 for a leg that did not answer)
+int LegQueueDepth(const vector<int> &ard, int Depth[6])
+{
+	uint8_t Data[6];
+	BusRead Reads[6];
+	for (int i=0;i<6;i++)
+	{
+		Reads[i].fd = ard[i]; Reads[i].reg = LEG_QUEUE_DEPTH_REG; Reads[i].data = &Data[i]; Reads[i].n = 1;
+	}
+	i2cReadBatch(Reads,6);
+	int answered = 0;
+	for (int i=0;i<6;i++)
+	{
+		Depth[i] = (Reads[i].result<0) ? -1 : Data[i];
+		answered += (Reads[i].result>=0);
+	}
+	return answered;
+}
+
+// Empties the queues of all legs (the commands they are doing are kept)
+void LegQueueFlush(const vector<int> &ard)
+{
+	i2cWrite(ard[6],LEG_QUEUE_FLUSH_REG,1);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Compares the queue of every simulated leg with the commands QueueStrides should have queued (LegEventS after the current one) and
+// the depth the leg reports (LegQueueDepth). Returns the amount of legs that differ.
+static long checkQueues(SimBus *sim, Schedule &S, double time, const vector<int> &ard, int strides)
+{
+	long wrong = 0;
+	int Depth[6];
+	LegQueueDepth(ard,Depth);
+	for (int i=0;i<6;i++)
+	{
+		const vector<float> &CurVec = ScheduleAt(S,0);
+		const vector<float> &NextVec = ScheduleAt(S,1);
+		int phase = LegPhaseS(S.PrevVec,CurVec,NextVec,time,i);
+		uint8_t Expected[SIM_QUEUE_SIZE][8];
+		int expected = 0;
+		for (int k=1;phase!=0 && k<1+2*strides && k<LEG_QUEUE_BURST;k++)
+		{
+			float Vec[3];
+			if (LegEventS(S,i,phase-1+k,Vec)==0){break;}
+			MotionFrame(Vec,Expected[expected]);
+			expected++;
+		}
+		uint8_t Queue[SIM_QUEUE_SIZE][8];
+		int queued = sim->queued(ard[i],Queue);
+		int same = (queued==expected && Depth[i]==expected);
+		for (int k=0;k<queued && same==1;k++)
+			same = (memcmp(Queue[k],Expected[k],7)==0);		// Registers 30-36, the update value was 2 for all of them
+		if (same==0)
+		{
+			cout << " Leg " << i << ": " << queued << " commands queued (depth " << Depth[i] << "), expected " << expected;
+			cout << ((queued==expected) ? " in another order \n" : " \n");
+			wrong++;
+		}
+	}
+	return wrong;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The self check of ./Walking queuecheck [strides]. On simulated legs QueueStrides queues *strides* strides, which have to be in the
+// queues in order with the right depth. LegQueueFlush has to empty every queue. Then the burst is sent again while two legs do not
+// acknowledge one of their writes (a queued command of one leg, the current command of another): after the retries the queues have to be
+// the same as without the NACKs. Returns the amount of legs that differ.
+long QueueCheck(int strides)
+{
+	SimBus *sim = new SimBus(0);
+	BusSet(sim);
+	vector<int> ard = DiscoverLegs();
+	if (ard.size() == 0)
+	{
+		cout << "\n Queue check: the simulated legs were not found \n";
+		return 1;
+	}
+	Schedule S; ScheduleInit(S, gait(QUEUE_CHECK_SPEED), vector<float>(12, 0), SCHEDULE_DEFAULT_SIZE);
+	ScheduleShift(S, QUEUE_CHECK_START);		// The commands lie ahead of the clocks of the legs, so none of them is started during the check
+	double time = QUEUE_CHECK_START + 0.5;
+	vector<float> SendVec(12, 0);
+	long wrong = 0;
+
+	int fewest = QueueStrides(S, time, ard, strides, SendVec);
+	long queued = checkQueues(sim, S, time, ard, strides);
+	LegQueueFlush(ard);
+	int Depth[6]; int flushed = 0;
+	LegQueueDepth(ard, Depth);
+	for (int i = 0; i < 6; i++)
+		flushed += (Depth[i] == 0);
+	if (flushed != 6)
+		cout << " Flush: " << 6 - flushed << " legs still have commands queued \n";
+
+	sim->failWrites(ard[0], 2, 1);			// The second queued command of leg 0
+	sim->failWrites(ard[3], 0, 1);			// The current command of leg 3
+	QueueStrides(S, time, ard, strides, SendVec);
+	long nacked = checkQueues(sim, S, time, ard, strides);
+	wrong = queued + (6 - flushed) + nacked;
+
+	cout << "\n Queue check: " << strides << " strides, at least " << fewest << " commands per leg, " << queued << " legs differ, " << flushed
+	     << " of 6 flushed, " << nacked << " legs differ after a NACK in the burst \n";
+	return wrong;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Calculates the lift off and touchdown data that needs to be send, but does not send it. This function is made to reduce the amount of sent instructions
+vector<float> SendVecCalc(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard)
+{
+        vector<float> Vec(3,0);
+        vector<float> OutSendVec(12,0);
+        for (int i=0;i<6;i++)
+        {
+                Vec[0] =0;Vec[1]=0;Vec[2]=0;
+                if (time<CurVec[i+6])
+                {
+                        Vec[0] = CurVec[i+6]; Vec[1] = CurVec[i]; Vec[2]=3; // Vec[0] = liftoff, Vec[1] = touchdown, Vec[2] = mode aperandi
+                }
+                else if (time<CurVec[i] && time>=CurVec[i+6])
+                {
+                        Vec[0] = NextVec[i+6]; Vec[1] = CurVec[i]; Vec[2] = 3;
+                }
+                else if (time>=CurVec[i] &&  time<=NextVec[i+6])
+                {
+                        Vec[0] = NextVec[i+6]; Vec[1]= NextVec[i]; Vec[2] = 3;
+                }
+                else
+                {
+                        cout<< " Error in SendVecCalculator";
+                }
+                OutSendVec[i] = Vec[0]; 
+                OutSendVec[i+6]=Vec[1]; 
+        }
+        return OutSendVec;
+}
+//-----------------------------------------------------------------------------------------------------------------------------
+// Splits the broadcast frame over the buses when the legs are on more than one (see SendFrames). A bus gets the mode, the slices of its
+// own legs and the update register, in two writes of one batch: from register 170 up to the last slice in front, and from the first
+// slice at the back up to 195, split where that leaves out the most registers (or the whole frame when that is shorter). The front part
+// of every bus is made longer until all buses have as many bytes as the busiest one, so they finish together and the legs start together.
+static void connectLanes()
+{
+	laneFrame = 0;
+	if (RecorderMode()!=RECORDER_OFF || BusGet()->lanes()<2){return;}	// A recording keeps the traffic of one bus
+	int lanes = (BusGet()->lanes()<MULTIBUS_LANES_MAX) ? BusGet()->lanes() : MULTIBUS_LANES_MAX;
+	int Bytes[MULTIBUS_LANES_MAX];
+	for (int l=0;l<lanes;l++)
+	{
+		int Slices[6]; int slices = 0;
+		for (int slice=0;slice<6;slice++)
+		{
+			for (int i=0;i<6;i++)
+			{
+				if (legLanes[i]==l && (legAdresses[i]-0x10)/2==slice){Slices[slices] = slice; slices++; break;}
+			}
+		}
+		lanePrefix[l] = 0; laneSuffix[l] = 0; Bytes[l] = 0;
+		if (slices==0){continue;}
+		lanePrefix[l] = BROADCAST_FRAME_SIZE; Bytes[l] = 2+BROADCAST_FRAME_SIZE;
+		for (int t=0;t<=slices;t++)
+		{
+			int prefix = 1 + ((t>0) ? 4*(Slices[t-1]+1) : 0);		// The mode up to slice t-1
+			int suffix = 1 + ((t<slices) ? 4*(6-Slices[t]) : 0);		// Slice t up to the update register
+			if (2+prefix+2+suffix < Bytes[l])
+			{
+				lanePrefix[l] = prefix; laneSuffix[l] = suffix; Bytes[l] = 2+prefix+2+suffix;
+			}
+		}
+		if (Bytes[l]>laneFrame){laneFrame = Bytes[l];}
+		laneBroadcast[l] = i2cSetup(0x00,l);
+	}
+	for (int l=0;l<lanes;l++)
+	{
+		if (Bytes[l]>0){lanePrefix[l] += laneFrame-Bytes[l];}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Connects the legs to the right I2C adresses, leg i on bus legBus[i] of the backend (see MultiBus.cpp). The broadcast address is on every bus.
+vector <int>  connectLegs(const vector<int> &legBus)
+{
+	vector<int> ard (7,0);
+	for (int i=0;i<6;i++){legLanes[i] = (legBus[i]>=0 && legBus[i]<6) ? legBus[i] : 0;}
+	ard[0] = i2cSetup(legAdresses[0],legBus[0]); // Left front leg
+	ard[1] = i2cSetup(legAdresses[1],legBus[1]); // Right front leg
+	ard[2] = i2cSetup(legAdresses[2],legBus[2]); // Left middle leg
+	ard[3] = i2cSetup(legAdresses[3],legBus[3]); // Right middle leg
+	ard[4] = i2cSetup(legAdresses[4],legBus[4]); // Left hind leg
+	ard[5] = i2cSetup(legAdresses[5],legBus[5]); // Right hind leg
+	ard[6] = i2cSetup(0x00); // Adress to send a command to all legs simultanuously
+	connectLanes();
+	return ard;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Finds the legs instead of assuming them: every position of the ZebroBus (0x10-0x1b) is probed on every bus, all in one batch read
+// of registers 1-7 (on more buses the buses are probed at the same time, see MultiBus.cpp). A leg answers with its product id (1),
+// software version (4), side (6) and position (7). The legs of every side are taken from front to hind in the order of their
+// position, so the standard robot (left 0, 2, 4, right 6, 8, 10) gets the same ard as connectLegs. Positions that do not answer
+// cost one address byte each. When a side does not have three legs, the found legs are printed and an empty vector is returned,
+// so the program stops before it walks with a leg missing. The handles of the positions without a leg are not used again.
+vector<int> DiscoverLegs()
+{
+	const char *discover = getenv("ZEBRO_DISCOVER");
+	if (discover != NULL && string(discover) == "off")
+		return connectLegs();
+
+	auto start = std::chrono::steady_clock::now();
+	int buses = (RecorderMode()==RECORDER_REPLAY) ? 1 : BusGet()->lanes();
+	int probes = buses*DISCOVER_POSITIONS;
+	int Fds[MULTIBUS_LANES_MAX*DISCOVER_POSITIONS]; uint8_t Data[MULTIBUS_LANES_MAX*DISCOVER_POSITIONS][DISCOVER_SIZE];
+	BusRead Reads[MULTIBUS_LANES_MAX*DISCOVER_POSITIONS];
+	for (int k=0;k<probes;k++)
+	{
+		Fds[k] = i2cSetup(DISCOVER_FIRST + k%DISCOVER_POSITIONS, (buses>1) ? k/DISCOVER_POSITIONS : -1);
+		Reads[k].fd = Fds[k]; Reads[k].reg = DISCOVER_REG; Reads[k].data = Data[k]; Reads[k].n = DISCOVER_SIZE;
+	}
+	i2cReadBatch(Reads,probes);
+
+	int Probe[DISCOVER_POSITIONS]; int ok = 1;
+	for (int p=0;p<DISCOVER_POSITIONS;p++){Probe[p] = -1;}
+	for (int k=0;k<probes;k++)
+	{
+		int p = k%DISCOVER_POSITIONS;
+		if (Reads[k].result<0 || Data[k][0]!=DISCOVER_PRODUCT_ID){continue;}
+		if (Probe[p]>=0)
+		{
+			cout << "\n Legs: position " << p << " answers on bus " << Probe[p]/DISCOVER_POSITIONS << " and on bus " << k/DISCOVER_POSITIONS;
+			ok = 0;
+		}
+		if (Data[k][6]!=p || Data[k][5]>1)
+		{
+			cout << "\n Legs: the leg at address " << DISCOVER_FIRST+p << " says it is at position " << (int) Data[k][6] << ", side " << (int) Data[k][5];
+			ok = 0;
+		}
+		Probe[p] = k;
+	}
+
+	vector<int> ard (7,-1);
+	int Count[2] = {0,0}; int even = 1;
+	for (int p=0;p<DISCOVER_POSITIONS;p++)
+	{
+		int k = Probe[p];
+		if (k<0){continue;}
+		int side = Data[k][5] & 1;
+		if (Count[side]==3)
+		{
+			cout << "\n Legs: more than three legs on the " << ((side==0) ? "left" : "right") << " side (position " << p << ")";
+			ok = 0;
+			continue;
+		}
+		int i = 2*Count[side] + side;				// The odd legs are on the right side
+		ard[i] = Fds[k]; legLanes[i] = k/DISCOVER_POSITIONS;
+		{
+			std::lock_guard<std::mutex> guard(busLock);
+			legAdresses[i] = DISCOVER_FIRST + p; fdLegs[Fds[k]] = i;
+		}
+		even = even && (p%2==0);
+		Count[side]++;
+	}
+	ard[6] = i2cSetup(0x00);
+
+	double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	printf("\n Legs: %d left and %d right found in %.1f ms:", Count[0], Count[1], took*1000);
+	const char *separator = "";
+	for (int i=0;i<6;i++)
+	{
+		if (ard[i]<0){continue;}
+		int k = Probe[legAdresses[i]-DISCOVER_FIRST];
+		printf("%s %s%d 0x%02x bus %d sw %d", separator, (i%2==0) ? "L" : "R", i/2, legAdresses[i], legLanes[i], Data[k][3]);
+		separator = ",";
+	}
+	cout << " \n";
+	if (ok==0 || Count[0]<3 || Count[1]<3)
+	{
+		cout << " Legs: expected three legs on each side, stopping (ZEBRO_DISCOVER=off connects the six standard addresses without checking) \n";
+		return vector<int>();
+	}
+	if (even==0 && broadcastFrames()==1)
+	{
+		cout << " Legs: a leg is on an odd position, which has no slice in the broadcast frame, so every leg gets its own command \n";
+		broadcastMode = 0;
+	}
+	connectLanes();
+	return ard;
+}
+
+// The bus of every leg (see MultiBusLane)
+vector<int> LegBuses(int buses)
+{
+	vector<int> legBus (6,0);
+	for (int i=0;i<6;i++){legBus[i] = MultiBusLane(i,buses);}
+	return legBus;
+}
+
+vector <int>  connectLegs()  // Function to connect the legs to give the legs an adress that the PI can operate with
+{
+	int buses = (RecorderMode()==RECORDER_REPLAY) ? 1 : BusGet()->lanes();
+	return connectLegs(LegBuses(buses));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The stride update benchmark for more buses: the legs on 1, 2 and 3 simulated buses (sim:50:90, 100 kHz), *strides* stride updates
+// in which every leg gets a new command, sent as SendFrames chooses (broadcast frame or batch) and with ZEBRO_FRAMES=unicast. Prints the average and longest update per setup.
+void BusBenchmark(int strides)
+{
+	const int Legs[6] = {1,1,1,1,1,1};
+	cout << "\n Stride update latency, " << strides << " updates of six new leg commands: \n";
+	for (int buses=1;buses<=3;buses++)
+	{
+		string spec = "sim:50:90";
+		for (int b=1;b<buses;b++){spec += ",sim:50:90";}
+		Bus *bus = BusOpen(spec);
+		BusSet(bus);
+		vector<int> ard = connectLegs(LegBuses(buses));
+		for (int mode=1;mode>=0;mode--)
+		{
+			broadcastMode = mode;
+			forgetFrames();
+			double total = 0; double most = 0;
+			uint8_t Frames[6][8];
+			for (int k=0;k<strides;k++)
+			{
+				float Vec[3] = {0,0,1};
+				for (int i=0;i<6;i++)
+				{
+					Vec[0] = (float) ((k*37+i*151)%910); Vec[1] = k*0.05f + i*0.01f;	// Every leg a different command every update
+					MotionFrame(Vec,Frames[i]);
+				}
+				auto start = std::chrono::steady_clock::now();
+				SendFrames(Frames,Legs,ard);
+				double took = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				total += took;
+				if (took > most){most = took;}
+			}
+			printf(" %d bus%s, %-9s: %6.0f us average, %6.0f us longest \n", buses, (buses==1) ? "  " : "es", (mode==1) ? "default" : "unicast", total/strides*1e6, most*1e6);
+		}
+		BusSet(NULL);
+		delete bus;
+	}
+	broadcastMode = -1;
+	forgetFrames();
+}
+//-----------------------------------------------------------------------------------------------------------------------------
+// Rewrites the telemetry registers of a leg (110-113) in the angle in degrees (0 to 360), the direction and the current step
+void TelemetryStat(const uint8_t Data[TELEMETRY_SIZE], int pos, int Stat[3]) //1 = right , 0 = left
+{
+	int TotAngle = Data[0]*256 + Data[1];		// The encoder position, high byte first (encoder.c)
+	if (pos == 1)					//       2pi/0 (360/0)
+	{						//             |
+		TotAngle = 910-TotAngle;		//1/2*pi(90)---|-----3/2*pi (270)
+	}						//	       |
+	double CalcAngle =(double) TotAngle/910*360;    //	    pi(180)
+	Stat[0] = (int) floor(CalcAngle); Stat[1] = Data[2]; Stat[2] = Data[3];	// Angle, direction (112), current step (113)
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads the angles to of the legs, and rewrites them in degrees (0 to 360)
+vector<int> readAngleState(int adress, int pos) //1 = right , 0 = left
+{
+	uint8_t Data[TELEMETRY_SIZE];
+	vector <int> Stat (3,-1);
+	if (i2cReadBlock(adress, TELEMETRY_REG, Data, TELEMETRY_SIZE) == 0)	// Angle (110 & 111), direction (112) and current step (113) in one read
+	{
+		TelemetryStat(Data, pos, &Stat[0]);
+	}
+	return Stat;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads the angle, direction and step state of all six legs in one batch (one I2C transaction when the bus can do it, see Bus.cpp)
+int PollLegs(const vector<int> &ard, int Stat[6][3])
+{
+	uint8_t Data[6][TELEMETRY_SIZE];
+	BusRead Reads[6];
+	for (int i=0;i<6;i++)
+	{
+		Reads[i].fd = ard[i]; Reads[i].reg = TELEMETRY_REG; Reads[i].data = Data[i]; Reads[i].n = TELEMETRY_SIZE;
+	}
+	i2cReadBatch(Reads,6);
+	int answered = 0;
+	for (int i=0;i<6;i++)
+	{
+		if (Reads[i].result == 0)
+		{
+			TelemetryStat(Data[i], i%2, Stat[i]);		// The odd legs are on the right side (see connectLegs)
+			answered++;
+		}
+		else
+		{
+			Stat[i][0] = -1; Stat[i][1] = -1; Stat[i][2] = -1;
+		}
+	}
+	return answered;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// This function checks if the legs are in the correct place. They should listen to what I say.
+// All six legs are read with one PollLegs call, so checking every leg costs one bus transaction (42 bytes, about 4 ms at 100 kHz).
+int LegCheck(const vector<float> &CurVec, const vector<float> &NextVec,double time, const vector<int> &ard, int curStat[6])
+{
+	int tda=140;int loa=95; int deltaa =10;
+	int Stat[6][3];
+	int inPlace = 0;
+	PollLegs(ard,Stat);
+	legChecks++;
+	for (int i=0;i<6;i++)
+        {
+		int *legStat = Stat[i];
+		curStat[i]=0;
+		if (legStat[0]<0)
+		{
+			legSilent[i]++;						// The leg did not answer
+			continue;
+		}
+                if (time<CurVec[i+6] &&  (legStat[0]<(tda+deltaa) || legStat[0]>(loa- deltaa)))
+                {
+                        curStat[i]=1;
+                }
+                else if (time<CurVec[i] && time>=CurVec[i+6]&& (legStat[0]>(tda-deltaa) && legStat[0]<(loa+deltaa)))
+                {
+                        curStat[i]=1;
+                }
+                else if (time>=CurVec[i] &&  time<=NextVec[i+6] && (legStat[0]<(tda+deltaa) || legStat[0]>(loa-deltaa)))
+                {
+                        curStat[i]=1;
+                }
+                else
+                {
+                        legMisplaced[i]++;					// Too slow or other error in the leg
+                }
+		inPlace += curStat[i];
+	}
+	return inPlace;
+}
+
+vector<int> LegCheck(const vector<float> &CurVec, const vector<float> &NextVec,double time, const vector<int> &ard)
+{
+	vector<int> curStat(6,0);
+	LegCheck(CurVec,NextVec,time,ard,&curStat[0]);
+	for (int i=0;i<6;i++)
+	{
+		if (curStat[i]==0){cout<<" Too slow or other error in leg   " << i << "     Curvec     " << CurVec[i];}
+	}
+	return curStat;
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Same as LegCheck, but takes CurVec and NextVec from the lookahead schedule
+int LegCheck(Schedule &S,double time, const vector<int> &ard, int curStat[6])
+{
+	return LegCheck(ScheduleAt(S,0),ScheduleAt(S,1),time,ard,curStat);
+}
+
+vector<int> LegCheck(Schedule &S,double time, const vector<int> &ard)
+{
+	return LegCheck(ScheduleAt(S,0),ScheduleAt(S,1),time,ard);
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// Prints the amount of checks, and per leg how often it was out of place and how often it did not answer
+void LegCheckPrintStats()
+{
+	cout << "\n Legs: " << legChecks << " checks, out of place/no answer per leg";
+	for (int i=0;i<6;i++)
+		cout << " " << legMisplaced[i] << "/" << legSilent[i];
+	cout << " \n";
+}
+
+//----------------------------------------------------------------------------------------------------------------------------
+// This function uses the input to start a special operation, like calibrating or stopping
+int SpecOps(int ch, const vector<int> &ard, uint8_t syncTime) // hoi
+{
+	int walkingstop ;
+		if (ch==99 || ch==122 || ch==32 || ch==114 || ch==101)
+		{
+			forgetFrames();				// The legs get another command than the last stride command, a stride command that was taken before is not sent anymore
+		}
+		if (BusWorkerGet()!=NULL && (ch==115 || ch==99 || ch==122 || ch==32 || ch==114))
+		{
+			BusWorkerDrop(*BusWorkerGet());		// Priority: the stride commands that are still waiting may not overrule these commands, and the send in flight is finished first
+		}
+		if ( ch== 115)		// Stop Walking
+		{
+			walkingstop = 0;
+			cout<<  "         Stop Sending New Data";
+		}
+		if (ch ==99) 	// Calibrate
+		{
+			
+			i2cWrite(ard[6],30,1);
+			i2cWrite(ard[6],37,1);
+			cout<<  "         Calibrate";
+		}
+		if (ch ==122) 	// Standup
+		{
+			vector<float> PosVec(1,0);
+			PosVec[0] = 610;
+			uint8_t writeTime = (uint8_t) syncTime;
+			vector<unsigned int> PosiVec = rewritePos(PosVec);
+			uint8_t Data[8] = {2,(uint8_t) PosiVec[0],(uint8_t) PosiVec[1],(uint8_t) (writeTime+3),0,1,0,1}; 
+			i2cWriteBlock(ard[6],30,Data,8);	// Registers 30-37 to all legs in one transaction
+
+			cout<<  "         Stand Up";
+		}
+		if (ch ==101)
+		{
+		        // Reset Emergency Stop
+ 		       i2cWrite (ard[6], 22, 0x12) ;
+			cout<<  "         Reset Emergency Stop";
+
+		}
+		if (ch == 32)
+		{
+			// Stop Moving
+			i2cWrite (ard[6], 30, 255) ;
+			i2cWrite (ard[6], 37, 1) ;
+			walkingstop =0;
+			cout<< "       PANIC STOP"  ;
+		}
+		if (ch == 114)
+                {
+                        // Go back to the idle state
+                        i2cWrite (ard[6], 30, 0) ;
+                        i2cWrite (ard[6], 37, 1) ;
+                        walkingstop =0;
+                        cout<< "       RESET"  ;
+                }
+
+	return walkingstop;
+}
+
+
+
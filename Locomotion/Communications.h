@@ -1,46 +1,133 @@
-#ifndef COMMUNICATIONS_H
-#define COMMUNICATIONS_H
-
-#include <iostream>
-#include <sys/types.h>
-#include <sys/time.h>
-#include <vector>
-#include <wiringPi.h>
-#include <time.h>
-#include <ctime>
-#include <chrono>
-#include <thread>
-#include <wiringPiI2C.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <math.h>
-#include <ncurses.h> 
-#include <termios.h>
-#include <fcntl.h>
-#include "MaxPlusCalc.h"
-#include "Gaits.h"
-#include "Decisions.h"
-#include "Supporting.h"
-#include "Communications.h"
-using namespace std;
-
-vector<unsigned int> rewriteTime(vector<float> Vec);
-
-void SendToLeg(vector<float> Vec,double time,int adress);
-
-vector<float> SendVecUpdater(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard);
-
-vector<float> SendVecUpdaterS(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard);
-
-vector<float> SendVecCalc(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard);
-
-vector <int>  connectLegs();
-
-vector<int> readAngleState(int adress, int pos);
-
-vector<int> LegCheck(vector<float> CurVec, vector<float> NextVec,double time, vector<int> ard);
-
-int SpecOps(int ch, vector<int> ard, uint8_t syncTime);
-
-#endif
+#ifndef COMMUNICATIONS_H
+#define COMMUNICATIONS_H
+
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h> 
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Bus.h"
+using namespace std;
+
+#define BROADCAST_FRAME_REG 170		// VREGS_BROADCAST_MODE of the leg firmware: mode, 4 bytes per leg, VREGS_BROADCAST_UPDATE (195)
+#define BROADCAST_FRAME_SIZE 26
+#define TELEMETRY_REG 110		// VREGS_ENCODER_POSITION_A of the leg firmware: position (high byte first), direction, FSM flag (110-113)
+#define TELEMETRY_SIZE 4
+#define SEND_REFRESH 8			// Every 8th stride update sends the commands of all legs, also the ones that did not change
+#define LEG_QUEUE_SIZE 8		// MOTION_QUEUE_SIZE of the leg firmware: motion commands a leg can hold after the current one
+#define LEG_QUEUE_DEPTH_REG 38		// VREGS_MOTION_QUEUE_DEPTH: amount of queued commands
+#define LEG_QUEUE_FLUSH_REG 39		// VREGS_MOTION_QUEUE_FLUSH: 1 empties the queue
+#define LEG_UPDATE_QUEUE 2		// MOTION_UPDATE_QUEUE: register 37 with this value queues the command instead of starting it
+#define LEG_QUEUE_BURST 6		// Most commands per leg in one QueueStrides burst: 6 x 8 registers fit in the 49 write requests a leg buffers, 6 x 6 legs in one batch
+#define QUEUE_CHECK_STRIDES 2		// ./Walking queuecheck: strides queued per leg
+#define QUEUE_CHECK_SPEED 50		// ./Walking queuecheck: speed of the gait that is queued
+#define QUEUE_CHECK_START 10		// ./Walking queuecheck: seconds the schedule starts after the clocks of the simulated legs
+#define DISCOVER_FIRST 0x10		// ADDRESS_ZEBROBUS_OFFSET of the leg firmware: address of position 0
+#define DISCOVER_POSITIONS 12		// ADDRESS_NUMBER_OF_POSITIONS: positions 0-5 on the left, 6-11 on the right
+#define DISCOVER_REG 1			// VREGS_PRODUCT_ID, read up to VREGS_LEG_ADDRESS: product id, version, serial, software version, address, side, position
+#define DISCOVER_SIZE 7
+#define DISCOVER_PRODUCT_ID 1		// GLOBALS_PRODUCT_ID of the leg firmware
+
+int i2cSetup(int adress); // Opens the I2C device of a leg (on the bus of Bus.cpp, recorded)
+
+int i2cSetup(int adress, int bus); // Same, on bus *bus* of the backend (see MultiBus.cpp)
+
+int i2cWrite(int fd, int reg, int data); // Writes a register of a leg (recorded). Returns -1 if the leg did not answer, also after the retries
+
+int i2cWriteBlock(int fd, int reg, const uint8_t *data, int n); // Writes n registers of a leg from reg on, in one transaction (recorded). Returns -1 if the leg did not answer
+
+int i2cWriteBatch(BusWrite *writes, int count); // Does several block writes (to different legs) in one transaction when the bus can (recorded). Returns -1 if a leg did not answer
+
+int i2cRead(int fd, int reg); // Reads a register of a leg (recorded or replayed)
+
+int i2cReadBlock(int fd, int reg, uint8_t *data, int n); // Reads n registers of a leg from reg on, in one transaction (recorded or replayed). Returns -1 if the leg did not answer
+
+int i2cReadBatch(BusRead *reads, int count); // Does several block reads (from different legs) in one transaction when the bus can (recorded or replayed). Returns -1 if a leg did not answer
+
+void i2cPrintStats(); // Prints the bus transactions, bytes, syscalls and time, and the time and syscalls per stride update
+
+void rewriteTime(const float Vec[], unsigned int Time[4]); // Lift off and touchdown time -> whole seconds and ms/4 (into Time)
+
+vector<unsigned int> rewriteTime(vector<float> Vec);
+
+void rewritePos(const float Vec[], unsigned int Pos[2]); // Position -> the two position bytes (into Pos)
+
+vector<unsigned int> rewritePos(vector<float> Vec);
+
+void MotionFrame(const float Vec[3], uint8_t Data[8]); // Makes the 8 bytes of a motion command (registers 30-37)
+
+void BroadcastFrame(uint8_t Frames[6][8], uint8_t Frame[BROADCAST_FRAME_SIZE]); // Puts the motion commands of the six legs in one broadcast frame (registers 170-195)
+
+void SendToLeg(const float Vec[3],int adress);
+
+void SendFrames(uint8_t Frames[6][8], const int Legs[6], const vector<int> &ard); // Sends the motion commands of the legs with Legs[i] = 1 that changed since the last one: one broadcast frame or one batch
+
+vector<float> SendVecUpdater(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard);
+
+void SendVecUpdaterS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,const vector<int> &ard,vector<float> &SendVec); // Sends the commands, and writes what was sent in SendVec (12 long, no allocation)
+
+vector<float> SendVecUpdaterS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,const vector<int> &ard);
+
+void SendVecUpdaterS(Schedule &S,double time,const vector<int> &ard,vector<float> &SendVec); // Same, but reads the vectors from the lookahead schedule
+
+void LegVecS(const vector <float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,int i,float Vec[3]); // The position, time and mode SendVecUpdaterS sends to leg i (into Vec)
+
+int LegEventS(Schedule &S, int i, int e, float Vec[3]); // Command e of leg i from the lift off of CurVec on (2k = lift off of the vector k strides ahead, 2k+1 = its touchdown). Returns 0 beyond the schedule
+
+int QueueStrides(Schedule &S,double time,const vector<int> &ard,int strides,vector<float> &SendVec); // Sends the current command and queues the next *strides* strides of every leg, in one batch. Returns the fewest commands a leg got
+
+int LegQueueDepth(const vector<int> &ard, int Depth[6]); // Reads the amount of queued commands of all six legs (-1 = no answer). Returns the amount of legs that answered
+
+void LegQueueFlush(const vector<int> &ard); // Empties the queues of all legs
+
+long QueueCheck(int strides); // The check of ./Walking queuecheck: queues, depth and flush of QueueStrides on simulated legs, also with a NACK in the burst. Returns the amount of errors
+
+int LegPhaseS(const vector<float> &PrevVec,const vector<float> &CurVec,const vector<float> &NextVec,double time,int i); // The part of the stride leg i is in (0 = told to stand)
+
+vector<float> SendVecCalc(vector <float> PrevVec,vector<float> CurVec,vector<float> NextVec,double time,vector<int> ard);
+
+vector <int>  connectLegs(); // Connects the legs, spread over the buses of the backend (LegBuses)
+
+vector <int>  connectLegs(const vector<int> &legBus); // Connects the legs, leg i on bus legBus[i]
+
+vector<int> DiscoverLegs(); // Probes every position on every bus and connects the legs that answer. Returns an empty vector when a side does not have three legs (ZEBRO_DISCOVER=off: connectLegs)
+
+vector<int> LegBuses(int buses); // The bus of every leg: ZEBRO_LEGBUS ("0,1,0,1,0,1"), or the left and right legs on two buses, front, middle and hind on three
+
+void BusBenchmark(int strides); // Prints the stride update latency with the legs on 1, 2 and 3 simulated buses
+
+void TelemetryStat(const uint8_t Data[TELEMETRY_SIZE], int pos, int Stat[3]); // Registers 110-113 -> angle in degrees, direction and step state (into Stat)
+
+vector<int> readAngleState(int adress, int pos);
+
+int PollLegs(const vector<int> &ard, int Stat[6][3]); // Reads the angle, direction and step state of all six legs in one transaction. Returns the amount of legs that answered (the Stat of the others is -1)
+
+int LegCheck(const vector<float> &CurVec, const vector<float> &NextVec,double time, const vector<int> &ard, int curStat[6]); // Checks all six legs (1 = in place, into curStat), returns the amount in place. No allocation
+
+vector<int> LegCheck(const vector<float> &CurVec, const vector<float> &NextVec,double time, const vector<int> &ard);
+
+int LegCheck(Schedule &S,double time, const vector<int> &ard, int curStat[6]); // Same, but reads the vectors from the lookahead schedule
+
+vector<int> LegCheck(Schedule &S,double time, const vector<int> &ard);
+
+void LegCheckPrintStats(); // Prints the checks and the legs that were out of place or did not answer
+
+int SpecOps(int ch, const vector<int> &ard, uint8_t syncTime);
+
+#endif
@@ -0,0 +1,282 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Deadline.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE DEADLINE ACCOUNTING
+// Every time the loop sends commands to the legs, each leg whose part of the stride (see LegPhaseS) changed gets a new command.
+// That command should be sent when that part starts; when the loop falls behind (a slow pass, a busy CPU) it is sent later,
+// and the leg has to rush to the next lift off or touchdown, or is told to stand when the schedule is already in the past.
+// A command sent more than DEADLINE_LATE after its start is counted as a miss. When DEADLINE_THRESHOLD misses happen within
+// DEADLINE_WINDOW, the whole schedule is moved forward by the latest miss plus DEADLINE_MARGIN, so the legs continue the same
+// gait a bit later instead of rushing. When the schedule has to be moved DEADLINE_SLOWDOWN times within DEADLINE_SLOW_WINDOW,
+// the loop cannot keep up with this gait, and the next slower gait is asked for.
+// The times are the program times of the loop (the same clock the legs are synchronised to), so a replay makes the same decisions.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Resets the counters
+void DeadlineInit(Deadlines &D)
+{
+	D.lastStart = vector<double>(6, -1);
+	D.commands = vector<long>(6, 0);
+	D.misses = vector<long>(6, 0);
+	D.worst = 0;
+	D.recent = 0; D.recentStart = 0; D.recentWorst = 0;
+	D.moves = 0; D.movesStart = 0;
+	D.rebases = 0; D.slowdowns = 0; D.shifted = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Forgets the last command of every leg. When the robot starts walking, the schedule started long before, so the first commands are always late.
+void DeadlineRestart(Deadlines &D)
+{
+	D.lastStart = vector<double>(6, -1);
+	D.recent = 0; D.recentWorst = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Remembers the start of the part of the stride of every leg. When *count* is 1, new commands are counted and the late ones are misses.
+static void account(Deadlines &D, Schedule &S, double time, int count)
+{
+	const vector<float> &CurVec = ScheduleAt(S, 0);
+	const vector<float> &NextVec = ScheduleAt(S, 1);
+	for (int i = 0; i < 6; i++)
+	{
+		int phase = LegPhaseS(S.PrevVec, CurVec, NextVec, time, i);
+		double start = 0;
+		if (phase == 1) {start = S.PrevVec[i];}		// Since the last touchdown
+		if (phase == 2) {start = CurVec[i + 6];}		// Since the lift off of CurVec
+		if (phase == 3) {start = CurVec[i];}			// Since the touchdown of CurVec
+		if (phase == 0)
+		{
+			if (time <= NextVec[i + 6]) {continue;}		// Before its stride, the leg waits (not late)
+			start = NextVec[i + 6];				// The schedule is in the past, the leg stands
+		}
+		if (start == D.lastStart[i]) {continue;}		// Same command as last time
+		int first = (D.lastStart[i] < 0);			// The first command after (re)starting is never in time
+		D.lastStart[i] = start;
+		if (count == 0) {continue;}
+		D.commands[i]++;
+		double late = time - start;
+		if (first || (late <= DEADLINE_LATE && phase != 0)) {continue;}
+
+		D.misses[i]++;
+		if (late > D.worst) {D.worst = late;}
+		if (time - D.recentStart > DEADLINE_WINDOW)		// A new window
+		{
+			D.recent = 0; D.recentStart = time; D.recentWorst = 0;
+		}
+		D.recent++;
+		if (late > D.recentWorst) {D.recentWorst = late;}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Accounts the commands that were just sent to the legs (from the same schedule and time as SendVecUpdaterS).
+// Moves the schedule forward when too many of them were late, and tells the loop when it should also slow down.
+int DeadlineCheck(Deadlines &D, Schedule &S, double time)
+{
+	account(D, S, time, 1);
+	if (D.recent < DEADLINE_THRESHOLD)
+		return DEADLINE_OK;
+
+	// Too many misses: move the schedule forward so the legs are in time again
+	float shift = D.recentWorst + DEADLINE_MARGIN;
+	ScheduleShift(S, shift);
+	account(D, S, time, 0);					// The commands of the moved schedule are sent right away, they are not late
+	D.rebases++; D.shifted += shift;
+	cout << "\n Deadline: " << D.recent << " late commands within " << DEADLINE_WINDOW << " s (worst " << D.recentWorst * 1000
+	     << " ms), schedule moved " << shift * 1000 << " ms at time " << time << " \n";
+	D.recent = 0; D.recentStart = time; D.recentWorst = 0;
+
+	if (time - D.movesStart > DEADLINE_SLOW_WINDOW)
+	{
+		D.moves = 0; D.movesStart = time;
+	}
+	D.moves++;
+	if (D.moves < DEADLINE_SLOWDOWN)
+		return DEADLINE_REBASE;
+	D.moves = 0; D.movesStart = time;
+	D.slowdowns++;
+	cout << " Deadline: the schedule was moved " << DEADLINE_SLOWDOWN << " times within " << DEADLINE_SLOW_WINDOW << " s, asking for a slower gait \n";
+	return DEADLINE_SLOWER;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The speed of the next slower gait of GaitChangeManual (keys 1, 2 and 3), or 0 when the gait is already the slowest
+int DeadlineSlowerSpeed(int speed)
+{
+	if (speed > 50) {return 50;}
+	if (speed > 25) {return 25;}
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the commands and missed deadlines per leg, and what was done about them
+void DeadlinePrintStats(Deadlines &D)
+{
+	cout << "\n Deadlines: commands/misses per leg";
+	for (int i = 0; i < 6; i++)
+		cout << " " << D.commands[i] << "/" << D.misses[i];
+	cout << ", latest " << D.worst * 1000 << " ms, " << D.rebases << " schedule moves (" << D.shifted * 1000 << " ms in total), "
+	     << D.slowdowns << " slow downs \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// One pass of the walking loop of KiloZebroMain.cpp without the bus: takes the next vector when the current one is over, and accounts
+// the commands when a leg starts a new part of its stride. Returns what DeadlineCheck returned (DEADLINE_OK when nothing was sent).
+static int checkPass(Deadlines &D, Schedule &S, double time, double checktime)
+{
+	int VecChange = 0;
+	if (MaxVec(ScheduleAt(S, 0)) < time)
+	{
+		ScheduleAdvance(S);
+		VecChange = 1;
+	}
+	ScheduleRefill(S, 1);
+	const vector<float> &CurVec = ScheduleAt(S, 0);
+	for (int i = 0; i < 6; i++)
+	{
+		if ((time >= CurVec[i + 6] && checktime <= CurVec[i + 6]) || (time >= CurVec[i] && checktime <= CurVec[i]) || (time >= S.PrevVec[i] && checktime < S.PrevVec[i]))
+			VecChange = 1;
+	}
+	if (VecChange == 0)
+		return DEADLINE_OK;
+	return DeadlineCheck(D, S, time);
+}
+
+static long checkMisses(Deadlines &D)
+{
+	long misses = 0;
+	for (int i = 0; i < 6; i++)
+		misses += D.misses[i];
+	return misses;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The check of ./Walking deadlinecheck [seconds]. Gait 50 is walked with the 10 ms passes of the walking loop for *seconds*, then with
+// passes of DEADLINE_CHECK_SLOW_PASS until the loop is asked to slow down, then in time again for *seconds*. In time, no command may be
+// a miss and the schedule may not move. In the slow loop, every move needs DEADLINE_THRESHOLD misses since the last one and is the
+// latest miss plus DEADLINE_MARGIN, and the slow down comes with move DEADLINE_SLOWDOWN. ScheduleShift must move every time ahead by
+// the shift, and leave the -1 entries (minus infinity) as they are.
+long DeadlineSelfCheck(int seconds)
+{
+	long errors = 0;
+	const double pass = 0.01;
+	Deadlines D; DeadlineInit(D);
+	Schedule S; ScheduleInit(S, gait(50), vector<float>(12, 0), SCHEDULE_DEFAULT_SIZE);
+	double time = 0; double checktime = 0;
+
+	for (long k = 1; k * pass <= seconds; k++)
+	{
+		checktime = time; time += pass;
+		checkPass(D, S, time, checktime);
+	}
+	long commands = 0;
+	for (int i = 0; i < 6; i++)
+		commands += D.commands[i];
+	if (checkMisses(D) != 0 || D.rebases != 0)
+	{
+		cout << " In time: " << checkMisses(D) << " misses and " << D.rebases << " schedule moves, expected none \n";
+		errors++;
+	}
+
+	int moves = 0; int slower = 0; long lastMisses = checkMisses(D);
+	double end = time + DEADLINE_SLOW_WINDOW;
+	while (time < end && slower == 0)
+	{
+		checktime = time; time += DEADLINE_CHECK_SLOW_PASS;
+		double shifted = D.shifted; double worst = D.recentWorst; double windowStart = D.recentStart;
+		int late = checkPass(D, S, time, checktime);
+		if (late == DEADLINE_OK)
+			continue;
+		moves++;
+		if (checkMisses(D) - lastMisses < DEADLINE_THRESHOLD)
+		{
+			cout << " Move " << moves << " after " << checkMisses(D) - lastMisses << " misses, expected at least " << DEADLINE_THRESHOLD << " \n";
+			errors++;
+		}
+		// The latest miss of the window is at least the one before this pass (unless this pass started a new window), and at most the latest of all
+		float shift = D.shifted - shifted;
+		if (time - windowStart > DEADLINE_WINDOW)
+			worst = 0;
+		if (shift < worst + DEADLINE_MARGIN - 1e-4 || shift < DEADLINE_LATE + DEADLINE_MARGIN || shift > D.worst + DEADLINE_MARGIN + 1e-4)
+		{
+			cout << " Move " << moves << " of " << shift * 1000 << " ms, the latest miss of the window was at least " << worst * 1000
+			     << " ms and at most " << D.worst * 1000 << " ms \n";
+			errors++;
+		}
+		if ((late == DEADLINE_SLOWER) != (moves == DEADLINE_SLOWDOWN))
+		{
+			cout << " Move " << moves << " returned " << late << " \n";
+			errors++;
+		}
+		slower = (late == DEADLINE_SLOWER);
+		lastMisses = checkMisses(D);
+	}
+	if (slower == 0)
+	{
+		cout << " The slow loop was not slowed down within " << DEADLINE_SLOW_WINDOW << " s \n";
+		errors++;
+	}
+
+	long misses = checkMisses(D); long rebases = D.rebases;
+	double start = time;
+	while (time < start + seconds)
+	{
+		checktime = time; time += pass;
+		checkPass(D, S, time, checktime);
+	}
+	if (checkMisses(D) != misses || D.rebases != rebases)
+	{
+		cout << " In time after the slow loop: " << checkMisses(D) - misses << " misses and " << D.rebases - rebases << " schedule moves \n";
+		errors++;
+	}
+
+	// ScheduleShift with a -1 in PrevVec and in the vectors ahead
+	vector<float> StartVec(12, 0); StartVec[3] = -1;
+	Schedule T; ScheduleInit(T, gait(50), StartVec, SCHEDULE_DEFAULT_SIZE);
+	T.Vecs[(T.head + 2) % T.Vecs.size()][7] = -1;
+	Schedule Before = T;
+	ScheduleShift(T, 0.25);
+	int wrong = 0;
+	for (int k = -1; k < T.count; k++)
+	{
+		const vector<float> &A = (k < 0) ? Before.PrevVec : ScheduleAt(Before, k);
+		const vector<float> &B = (k < 0) ? T.PrevVec : ScheduleAt(T, k);
+		for (unsigned int j = 0; j < A.size(); j++)
+		{
+			if ((A[j] < 0 && B[j] != A[j]) || (A[j] >= 0 && fabs(B[j] - A[j] - 0.25) > 1e-4))
+				wrong++;
+		}
+	}
+	if (wrong != 0 || T.epoch != Before.epoch + 1)
+	{
+		cout << " ScheduleShift: " << wrong << " times moved wrong, epoch " << Before.epoch << " -> " << T.epoch << " \n";
+		errors++;
+	}
+
+	cout << "\n Deadline check: " << commands << " commands in time, " << moves << " schedule moves in the slow loop ("
+	     << D.shifted * 1000 << " ms in total), slow down " << ((slower == 1) ? "asked" : "missing") << ", " << errors << " errors \n";
+	return errors;
+}
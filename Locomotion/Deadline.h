@@ -0,0 +1,48 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <vector>
+#include "Schedule.h"
+using namespace std;
+
+// HEADER FILE FOR THE DEADLINE ACCOUNTING! See the .cpp file for the extended explanations
+
+#define DEADLINE_LATE 0.03		// A leg command sent more than this (s) after the start of its part of the stride is a miss
+#define DEADLINE_THRESHOLD 3		// Amount of misses within DEADLINE_WINDOW that makes the planner move the schedule
+#define DEADLINE_WINDOW 2.0		// Time (s) in which the misses are counted
+#define DEADLINE_MARGIN 0.05		// Extra time (s) the schedule is moved, so the next commands are in time again
+#define DEADLINE_SLOWDOWN 3		// Amount of schedule moves within DEADLINE_SLOW_WINDOW after which a slower gait is used
+#define DEADLINE_SLOW_WINDOW 20.0	// Time (s) in which the schedule moves are counted
+#define DEADLINE_CHECK_SECONDS 10	// ./Walking deadlinecheck walks this many seconds with a loop that is in time, before and after the slow loop
+#define DEADLINE_CHECK_SLOW_PASS 0.1	// Loop time (s) of the slow loop of the check, far more than DEADLINE_LATE
+
+#define DEADLINE_OK 0			// Nothing to do
+#define DEADLINE_REBASE 1		// The schedule was moved forward
+#define DEADLINE_SLOWER 2		// The schedule was moved forward, and the loop should also use a slower gait
+
+struct Deadlines
+{
+	vector<double> lastStart;	// Start time of the part of the stride of the last command per leg (a new start = a new command)
+	vector<long> commands;		// Amount of new commands per leg
+	vector<long> misses;		// Amount of missed deadlines per leg
+	double worst;			// Latest command so far (s)
+	int recent; double recentStart; double recentWorst;	// Misses in the current window, the start of the window and the latest miss in it
+	int moves; double movesStart;	// Schedule moves in the current slow down window, and the start of that window
+	long rebases;			// Amount of times the schedule was moved
+	long slowdowns;			// Amount of times a slower gait was asked for
+	double shifted;			// Total time (s) the schedule was moved
+};
+
+void DeadlineInit(Deadlines &D); // Resets the counters
+
+void DeadlineRestart(Deadlines &D); // Forgets the last commands, the first commands after (re)starting to walk are not counted as misses
+
+int DeadlineCheck(Deadlines &D, Schedule &S, double time); // Accounts the commands just sent to the legs, moves the schedule when too many were late. Returns DEADLINE_OK, DEADLINE_REBASE or DEADLINE_SLOWER
+
+int DeadlineSlowerSpeed(int speed); // The speed of the next slower gait (0 if there is none)
+
+void DeadlinePrintStats(Deadlines &D); // Prints the commands and misses per leg
+
+long DeadlineSelfCheck(int seconds); // Walks a loop that is in time, then a slow one, then in time again, and checks the misses, schedule moves and slow down. Returns the amount of errors
+
+#endif
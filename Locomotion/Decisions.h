@@ -1,39 +1,39 @@
-#ifndef DECISIONS_H
-#define DECISIONS_H
-
-#include <iostream>
-#include <sys/types.h>
-#include <sys/time.h>
-#include <vector>
-#include <wiringPi.h>
-#include <time.h>
-#include <ctime>
-#include <chrono>
-#include <thread>
-#include <wiringPiI2C.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <math.h>
-#include <ncurses.h> 
-#include <termios.h>
-#include <fcntl.h>
-#include "MaxPlusCalc.h"
-#include "Gaits.h"
-#include "Decisions.h"
-#include "Supporting.h"
-#include "Communications.h"
-using namespace std;
-
-// HEADER FILE FOR THE DECISION MAKER FUNCTION!! See .cpp file for more extensive explanations
-vector<float> VecUpdater(vector<float> CurVec,vector<float> NextVec,double time); // Decides when it is time to change the current vector.
-
-vector <float> CalcTau(int speed);	// Calculates the Tau-vector consisting of t_d (double stance time), t_f (flight time) and t_g (ground time) using the speed required by the Zebro
-
-vector <float> CalcTauTest(int speed);	// Calculates the Tau-vector consisting of t_d (double stance time), t_f (flight time) and t_g (ground time) using the speed required by the Zebro
-
-vector<vector<float> > gait(int speed); // This function calculates the Max-Plus gait matrix used depending on the speed required. 
-
-int GaitChangeManual (int ch);          // Allows for manual gait changes
-#endif
-
+#ifndef DECISIONS_H
+#define DECISIONS_H
+
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h> 
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+using namespace std;
+
+// HEADER FILE FOR THE DECISION MAKER FUNCTION!! See .cpp file for more extensive explanations
+const vector<float> &VecUpdater(const vector<float> &CurVec,const vector<float> &NextVec,double time); // Decides when it is time to change the current vector (returns CurVec or NextVec).
+
+vector <float> CalcTau(int speed);	// Calculates the Tau-vector consisting of t_d (double stance time), t_f (flight time) and t_g (ground time) using the speed required by the Zebro
+
+vector <float> CalcTauTest(int speed);	// Calculates the Tau-vector consisting of t_d (double stance time), t_f (flight time) and t_g (ground time) using the speed required by the Zebro
+
+vector<vector<float> > gait(int speed); // This function calculates the Max-Plus gait matrix used depending on the speed required. 
+
+void gaitParts(int speed, vector<vector<float> > &A0star, vector<vector<float> > &A1); // Calculates A_0* and A_1 of the gait used at the speed required
+
+int GaitChangeManual (int ch);          // Allows for manual gait changes
+#endif
+
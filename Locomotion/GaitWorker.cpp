@@ -0,0 +1,207 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Transition.h"
+#include "GaitWorker.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE GAIT WORKER
+// Calculating a new gait (gait(), KleeneStarOp and the transition planner) takes long enough to delay the leg commands of the loop
+// iteration in which a speed key was pressed. The worker thread does this calculation instead:
+//  - the loop posts a request (speed, the vector to start from and its stride index). It only *tries* to take the lock, and tries
+//    again in the next iteration when the worker holds it, so the loop never waits.
+//  - the worker computes the transition into its own (back) buffer and publishes it by swapping the buffer index with the middle
+//    one in a single atomic operation.
+//  - at the next stride boundary, the loop swaps its (front) buffer with the middle one when the middle one is new.
+// With three buffers the worker and the loop never touch the same buffer, so no side ever waits for the other (RCU-style publishing
+// with a triple buffer; with only two buffers the worker would have to wait until the loop is done reading).
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The worker thread: waits for a request, computes it and publishes the result
+static void work(GaitWorker *W)
+{
+	setpriority(PRIO_PROCESS, syscall(SYS_gettid), GAITWORKER_NICE);	// The loop goes first when both want the same core
+	while (1 == 1)
+	{
+		int speed; vector<float> StartVec; double time; long stride; long epoch;
+		{
+			std::unique_lock<std::mutex> guard(W->lock);
+			W->wake.wait(guard, [W]() { return W->pending == 1 || W->stop == 1; });
+			if (W->stop == 1)
+				return;
+			speed = W->speed; StartVec = W->StartVec; time = W->time; stride = W->stride; epoch = W->epoch;
+			W->pending = 0;
+			W->busy = 1;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		W->buffers[W->back] = PlanTransition(speed, StartVec, time);
+		W->buffers[W->back].stride = stride;
+		W->buffers[W->back].epoch = epoch;
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		W->back = W->middle.exchange(W->back | GAITWORKER_DIRTY) & 3;	// Publish, the old middle buffer becomes the new back buffer
+		{
+			std::lock_guard<std::mutex> guard(W->lock);
+			W->busy = 0;
+			W->jobs++;						// The benchmark is read under the lock as well (GaitWorkerPrintStats)
+			W->workTime += elapsed;
+			if (elapsed > W->workMax)
+				W->workMax = elapsed;
+		}
+		W->idle.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts the worker thread
+void GaitWorkerStart(GaitWorker &W)
+{
+	W.back = 0; W.middle = 1; W.front = 2;
+	W.pending = 0; W.busy = 0; W.stop = 0;
+	W.jobs = 0; W.workTime = 0; W.workMax = 0;
+	W.thread = std::thread(work, &W);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Posts a request for the worker. A newer request replaces a request that was not started yet.
+int GaitWorkerRequest(GaitWorker &W, int speed, const vector<float> &StartVec, double time, long stride, long epoch)
+{
+	std::unique_lock<std::mutex> guard(W.lock, std::try_to_lock);
+	if (!guard.owns_lock())
+		return 0;						// The worker is taking the previous request, try again next loop
+	W.speed = speed; W.StartVec = StartVec; W.time = time; W.stride = stride; W.epoch = epoch;
+	W.pending = 1;
+	guard.unlock();
+	W.wake.notify_one();
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Takes the newest published transition
+GaitTransition *GaitWorkerTake(GaitWorker &W)
+{
+	if ((W.middle.load() & GAITWORKER_DIRTY) == 0)
+		return NULL;						// Nothing new
+	W.front = W.middle.exchange(W.front) & 3;			// The old front buffer goes back to the worker
+	return &W.buffers[W.front];
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Waits until the worker has published the result of every request. When recording or replaying, the loop calls this after each request,
+// so a new gait is always picked up at the same stride (otherwise it depends on how fast the worker happened to be).
+void GaitWorkerFlush(GaitWorker &W)
+{
+	std::unique_lock<std::mutex> guard(W.lock);
+	W.idle.wait(guard, [&W]() { return W.pending == 0 && W.busy == 0; });
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Stops the worker thread
+void GaitWorkerStop(GaitWorker &W)
+{
+	{
+		std::lock_guard<std::mutex> guard(W.lock);
+		W.stop = 1;
+	}
+	W.wake.notify_one();
+	if (W.thread.joinable())
+		W.thread.join();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the amount of computed gait transitions and the average and worst time they took
+void GaitWorkerPrintStats(GaitWorker &W)
+{
+	long jobs; double workTime; double workMax;
+	{
+		std::lock_guard<std::mutex> guard(W.lock);
+		jobs = W.jobs; workTime = W.workTime; workMax = W.workMax;
+	}
+	double average = 0;
+	if (jobs > 0)
+		average = workTime / jobs;
+	cout << "\n Gait worker: " << jobs << " transitions, " << average * 1e6 << " us average, worst " << workMax * 1e6 << " us \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The check of ./Walking gaitcheck [changes]. A loop like the walking loop (without the bus) keeps the schedule, asks the worker for a
+// new speed every few strides and splices the transition in at the stride boundary, as KiloZebroMain.cpp does. Every pass is timed.
+// The passes between a request and the stride where its transition is taken are the passes in which the worker plans; the worst of
+// them may not take longer than GAITWORKER_CHECK_LIMIT. For comparison the time PlanTransition takes in the loop itself is printed.
+int GaitWorkerCheck(int changes)
+{
+	const int speeds[3] = { 25, 50, 75 };
+	Schedule S; ScheduleInit(S, gait(speeds[0]), vector<float>(12, 0), SCHEDULE_DEFAULT_SIZE);
+	GaitWorker W; GaitWorkerStart(W);
+	int done = 0; int requested = 0; int speed = 0; int pass = 0;
+	long planningPasses = 0; double planningWorst = 0; double otherWorst = 0;
+	while (done < changes && pass < changes * 40 * GAITWORKER_CHECK_STRIDE)	// Gives up when the worker is too slow for most strides
+	{
+		auto start = std::chrono::steady_clock::now();
+		double time = pass * GAITWORKER_CHECK_WAIT / 1000.0;
+		if (requested == 0 && pass % (4 * GAITWORKER_CHECK_STRIDE) == 1)	// Within a stride, like a key press
+		{
+			speed = speeds[(done + 1) % 3];
+			requested = GaitWorkerRequest(W, speed, ScheduleAt(S, 1), time, S.index + 1, S.epoch);
+		}
+		if (pass % GAITWORKER_CHECK_STRIDE == 0)
+		{
+			ScheduleAdvance(S);
+			GaitTransition *T = GaitWorkerTake(W);
+			if (T != NULL)
+			{
+				if (T->stride == S.index && T->epoch == S.epoch)
+				{
+					ScheduleSetTransition(S, T->mpm, 0, T->Vecs);
+					done++;
+				}
+				requested = 0;				// Taken, or planned too late: the next request plans again from the new NextVec
+			}
+		}
+		ScheduleRefill(S, 1);
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (requested == 1)
+		{
+			planningPasses++;
+			if (elapsed > planningWorst)
+				planningWorst = elapsed;
+		}
+		else if (elapsed > otherWorst)
+			otherWorst = elapsed;
+		pass++;
+		std::this_thread::sleep_for(std::chrono::milliseconds(GAITWORKER_CHECK_WAIT));
+	}
+	GaitWorkerStop(W);
+
+	auto start = std::chrono::steady_clock::now();
+	PlanTransition(speeds[1], ScheduleAt(S, 1), 0);
+	double inLoop = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	cout << "\n Gait check: " << done << " gait changes in " << pass << " loop passes, " << planningPasses << " while planning \n";
+	cout << " Worst loop pass: " << planningWorst * 1e6 << " us while planning, " << otherWorst * 1e6 << " us otherwise, PlanTransition in the loop would take "
+	     << inLoop * 1e6 << " us \n";
+	GaitWorkerPrintStats(W);
+	return (done == changes && planningWorst <= GAITWORKER_CHECK_LIMIT) ? 1 : 0;
+}
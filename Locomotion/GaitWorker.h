@@ -0,0 +1,56 @@
+#ifndef GAITWORKER_H
+#define GAITWORKER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include "Transition.h"
+using namespace std;
+
+// HEADER FILE FOR THE GAIT WORKER! See the .cpp file for the extended explanations
+
+#define GAITWORKER_DIRTY 4		// Flag next to the buffer index in *middle*: the middle buffer holds a result the loop has not taken yet
+#define GAITWORKER_NICE 10		// Nice value of the worker thread, lower priority than the loop
+#define GAITWORKER_CHECK_CHANGES 60	// Gait changes of ./Walking gaitcheck when it is not given
+#define GAITWORKER_CHECK_WAIT 1		// Time (ms) the check loop waits every pass, like the walking loop (loopWait) but shorter
+#define GAITWORKER_CHECK_STRIDE 5	// Loop passes per stride in the check
+#define GAITWORKER_CHECK_LIMIT 0.00025	// The worst loop pass (s) while a transition is planned may not take longer than this (PlanTransition takes about 0.5 ms)
+
+struct GaitWorker
+{
+	GaitTransition buffers[3];	// Triple buffer: one being written by the worker, one published, one read by the loop
+	int back;			// Buffer the worker writes (only used by the worker)
+	int front;			// Buffer the loop reads (only used by the loop)
+	std::atomic<int> middle;	// Published buffer, swapped atomically by both sides
+
+	std::mutex lock;		// Protects the request and the benchmark, the loop only tries to take it
+	std::condition_variable wake;	// Wakes the worker for a request
+	std::condition_variable idle;	// Wakes GaitWorkerFlush when the worker is done
+	int pending;			// There is a request the worker has not started yet
+	int busy;			// The worker is computing a request
+	int speed; vector<float> StartVec; double time; long stride; long epoch;	// The request (newest request wins)
+	int stop;
+	std::thread thread;
+
+	long jobs;			// Amount of computed transitions (benchmark)
+	double workTime;		// Total time spent computing in seconds (benchmark)
+	double workMax;			// Longest computation in seconds (benchmark)
+};
+
+void GaitWorkerStart(GaitWorker &W); // Starts the worker thread
+
+int GaitWorkerRequest(GaitWorker &W, int speed, const vector<float> &StartVec, double time, long stride, long epoch); // Asks for a transition from StartVec (at stride index *stride* of schedule epoch *epoch*). Never blocks, returns 0 if the request must be tried again
+
+GaitTransition *GaitWorkerTake(GaitWorker &W); // Returns the newest finished transition, or NULL. Never blocks, the result stays valid until the next call
+
+void GaitWorkerFlush(GaitWorker &W); // Waits until all requests are computed and published (keeps recordings reproducible)
+
+void GaitWorkerStop(GaitWorker &W); // Stops and joins the worker thread
+
+void GaitWorkerPrintStats(GaitWorker &W); // Prints the computation benchmark
+
+int GaitWorkerCheck(int changes); // Changes the gait *changes* times through the worker in a loop like the walking loop, returns 0 if a loop pass took longer than GAITWORKER_CHECK_LIMIT while a transition was planned
+
+#endif
@@ -1,132 +1,304 @@
-#include <iostream>
-#include <sys/types.h>
-#include <sys/time.h>
-#include <vector>
-#include <wiringPi.h>
-#include <time.h>
-#include <ctime>
-#include <chrono>
-#include <thread>
-#include <wiringPiI2C.h>
-#include <stdlib.h>
-#include <stdio.h>
-#include <unistd.h>
-#include <math.h>
-#include <ncurses.h> 
-#include <termios.h>
-#include <fcntl.h>
-#include "MaxPlusCalc.h"
-#include "Gaits.h"
-#include "Decisions.h"
-#include "Supporting.h"
-#include "Communications.h"
-using namespace std;
-
-
-
-
-int main()
-{
-	// Asks the operator for a starting speed
-	int i;
-  	cout << "Please enter a starting speed between 5-99: "; // Prints the question
-  	cin >> i;						// Asks input
-	cout << "Starting with speed" << i;
-
-	// Establish connection to the legs
-	vector<int> ard = connectLegs();  // Connects the legs using the I2C adresses defined. Ard contains the adresses
-	
-	// Initialisation of variables	
-	double checktime=0; double time = 0; double oldtime=0;  uint8_t syncTime=0;vector<float> CheckVec(12,0); vector<float> SendHelpVec(3,0); 
-	vector<vector<float> >CurStat; vector<float> CurVec; vector<float> NextVec; vector<float> SendVec(12,0);vector<float> PrevVec; vector<float> MemVec; float HelpVec[12] = {0,0,0,0,0,0,0,0,0,0,0,0};vector<float>Vec = makeVec(HelpVec,12);
-	int ch=0;  int walking = 0;vector<int> readout;vector<int> legCheck (6,0); int VecChange=0;
-	//int a =0;int readout2;int readout3;int uploadcounter=0; int turningleft=0;int turningright=0; int turningcounter=0;
-
-	// Start the time 	
-	auto begin = clock();   		// Defines the starting time of the program
-	auto nu= clock();     			// Defines the current time
-	int timecounter=1; int loopWait =10; 	// Counts the loops and defines the waiting time in loop to not overflow the I2C-bus	
-
-	// Begin the initialisation of speed and gaits
-	int speed= i;int oldspeed=i; 						// Initializes the current speed en starting speed
-	vector <vector <float> > mpm = gait(speed);  				// Calculates the first gait
-	PrevVec= Vec; CurVec = MPMVM(mpm,Vec); NextVec = MPMVM(mpm,CurVec); 	// Defines the first 3 touchdown/liftoff vectors
-
-	
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	//////////////////////////////////////////////////////////////////////LOOPIE///////////////////////////////////////////////////////////////////////
-	///////////////////////////////// Starts the walking LOOP! ////////////////////////////////////////////////////////////////////////////////////////
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	// LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  //
-	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-	
-	while (1==1)
-	{
-		
-		// Check for input
-		ch =0; 			// Resets the character that is being (inputted (?))
-		changemode(1);		// Necessary to record the keyboard hit
- 		 if (kbhit()!=0) // Checks if there was a keyboard hit
-		{	
- 		 ch = getchar();	// Gets the character
- 		}
-
-
-		// Looking at the clock and synchronizing the time
-		nu = clock();								// Defines the current moment
-		oldtime = floor(time);							// Updates the old time
-		checktime = time;							// Makes an old time not floored. 
-		time =((std::difftime(nu,begin)/1000)+ (loopWait)*(timecounter))/1000;  // Calculates the in-program time
-		if (floor(time)!=oldtime)
-		{
-			cout<< floor(time)<< "\n" ;
-			if (walking==1){cout<<"Walking";}
-			syncTime = (uint8_t)floor(time) % 256;				// Calculates the synctime (8-bit)
-			wiringPiI2CWriteReg8 (ard[6], 11, syncTime) ;			// Sends the synctime to the leg
-			// readout = wiringPiI2CReadReg8 (ard[1], 110) ; // 110 111 angles, 112 direction (1,0) , 113 (finitestatemachine flag )
-		}
-
-
-		// Special Input Operations (Stand-Up/Freeze/Stop/TRANSFORM INTO FIGHTING ROBOT)
-		if (ch!=0)
-		{
-			walking = SpecOps(ch, ard, syncTime);
-		}
-
-		// Gait updater
-		speed = GaitChangeManual(ch);				// Changes gait if the input is a certain character
-		if (speed!=oldspeed)
-		{mpm=gait(speed);oldspeed=speed;}	// Calculates the new gait matrix 
-		
-		// Lift-off/Touchdown Vector updater
-		MemVec = CurVec; CurVec  = VecUpdater(CurVec,NextVec,time); // Checks whether a new LO/TD vector is necessary, and updates the CurVec if so.
-		if (MemVec!=CurVec)
-		{
-			VecChange=1;
-			PrevVec = MemVec;NextVec =  MPMVM(mpm,CurVec);	    // Calculates the new previous and next vectors
-		}
-
-
-		if ((ch == 119|| walking ==1))
-                {
-				for (int i=0;i<6;i++)
-				{ 
-					if ((time>=CurVec[i+6] && checktime<=CurVec[i+6])||(time>=CurVec[i] && checktime<=CurVec[i]))
-					{
-						VecChange=1;
-					}
-				}
-				if (VecChange==1)
-				{
-                                	SendVec = SendVecUpdaterS(PrevVec,CurVec,NextVec,time,ard);
-				}
-                        	walking =1;
-                }
-
-		changemode(0);timecounter++;VecChange=0;delay(loopWait);
-	}
-	
-
-
-
-}
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h> 
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Transition.h"
+#include "Recorder.h"
+#include "GaitWorker.h"
+#include "BusWorker.h"
+#include "BusStats.h"
+#include "ClockSync.h"
+#include "Deadline.h"
+#include "Bus.h"
+#include "AllocCount.h"
+#include "BusSpeed.h"
+#include "BusCapture.h"
+using namespace std;
+
+
+
+
+int main(int argc, char *argv[])
+{
+	// Asks the operator for a starting speed
+	// ./Walking record <file> records the session, ./Walking replay <file> runs a recorded session again without the robot (see Recorder.cpp)
+	// ./Walking alloccheck [speed] walks on simulated legs without waiting, and fails when the loop allocates memory (see AllocCount.cpp)
+	// ./Walking schedulecheck [strides] compares the lookahead schedule with plain MPMVM calls for every gait (see Schedule.cpp)
+	// ./Walking gaitcheck [changes] checks that planning a gait transition on the worker does not slow down the loop (see GaitWorker.cpp)
+	// ./Walking transitioncheck [step] plans the transitions between the gaits and checks their constraints (see Transition.cpp)
+	// ./Walking deadlinecheck [seconds] checks the missed deadlines, schedule moves and slow down of a slow loop (see Deadline.cpp)
+	// ./Walking busworkercheck [latency] checks that the bus worker coalesces and drops commands on simulated legs (see BusWorker.cpp)
+	// ./Walking clocksynccheck [rounds] checks that the latch, slew and trim keep simulated legs with drifting crystals on the host clock (see ClockSync.cpp)
+	// ./Walking queuecheck [strides] checks the queued strides of QueueStrides, the flush and the retry of a NACK in the burst (see Communications.cpp)
+	// ./Walking busbench [strides] prints the stride update latency with the legs on 1, 2 and 3 simulated buses (see MultiBus.cpp)
+	// ./Walking busspeed <100|400|1000> sets the bus speed preset of the legs, ./Walking busstress [seconds] tests the bus (see BusSpeed.cpp)
+	int i;
+	string option = "";
+	int allocCheck = 0; long allocBefore = 0;
+	if (argc > 1) {option = argv[1];}
+	if (option == "schedulecheck")
+	{
+		return (ScheduleCheck((argc > 2) ? atoi(argv[2]) : SCHEDULE_CHECK_STRIDES) == 0) ? 0 : 3;
+	}
+	if (option == "transitioncheck")
+	{
+		return (TransitionCheck((argc > 2) ? atoi(argv[2]) : TRANSITION_CHECK_STEP) == 0) ? 0 : 3;
+	}
+	if (option == "deadlinecheck")
+	{
+		return (DeadlineSelfCheck((argc > 2) ? atoi(argv[2]) : DEADLINE_CHECK_SECONDS) == 0) ? 0 : 3;
+	}
+	if (option == "busworkercheck")
+	{
+		return (BusWorkerCheck((argc > 2) ? atoi(argv[2]) : BUSWORKER_CHECK_LATENCY) == 0) ? 0 : 3;
+	}
+	if (option == "clocksynccheck")
+	{
+		return (ClockSyncCheck((argc > 2) ? atoi(argv[2]) : CLOCKSYNC_CHECK_ROUNDS) == 0) ? 0 : 3;
+	}
+	if (option == "queuecheck")
+	{
+		return (QueueCheck((argc > 2) ? atoi(argv[2]) : QUEUE_CHECK_STRIDES) == 0) ? 0 : 3;
+	}
+	if (option == "gaitcheck")
+	{
+		return (GaitWorkerCheck((argc > 2) ? atoi(argv[2]) : GAITWORKER_CHECK_CHANGES) == 1) ? 0 : 3;
+	}
+	if (option == "busbench")
+	{
+		BusBenchmark((argc > 2) ? atoi(argv[2]) : 500);
+		return 0;
+	}
+	if (option == "busspeed" && argc > 2)
+	{
+		return (BusSpeedProgram(connectLegs(), atoi(argv[2])) == 6) ? 0 : 1;
+	}
+	if (option == "busstress")
+	{
+		BusStress((argc > 2) ? atof(argv[2]) : 10);
+		return 0;
+	}
+	if (option == "replay" && argc > 2)
+	{
+		i = ReplayStart(argv[2]);				// The starting speed comes from the recording
+		if (i == 0) {return 1;}
+	}
+	else if (option == "alloccheck")
+	{
+		i = 50; if (argc > 2) {i = atoi(argv[2]);}
+		BusSet(BusOpen("sim:0"));				// Simulated legs without bus delay
+		allocCheck = 1;
+	}
+	else
+	{
+  		cout << "Please enter a starting speed between 5-99: "; // Prints the question
+  		cin >> i;						// Asks input
+		if (option == "record" && argc > 2 && RecordStart(argv[2],i) == 0) {return 1;}
+	}
+	cout << "Starting with speed" << i;
+
+	// Establish connection to the legs
+	if (RecorderMode()!=RECORDER_REPLAY) {BusCaptureStart();}	// ZEBRO_CAPTURE=<file> keeps the last bus transactions in a ring file (see BusCapture.cpp)
+	vector<int> ard = DiscoverLegs();  // Finds the legs on the bus and connects them. Ard contains the adresses
+	if (ard.size() == 0) {return 4;}	// A leg is missing
+	if (getenv("ZEBRO_BUSSPEED") != NULL) {BusSpeedCheck(ard);}	// The legs have to run at the rate of the host bus (see BusSpeed.cpp)
+	BusWorker B; BusWorkerStart(B,ard); BusWorkerSet(&B);	// The stride commands are sent by the bus worker thread, the loop does not wait for the bus (see BusWorker.cpp)
+	BusStatsSignal();					// kill -USR1 <pid> dumps the bus transaction statistics, like the t key (see BusStats.cpp)
+	
+	// Initialisation of variables	
+	double checktime=0; double time = 0; double oldtime=0;  uint8_t syncTime=0;vector<float> CheckVec(12,0); vector<float> SendHelpVec(3,0); 
+	vector<vector<float> >CurStat; vector<float> CurVec; vector<float> NextVec; vector<float> SendVec(12,0);vector<float> PrevVec; vector<float> MemVec; float HelpVec[12] = {0,0,0,0,0,0,0,0,0,0,0,0};vector<float>Vec = makeVec(HelpVec,12);
+	int ch=0;  int walking = 0;vector<int> readout;vector<int> legCheck (6,0); int VecChange=0; long checkedStride=-1;
+	//int a =0;int readout2;int readout3;int uploadcounter=0; int turningleft=0;int turningright=0; int turningcounter=0;
+
+	// Start the time 	
+	auto begin = clock();   		// Defines the starting time of the program
+	auto nu= clock();     			// Defines the current time
+	int timecounter=1; int loopWait =10; 	// Counts the loops and defines the waiting time in loop to not overflow the I2C-bus	
+
+	// Begin the initialisation of speed and gaits
+	int speed= i;int oldspeed=i; 						// Initializes the current speed en starting speed
+	vector <vector <float> > mpm = gait(speed);  				// Calculates the first gait
+	Schedule S; ScheduleInit(S,mpm,Vec,SCHEDULE_DEFAULT_SIZE);		// Fills the lookahead schedule with the next touchdown/liftoff vectors
+	PrevVec= S.PrevVec; CurVec = ScheduleAt(S,0); NextVec = ScheduleAt(S,1); 	// Defines the first 3 touchdown/liftoff vectors
+	GaitWorker W; GaitWorkerStart(W);					// New gaits are calculated by the worker thread, not in the loop (see GaitWorker.cpp)
+	int gaitRequest=0;							// Speed that still has to be handed to the worker (0 = none)
+	Deadlines D; DeadlineInit(D);						// Counts the leg commands that were sent too late (see Deadline.cpp)
+	long loops=0; double loopTotal=0; double loopWorst=0;			// Loop time benchmark (without the waiting time)
+	ClockSync C; ClockSyncInit(C); int twoWaySync = ClockSyncMode();	// The legs follow the steady clock of the host (see ClockSync.cpp)
+
+	
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	//////////////////////////////////////////////////////////////////////LOOPIE///////////////////////////////////////////////////////////////////////
+	///////////////////////////////// Starts the walking LOOP! ////////////////////////////////////////////////////////////////////////////////////////
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	// LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  // LOOP // LOOP  //
+	///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+	
+	while (1==1)
+	{
+		
+		// Check for input
+		auto loopStart = std::chrono::steady_clock::now();	// Start of the work in this loop
+		ch =0; 			// Resets the character that is being (inputted (?))
+		if (allocCheck==1)
+		{
+			if (timecounter==2){ch=119;}			// Starts walking right away
+		}
+		else if (RecorderMode()!=RECORDER_REPLAY)
+		{
+		changemode(1);		// Necessary to record the keyboard hit
+ 		 if (kbhit()!=0) // Checks if there was a keyboard hit
+		{	
+ 		 ch = getchar();	// Gets the character
+ 		}
+		}
+
+
+		// Looking at the clock and synchronizing the time
+		nu = clock();								// Defines the current moment
+		oldtime = floor(time);							// Updates the old time
+		checktime = time;							// Makes an old time not floored. 
+		time =((std::difftime(nu,begin)/1000)+ (loopWait)*(timecounter))/1000;  // Calculates the in-program time
+		if (twoWaySync==1){time = ClockSyncNow(C);}				// The time the legs are synchronised to
+		if (allocCheck==1)
+		{
+			time = (double)(loopWait*timecounter)/1000;			// Only the loop counter, so every check runs the same
+			if (timecounter==ALLOCCHECK_WARMUP){allocBefore=AllocCount();}	// The steady state starts here
+			if (timecounter==ALLOCCHECK_WARMUP+ALLOCCHECK_PASSES){break;}
+		}
+		if (RecordLoop(time,ch)==0){break;}					// Records the time and key, or takes them from the recording when replaying
+		BusCaptureMark(time);							// The analyser of the bus capture compares the commands with this time
+		if (ch == 113){break;}							// Quits when q is pressed (closes the recording)
+		if (floor(time)!=oldtime)
+		{
+			cout<< floor(time)<< "\n" ;
+			if (walking==1){cout<<"Walking";}
+			syncTime = (uint8_t)floor(time) % 256;				// Calculates the synctime (8-bit)
+			if (twoWaySync==1)
+			{
+				ClockSyncRound(C,ard);					// Measures the offset of every leg and slews its clock
+			}
+			else
+			{
+				i2cWrite (ard[6], 11, syncTime) ;			// Sends the synctime to the leg
+			}
+			// readout = wiringPiI2CReadReg8 (ard[1], 110) ; // 110 111 angles, 112 direction (1,0) , 113 (finitestatemachine flag )
+		}
+
+
+		// Special Input Operations (Stand-Up/Freeze/Stop/TRANSFORM INTO FIGHTING ROBOT)
+		if (ch!=0)
+		{
+			walking = SpecOps(ch, ard, syncTime);
+		}
+
+		// Gait updater
+		speed = GaitChangeManual(ch);				// Changes gait if the input is a certain character
+		if (speed!=0 && speed!=oldspeed)
+		{
+			oldspeed=speed;gaitRequest=speed;
+		}
+		if (gaitRequest!=0 && GaitWorkerRequest(W,gaitRequest,ScheduleAt(S,1),time,S.index+1,S.epoch)==1)	// The worker plans the strides from NextVec to the new gait
+		{
+			gaitRequest=0;
+			if (RecorderMode()!=RECORDER_OFF){GaitWorkerFlush(W);}	// Recordings must be reproducible, so the result may not depend on the worker's timing
+		}
+		
+		// Lift-off/Touchdown Vector updater
+		MemVec = CurVec; CurVec  = VecUpdater(CurVec,NextVec,time); // Checks whether a new LO/TD vector is necessary, and updates the CurVec if so.
+		if (MemVec!=CurVec)
+		{
+			VecChange=1;
+			ScheduleAdvance(S);PrevVec = MemVec;					    // Takes the new previous vector from the schedule
+			GaitTransition *T = GaitWorkerTake(W);					    // A new gait is only picked up at a stride boundary
+			if (T!=NULL)
+			{
+				if (T->stride==S.index && T->epoch==S.epoch)			    // Planned from the vector that just became CurVec, and the schedule was not moved since
+				{
+					mpm=T->mpm;ScheduleSetTransition(S,mpm,0,T->Vecs);	    // The schedule continues after CurVec with the transition
+					printTransition(*T);
+				}
+				else {gaitRequest=T->speed;}					    // Planned too late for this stride or before the schedule moved, plan again from the new NextVec
+			}
+			NextVec = ScheduleAt(S,1);						    // Takes the new next vector from the schedule
+		}
+
+
+		if ((ch == 119|| walking ==1))
+                {
+				if (walking==0){DeadlineRestart(D);}			// Starts counting again when the robot starts walking
+				for (int i=0;i<6;i++)
+				{ 
+					if ((time>=CurVec[i+6] && checktime<=CurVec[i+6])||(time>=CurVec[i] && checktime<=CurVec[i])||(time>=PrevVec[i] && checktime<PrevVec[i]))	// PrevVec only lies ahead after the schedule was moved
+					{
+						VecChange=1;
+					}
+				}
+				if (VecChange==1)
+				{
+                                	SendVecUpdaterS(S,time,ard,SendVec);
+					int late = DeadlineCheck(D,S,time);		// Moves the schedule forward when too many commands were late
+					if (late!=DEADLINE_OK)
+					{
+						PrevVec = S.PrevVec;CurVec = ScheduleAt(S,0);NextVec = ScheduleAt(S,1);
+						SendVecUpdaterS(S,time,ard,SendVec);	// The legs get the moved schedule right away
+					}
+					if (late==DEADLINE_SLOWER && DeadlineSlowerSpeed(oldspeed)!=0)
+					{
+						oldspeed=DeadlineSlowerSpeed(oldspeed);gaitRequest=oldspeed;	// The loop can not keep up, continue with a slower gait
+					}
+				}
+				if (walking==1 && checkedStride!=S.index)
+				{
+					checkedStride=S.index;LegCheck(S,time,ard,&legCheck[0]);	// Reads back all six legs once per stride (one batch read)
+				}
+                        	walking =1;
+                }
+
+		if (ch == 98)								// Prints the benchmarks when b is pressed
+		{
+			SchedulePrintStats(S);GaitWorkerPrintStats(W);DeadlinePrintStats(D);i2cPrintStats();BusWorkerPrintStats(B);LegCheckPrintStats();ClockSyncPrintStats(C);
+			cout << " Loop: " << loops << " passes, " << ((loops>0)?loopTotal/loops:0)*1e6 << " us average, worst " << loopWorst*1e6 << " us \n";
+		}
+
+		if (ch == 116 || BusStatsRequested()==1)				// Prints the bus transaction statistics and writes busstats.csv when t is pressed
+		{
+			BusStatsDump();
+		}
+
+		ScheduleRefill(S,1);	// Calculates one more vector ahead while there is time left in this loop
+		timecounter++;VecChange=0;
+		double loopTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - loopStart).count();
+		loops++;loopTotal+=loopTime;if (loopTime>loopWorst){loopWorst=loopTime;}
+		if (RecorderMode()!=RECORDER_REPLAY && allocCheck==0){changemode(0);std::this_thread::sleep_for(std::chrono::milliseconds(loopWait));}	// A replay does not wait, it runs as fast as possible
+	}
+	long allocations = AllocCount() - allocBefore;
+	if (RecorderMode()!=RECORDER_REPLAY && allocCheck==0){changemode(0);}
+	GaitWorkerStop(W);BusWorkerStop(B);BusCaptureStop();
+	if (allocCheck==1)
+	{
+		cout << "\n Allocations in " << ALLOCCHECK_PASSES << " loop passes: " << allocations << " \n";
+		return (allocations==0) ? 0 : 3;
+	}
+
+	long mismatches = RecordFinish();	// Prints the recording/replay summary
+	return (mismatches==0) ? 0 : 2;
+}
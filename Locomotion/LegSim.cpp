@@ -0,0 +1,444 @@
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include "LegSim.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE LEG DYNAMICS SIMULATOR
+// A headless model of one POOT leg, to measure how well the lift off and touchdown times of the planner are met.
+// Every step is one pass of the main loop of the leg firmware (LEGSIM_LOOP_HZ). A step does, in the same order and with the same
+// integer arithmetic as the firmware:
+//  - motion_absolute_position_calculator: the 910 pulse encoder and the absolute position (motion.c)
+//  - motion_command_zebro: the walk forward/backward setpoint ramp, one pulse every time_until_next_position_setpoint (motion.c)
+//  - motion_control_position: the position PID, which gives the current setpoint (motion.c)
+//  - adc_control_motor_current: the current PI, which gives the H-bridge duty cycle, and the over current check (adc.c)
+// and then moves the motor: a DC motor with inductance, back EMF, viscous friction, and a load torque while the leg is on the ground.
+// The current loop runs once per step here, on the leg it runs on the ADC interrupt at about the same rate.
+// Per leg, the simulator counts the timing error of every command (arrival time - commanded time), stalls and the energy used.
+// The arrival time is the closest approach of the target, as long as that is within the tolerance. The legs still arrive early
+// on average, most in the short stance: the firmware paces the setpoint ramp on the distance from the encoder to the target, while
+// the setpoint leads the encoder by the following error of the position PID (several pulses under load), so the setpoint and then
+// the leg reach the target before the commanded time. That is the firmware, not the model.
+// A step is the hot path (30000 steps per simulated robot second): the position modulo 910, the leg clock and the division of the
+// ramp speed are kept up to date incrementally instead of being recomputed every step, the motor constants are divided once, and
+// LegSimRun of all legs of a robot steps them in turn.
+// The simulator has no global state, so many legs (and robots) can be simulated in parallel threads.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Parameters of a POOT leg: 24 V, 2.5 rotations per second without load, a sixth of the weight on a leg of 10 cm.
+LegParams LegSimDefaults()
+{
+	LegParams P;
+	P.voltage = 24;
+	P.R = 2.0; P.L = 0.002;
+	P.K = 1.5;
+	P.J = 0.02; P.b = 0.05;
+	P.load = 2.0;
+	P.stanceStart = 570; P.stanceEnd = 650;		// Touchdown and lift off positions of SendVecUpdaterS
+	P.kp = 240; P.ki = 30; P.kd = 50;		// Gains after calibration (motion.c)
+	P.ckp = 28; P.cki = 150;			// adc.c
+	P.clockDrift = 0;
+	return P;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts the leg standing still at *position*, like after motion_return_to_idle
+void LegSimInit(LegSim &L, LegParams P, int position)
+{
+	L = LegSim();
+	L.P = P;
+	L.time = 0;
+	L.current = 0; L.speed = 0;
+	L.angle = position + 0.5;					// In the middle of the pulse
+	L.pulses = position;
+	L.position = position % LEGSIM_PULSES;
+	L.mode = 0; L.position_a = 0; L.position_b = 0; L.time_a = 0; L.time_b = 0;
+	L.seconds = 0; L.syncTime = 0;
+	L.ticks = 0; L.ticksPerStep = (1 + P.clockDrift) * LEGSIM_CLOCK_TICKS / LEGSIM_LOOP_HZ;
+	L.position_setpoint = position;
+	L.absolute_position = 0; L.previous_encoder_position = 0;	// The first step counts the encoder up to *position*
+	L.error_integral = 0; L.error_derivative = 0; L.error_position_prev = 0; L.counter = 0;
+	L.current_setpoint = 0; L.current_integral = 0; L.duty = 0;
+	L.time_old_1 = 0; L.time_until_next_position_setpoint = 0; L.desired_speed = 0; L.delta_distance = 0;
+	L.speedDistance = 0; L.speedTime = 0;
+	L.overcurrent = 0;
+	L.decay = exp(-(P.R / P.L) / LEGSIM_LOOP_HZ);
+	L.voltsPerDuty = P.voltage / LEGSIM_FULL_DUTY; L.ampsPerVolt = 1 / P.R;
+	L.speedPerTorque = 1.0 / LEGSIM_LOOP_HZ / P.J; L.pulsesPerSpeed = 1.0 / LEGSIM_LOOP_HZ * LEGSIM_PULSES / (2 * M_PI);
+	L.target = 0; L.targetTime = 0; L.tracking = 0;
+	L.closest = -1; L.closestTime = 0; L.measured = -1;
+	L.stallTime = 0; L.stalled = 0;
+	L.M = LegMetrics();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The clock of the leg (time.c): whole seconds from the last sync, and TIM16 counting from 0 since then
+static uint32_t legCounter(LegSim &L)
+{
+	return ((uint32_t) L.ticks) & 0xFFFF;
+}
+
+static uint32_t legTimeMs(LegSim &L)
+{
+	return L.seconds * 1000 + (legCounter(L) * 1000) / LEGSIM_CLOCK_TICKS;
+}
+
+// TIM3 is a 16 bit counter
+static int16_t encoderPosition(LegSim &L)
+{
+	return (int16_t) L.pulses;
+}
+
+int LegSimPosition(LegSim &L)
+{
+	return L.position;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// motion_return_to_idle
+static void returnToIdle(LegSim &L)
+{
+	L.position_setpoint = encoderPosition(L);
+	L.mode = 0; L.position_a = 0; L.position_b = 0; L.time_a = 0; L.time_b = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The leg is done with its target: it arrived at its closest approach, or missed the target when it never got within the tolerance
+static void finishTarget(LegSim &L)
+{
+	L.tracking = 0;
+	if (L.closest < 0)
+	{
+		L.M.missed++;
+		return;
+	}
+	double error = L.closestTime - L.targetTime;
+	L.M.arrived++;
+	L.M.errorSum += fabs(error);
+	L.M.lateSum += error;
+	if (fabs(error) > L.M.errorMax)
+		L.M.errorMax = fabs(error);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Handles a ZebroBus register write
+void LegSimWrite(LegSim &L, int reg, uint8_t data)
+{
+	if (reg >= 30 && reg <= 36)
+	{
+		L.staged[reg - 30] = data;
+		return;
+	}
+	if (reg == 11)
+	{
+		L.seconds = data; L.syncTime = L.time; L.ticks = 0;		// time_set_time
+		return;
+	}
+	if (reg != 37)
+		return;
+
+	// VREGS_MOTION_UPDATE: the staged command becomes the state
+	L.mode = L.staged[0]; L.position_a = L.staged[1]; L.position_b = L.staged[2]; L.time_a = L.staged[3]; L.time_b = L.staged[4];
+	for (int i = 0; i < 7; i++)
+		L.staged[i] = 0;
+
+	if (L.mode == 2 || L.mode == 3)
+	{
+		int target = ((L.position_a << 8) + L.position_b) % LEGSIM_PULSES;
+		int32_t delta = (L.time_a * 1000 + L.time_b * 4) - (int32_t) legTimeMs(L);	// time_calculate_delta
+		if (delta < -128000) delta += 256000;
+		if (delta > 128000) delta -= 256000;
+		double targetTime = L.time + (delta / 1000.0) / (1 + L.P.clockDrift);
+		if (L.tracking == 0 || target != L.target || fabs(targetTime - L.targetTime) > 0.002)
+		{
+			if (L.tracking == 1)
+				finishTarget(L);
+			L.target = target; L.targetTime = targetTime; L.tracking = 1; L.closest = -1; L.measured = -1;
+			L.M.commands++;
+		}
+	}
+	else if (L.tracking == 1)
+		finishTarget(L);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Handles a motion frame: registers 30-37 as SendToLeg writes them
+void LegSimFrame(LegSim &L, const uint8_t Data[8])
+{
+	for (int i = 0; i < 8; i++)
+		LegSimWrite(L, 30 + i, Data[i]);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// motion_control_position: position PID, gives the current setpoint
+static void controlPosition(LegSim &L)
+{
+	const int32_t dt = LEGSIM_CPU_HZ / LEGSIM_LOOP_HZ;			// TIM17 ticks since the last pass
+	int16_t error_position = L.position_setpoint - encoderPosition(L);
+	L.error_integral += (dt * error_position) / (48000000 >> 15);
+	if (L.counter == 10)
+	{
+		L.error_derivative = error_position - L.error_position_prev;
+		L.error_position_prev = error_position;
+		L.counter = 0;
+	}
+	else
+		L.counter++;
+	int kp = L.P.kp, ki = L.P.ki, kd = L.P.kd;
+	L.current_setpoint = (kp * error_position) + (ki * (L.error_integral >> 13)) + (kd * 40 * L.error_derivative);
+	if (L.current_setpoint > LEGSIM_SETPOINT_MAX)
+	{
+		L.current_setpoint = LEGSIM_SETPOINT_MAX;
+		if ((kp * error_position) < LEGSIM_SETPOINT_MAX && ki != 0)
+			L.error_integral = ((LEGSIM_SETPOINT_MAX - (kp * error_position)) / ki) << 13;
+		else
+			L.error_integral = 0;
+	}
+	else if (L.current_setpoint < -LEGSIM_SETPOINT_MAX)
+	{
+		L.current_setpoint = -LEGSIM_SETPOINT_MAX;
+		if ((kp * error_position) > -LEGSIM_SETPOINT_MAX && ki != 0)
+			L.error_integral = ((-LEGSIM_SETPOINT_MAX - (kp * error_position)) / ki) * 8192;
+		else
+			L.error_integral = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The walk forward (direction 1) and walk backward (direction -1) setpoint ramp of motion_command_zebro
+static void walk(LegSim &L, int direction)
+{
+	controlPosition(L);
+	int16_t absolute_starting_setpoint = L.absolute_position;
+	uint32_t starting_time = legTimeMs(L);
+	int16_t absolute_ending_setpoint = (L.position_a << 8) + L.position_b;
+	int16_t ahead = (direction == 1) ? absolute_ending_setpoint - absolute_starting_setpoint : absolute_starting_setpoint - absolute_ending_setpoint;
+	if (ahead < 0)
+		L.delta_distance = LEGSIM_PULSES + ahead;
+	else if (ahead == 0)
+		returnToIdle(L);
+	else
+		L.delta_distance = ahead;
+	uint32_t delta_time = ((L.time_a * 1000) + (L.time_b * 4)) - starting_time;
+	if (delta_time > 0 && (delta_time != L.speedTime || L.delta_distance != L.speedDistance))
+	{
+		L.desired_speed = (L.delta_distance * 1000000) / delta_time;
+		L.speedTime = delta_time; L.speedDistance = L.delta_distance;
+	}
+	uint32_t dt_1 = legCounter(L) - L.time_old_1;
+	if (dt_1 >= L.time_until_next_position_setpoint)
+	{
+		int16_t encoder = encoderPosition(L);
+		L.position_setpoint += direction;
+		if (direction == 1 && L.position_setpoint > (encoder + (int32_t) L.delta_distance))
+			L.position_setpoint = encoder + L.delta_distance;
+		if (direction == -1 && L.position_setpoint < (encoder - (int32_t) L.delta_distance))
+			L.position_setpoint = encoder - L.delta_distance;
+		if (L.desired_speed > 0)
+		{
+			L.time_until_next_position_setpoint = (1000 * LEGSIM_CLOCK_TICKS) / L.desired_speed;
+			L.time_old_1 = legCounter(L);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// adc_control_motor_current: current PI, gives the duty cycle. Also the over current check of adc_check_motor_current.
+static void controlCurrent(LegSim &L)
+{
+	const int32_t dt = LEGSIM_CPU_HZ / LEGSIM_LOOP_HZ;
+	int32_t setpoint = L.current_setpoint;
+	int32_t measured = (int32_t) (L.current * LEGSIM_COUNTS_PER_AMP);
+	if (setpoint != 0)
+	{
+		int32_t error_current = setpoint - measured;
+		L.current_integral += (error_current * dt) / (48000000 >> 10);
+		int32_t duty_cycle = ((L.P.ckp * error_current) + (L.P.cki * (L.current_integral >> 8))) >> 6;
+		if (duty_cycle > LEGSIM_MAX_DUTY)
+		{
+			duty_cycle = LEGSIM_MAX_DUTY;
+			if (((L.P.ckp * error_current) >> 6) < LEGSIM_MAX_DUTY && L.P.cki != 0)
+				L.current_integral = (((LEGSIM_MAX_DUTY << 6) - (L.P.ckp * error_current)) << 8) / L.P.cki;
+			else
+				L.current_integral = 0;
+		}
+		else if (duty_cycle < -LEGSIM_MAX_DUTY)
+		{
+			duty_cycle = -LEGSIM_MAX_DUTY;
+			if (((L.P.ckp * error_current) >> 6) > -LEGSIM_MAX_DUTY && L.P.cki != 0)
+				L.current_integral = (((-LEGSIM_MAX_DUTY * 64) - (L.P.ckp * error_current)) * 256) / L.P.cki;
+			else
+				L.current_integral = 0;
+		}
+		L.duty = duty_cycle;
+	}
+	if (abs(measured) >= LEGSIM_OVERCURRENT)
+	{
+		L.overcurrent++;
+		if (L.overcurrent > LEGSIM_OVERCURRENT_SAMPLES && L.mode != 255)
+		{
+			L.mode = 255;						// errors_emergency_stop
+			L.M.emergencyStops++;
+		}
+	}
+	else if (L.overcurrent > 0)
+		L.overcurrent--;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Moves the motor one step with the current duty cycle
+static void physics(LegSim &L)
+{
+	const double dt = 1.0 / LEGSIM_LOOP_HZ;
+	double voltage = (L.mode == 255) ? 0 : L.voltsPerDuty * L.duty;	// The H-bridge is off after an emergency stop
+	double steady = (voltage - L.P.K * L.speed) * L.ampsPerVolt;
+	L.current = steady + (L.current - steady) * L.decay;
+	double torque = L.P.K * L.current - L.P.b * L.speed;
+	int p = L.position;
+	if (p >= L.P.stanceStart && p <= L.P.stanceEnd)			// The leg carries the robot
+	{
+		if (fabs(L.speed) > 1e-3)
+			torque -= (L.speed > 0) ? L.P.load : -L.P.load;
+		else if (fabs(torque) <= L.P.load)
+		{
+			torque = 0; L.speed = 0;				// Not enough torque to move the robot
+		}
+		else
+			torque -= (torque > 0) ? L.P.load : -L.P.load;
+	}
+	L.speed += torque * L.speedPerTorque;
+	L.angle += L.speed * L.pulsesPerSpeed;
+	while (L.angle >= L.pulses + 1)					// Less than a pulse per step below 5000 pulses per second
+	{
+		L.pulses++;
+		L.position = (L.position == LEGSIM_PULSES - 1) ? 0 : L.position + 1;
+	}
+	while (L.angle < L.pulses)
+	{
+		L.pulses--;
+		L.position = (L.position == 0) ? LEGSIM_PULSES - 1 : L.position - 1;
+	}
+	double power = voltage * L.current;
+	if (power > 0)
+		L.M.energy += power * dt;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Updates the timing error and stall metrics
+static void measure(LegSim &L)
+{
+	const double dt = 1.0 / LEGSIM_LOOP_HZ;
+	if (L.tracking == 1 && L.position != L.measured)			// The distance only changes with the position
+	{
+		L.measured = L.position;
+		int distance = abs(L.position - L.target);
+		if (distance > LEGSIM_PULSES / 2)
+			distance = LEGSIM_PULSES - distance;
+		if (distance <= LEGSIM_ARRIVE_TOLERANCE && (L.closest < 0 || distance < L.closest))
+		{
+			L.closest = distance; L.closestTime = L.time;
+		}
+		if (distance == 0 || (L.closest >= 0 && distance > L.closest))	// On the target, or going away from it again
+			finishTarget(L);
+	}
+	if ((L.mode == 2 || L.mode == 3) && abs(L.position_setpoint - encoderPosition(L)) > LEGSIM_STALL_ERROR)
+	{
+		L.stallTime += dt;
+		if (L.stallTime >= LEGSIM_STALL_TIME && L.stalled == 0)
+		{
+			L.M.stalls++;
+			L.stalled = 1;
+		}
+	}
+	else
+	{
+		L.stallTime = 0; L.stalled = 0;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// One pass of the main loop of the leg
+static void step(LegSim &L)
+{
+	// motion_absolute_position_calculator
+	int16_t encoder = encoderPosition(L);
+	L.absolute_position += (int16_t) (encoder - L.previous_encoder_position);
+	if (L.absolute_position < 0)
+		L.absolute_position += LEGSIM_PULSES;
+	else if (L.absolute_position >= LEGSIM_PULSES)			// The % of the firmware, the encoder moves less than a pulse per step
+		L.absolute_position -= LEGSIM_PULSES;
+	L.previous_encoder_position = encoder;
+
+	// motion_command_zebro
+	if (L.mode == 2)
+		walk(L, 1);
+	else if (L.mode == 3)
+		walk(L, -1);
+	else if (L.mode == 255)
+		L.position_setpoint = encoder;
+	else
+		controlPosition(L);					// Idle (and calibrate, which is not simulated) hold the position
+
+	controlCurrent(L);
+	physics(L);
+	L.time += 1.0 / LEGSIM_LOOP_HZ;
+	L.ticks += L.ticksPerStep;
+	measure(L);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Simulates the leg up to simulation time *until*
+void LegSimRun(LegSim &L, double until)
+{
+	const double dt = 1.0 / LEGSIM_LOOP_HZ;
+	while (L.time + dt <= until + 1e-9)
+		step(L);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Simulates all legs of *Legs* up to simulation time *until*, one step of every leg in turn. The steps of one leg depend on each other,
+// the steps of different legs do not, so the CPU works on several legs at the same time.
+void LegSimRun(vector<LegSim> &Legs, double until)
+{
+	const double dt = 1.0 / LEGSIM_LOOP_HZ;
+	int n = Legs.size();
+	if (n == 0)
+		return;
+	while (Legs[0].time + dt <= until + 1e-9)
+	{
+		for (int i = 0; i < n; i++)
+			step(Legs[i]);
+	}
+	for (int i = 1; i < n; i++)
+		LegSimRun(Legs[i], until);				// Legs that were behind the first
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Adds the metrics of two legs (the largest error is the largest of both)
+LegMetrics LegSimAdd(LegMetrics A, LegMetrics B)
+{
+	A.commands += B.commands; A.arrived += B.arrived; A.missed += B.missed;
+	A.errorSum += B.errorSum; A.lateSum += B.lateSum;
+	if (B.errorMax > A.errorMax)
+		A.errorMax = B.errorMax;
+	A.stalls += B.stalls; A.emergencyStops += B.emergencyStops;
+	A.energy += B.energy;
+	return A;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the metrics in one line
+void LegSimPrint(LegMetrics M, const char *name)
+{
+	double mean = 0, late = 0;
+	if (M.arrived > 0)
+	{
+		mean = M.errorSum / M.arrived;
+		late = M.lateSum / M.arrived;
+	}
+	printf(" %-8s commands %6ld  arrived %6ld  missed %5ld  |error| mean %7.1f ms max %7.1f ms  late %7.1f ms  stalls %4ld  estops %3ld  energy %8.1f J\n",
+	       name, M.commands, M.arrived, M.missed, mean * 1000, M.errorMax * 1000, late * 1000, M.stalls, M.emergencyStops, M.energy);
+}
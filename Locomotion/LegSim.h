@@ -0,0 +1,107 @@
+#ifndef LEGSIM_H
+#define LEGSIM_H
+
+#include <vector>
+#include <stdint.h>
+using namespace std;
+
+// HEADER FILE FOR THE LEG DYNAMICS SIMULATOR! See the .cpp file for the extended explanations
+// Only the standard headers are included here, so the simulator can be used without the rest of the Locomotion code.
+
+#define LEGSIM_PULSES 910		// ENCODER_PULSES_PER_ROTATION of the firmware
+#define LEGSIM_LOOP_HZ 5000		// Frequency of the main loop of the firmware (position control and setpoint ramp)
+#define LEGSIM_CLOCK_TICKS 64000	// TIM16 ticks per second (TIME_ONE_SECOND_COUNTER_VALUE)
+#define LEGSIM_CPU_HZ 48000000		// TIM17 ticks per second (the dt of the control loops)
+#define LEGSIM_COUNTS_PER_AMP 1092.27	// ADC counts per ampere of the ACS711 current sensor (65536 / (1650 / 55))
+#define LEGSIM_MAX_DUTY 1003		// H_BRIDGE_MAX_DUTYCYCLE
+#define LEGSIM_FULL_DUTY 1023		// H_BRDIGE_ARR
+#define LEGSIM_SETPOINT_MAX 16383	// MOTION_CURRENT_SETPOINT_MAX
+#define LEGSIM_OVERCURRENT 26000	// ADC_OVER_CURRENT_COUNT (counts from mid range)
+#define LEGSIM_OVERCURRENT_SAMPLES 100	// ADC_CURRENT_EMERGENCY_SAMPLES
+#define LEGSIM_ARRIVE_TOLERANCE 5	// A leg is at its commanded position at its closest approach, when that is this many pulses away or closer
+#define LEGSIM_STALL_ERROR 30		// A leg stalls when the position error stays above this many pulses...
+#define LEGSIM_STALL_TIME 0.2		// ... for this many seconds while it is commanded to walk
+
+struct LegParams
+{
+	double voltage;			// Battery voltage (V)
+	double R;			// Motor resistance (Ohm)
+	double L;			// Motor inductance (H)
+	double K;			// Torque constant and back EMF constant at the leg, gearbox included (Nm/A = V s/rad)
+	double J;			// Inertia at the leg (kg m^2)
+	double b;			// Viscous friction at the leg (Nm s/rad)
+	double load;			// Torque needed to move the leg while it carries the robot (Nm)
+	int stanceStart;		// Position where the leg touches the ground (pulses)
+	int stanceEnd;			// Position where the leg leaves the ground (pulses)
+	int kp, ki, kd;			// Position PID gains (motion.c)
+	int ckp, cki;			// Current PI gains (adc.c)
+	double clockDrift;		// Relative error of the clock of the leg (1e-4 = 100 ppm fast)
+};
+
+struct LegMetrics
+{
+	long commands;			// Motion commands with a new target
+	long arrived;			// Commands where the leg reached its target
+	long missed;			// Commands replaced by a new target before the leg got there
+	double errorSum;		// Sum of the absolute timing errors of the arrived commands (s)
+	double errorMax;		// Largest absolute timing error (s)
+	double lateSum;			// Sum of the signed timing errors, positive is late (s)
+	long stalls;			// Times the leg stalled
+	long emergencyStops;		// Emergency stops because of over current
+	double energy;			// Energy taken from the battery (J)
+};
+
+struct LegSim
+{
+	LegParams P;
+	double time;			// Simulation time (s)
+	// Physics
+	double current;			// Motor current (A)
+	double speed;			// Leg speed (rad/s)
+	double angle;			// Leg angle since the start in encoder pulses (910 per rotation)
+	long pulses;			// Whole encoder pulses since the start (floor of angle), updated every step
+	int position;			// The same modulo 910 (LegSimPosition)
+	// Firmware state (names as in motion.c / adc.c / time.c)
+	uint8_t staged[7];		// Motion registers 30-36 since the last update
+	uint8_t mode, position_a, position_b, time_a, time_b;
+	int seconds;			// current_seconds
+	double syncTime;		// Simulation time of the last sync, TIM16->CNT counts from there
+	double ticks;			// TIM16 ticks since the last sync (with the drift), updated every step
+	double ticksPerStep;
+	int16_t position_setpoint;
+	int16_t absolute_position, previous_encoder_position;
+	int32_t error_integral, error_derivative; int16_t error_position_prev; int counter;
+	int32_t current_setpoint;
+	int32_t current_integral; int duty;
+	uint32_t time_old_1, time_until_next_position_setpoint, desired_speed, delta_distance;
+	uint32_t speedDistance, speedTime;	// The delta_distance and delta_time of desired_speed, it is only divided again when they change
+	int overcurrent;
+	double decay;			// Part of the motor current that is left after one loop (inductance)
+	double voltsPerDuty, ampsPerVolt, speedPerTorque, pulsesPerSpeed;	// Constants of a step, so it does not divide
+	// Metrics
+	int target; double targetTime; int tracking;	// Target of the current command and the simulation time it should be reached
+	int closest; double closestTime;		// Closest approach to the target so far within the tolerance (-1 = not within)
+	int measured;					// Position of the last distance to the target
+	double stallTime; int stalled;
+	LegMetrics M;
+};
+
+LegParams LegSimDefaults(); // Parameters of a POOT leg carrying a sixth of a KiloZebro
+
+void LegSimInit(LegSim &L, LegParams P, int position); // Starts the leg standing still at *position* (pulses), in idle
+
+void LegSimWrite(LegSim &L, int reg, uint8_t data); // Handles a ZebroBus register write (11 sync, 22 reset emergency stop, 30-37 motion)
+
+void LegSimFrame(LegSim &L, const uint8_t Data[8]); // Handles a motion command frame, registers 30-37 in one go
+
+void LegSimRun(LegSim &L, double until); // Simulates the leg up to simulation time *until*
+
+void LegSimRun(vector<LegSim> &Legs, double until); // Same for all legs, faster than one leg after the other
+
+int LegSimPosition(LegSim &L); // Absolute position of the leg (0 - 909)
+
+LegMetrics LegSimAdd(LegMetrics A, LegMetrics B); // Adds the metrics of two legs
+
+void LegSimPrint(LegMetrics M, const char *name); // Prints the metrics
+
+#endif
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h> 
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "LegSim.h"
+using namespace std;
+
+// MAIN FILE OF THE LEG DYNAMICS SIMULATOR
+// Walks many simulated robots with the planner of KiloZebroMain.cpp (lookahead schedule, SendVecUpdaterS commands, a sync every
+// second, loop of 10 ms), but with a virtual clock and the legs of LegSim.cpp instead of the bus. The robots are spread over threads.
+// Every robot gets a slightly different load and clock drift, so the results show the spread and not one lucky robot.
+//
+// ./LegSim [robots] [seconds] [speed] [threads] [kp ki kd]
+// Prints per leg position the timing error of the commands, stalls and energy, and how many times faster than real time it ran.
+
+#define LEGSIM_LOOP_WAIT 0.01		// Loop time of KiloZebroMain.cpp (s)
+#define LEGSIM_LOAD_SPREAD 0.2		// The load of every leg is chosen between (1 - spread) and (1 + spread) times the default
+#define LEGSIM_DRIFT_SPREAD 50e-6	// The clock drift of every leg is chosen between -spread and +spread
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Walks one robot for *seconds* simulated seconds, and gives the metrics of its six legs
+void walkRobot(int robot, LegParams P, double seconds, int speed, LegMetrics *out)
+{
+	std::mt19937 random(robot);					// Same robot number, same robot
+	std::uniform_real_distribution<double> spread(-1, 1);
+	vector<LegSim> legs(6);
+	for (int i = 0; i < 6; i++)
+	{
+		LegParams Q = P;
+		Q.load = P.load * (1 + LEGSIM_LOAD_SPREAD * spread(random));
+		Q.clockDrift = LEGSIM_DRIFT_SPREAD * spread(random);
+		LegSimInit(legs[i], Q, 610);				// Standing
+	}
+
+	vector<float> Zero(12, 0);
+	Schedule S; ScheduleInit(S, gait(speed), Zero, SCHEDULE_DEFAULT_SIZE);
+	vector<float> CurVec = ScheduleAt(S, 0); vector<float> NextVec = ScheduleAt(S, 1); vector<float> MemVec;
+	double time = 0; double checktime = 0;
+	uint8_t Data[8];
+	for (long k = 1; time < seconds; k++)
+	{
+		checktime = time;
+		time = k * LEGSIM_LOOP_WAIT;
+		if (floor(time) != floor(checktime))
+		{
+			for (int i = 0; i < 6; i++)
+				LegSimWrite(legs[i], 11, (uint8_t) ((int) floor(time) % 256));	// The sync of the main loop
+		}
+
+		// The same vector updates as the main loop
+		int VecChange = 0;
+		MemVec = CurVec; CurVec = VecUpdater(CurVec, NextVec, time);
+		if (MemVec != CurVec)
+		{
+			VecChange = 1;
+			ScheduleAdvance(S); NextVec = ScheduleAt(S, 1);
+		}
+		for (int i = 0; i < 6; i++)
+		{
+			if ((time >= CurVec[i + 6] && checktime <= CurVec[i + 6]) || (time >= CurVec[i] && checktime <= CurVec[i]))
+				VecChange = 1;
+		}
+		if (VecChange == 1)
+		{
+			for (int i = 0; i < 6; i++)
+			{
+				float Vec[3];
+				LegVecS(S.PrevVec, ScheduleAt(S, 0), ScheduleAt(S, 1), time, i, Vec);
+				MotionFrame(Vec, Data);
+				LegSimFrame(legs[i], Data);
+			}
+		}
+		ScheduleRefill(S, 1);
+
+		LegSimRun(legs, time);
+	}
+	for (int i = 0; i < 6; i++)
+		out[i] = legs[i].M;
+}
+
+int main(int argc, char *argv[])
+{
+	int robots = (argc > 1) ? atoi(argv[1]) : 60;
+	double seconds = (argc > 2) ? atof(argv[2]) : 60;
+	int speed = (argc > 3) ? atoi(argv[3]) : 50;
+	int threads = (argc > 4) ? atoi(argv[4]) : std::thread::hardware_concurrency();
+	LegParams P = LegSimDefaults();
+	if (argc > 7)
+	{
+		P.kp = atoi(argv[5]); P.ki = atoi(argv[6]); P.kd = atoi(argv[7]);
+	}
+	if (threads < 1)
+		threads = 1;
+	cout << "Simulating " << robots << " robots for " << seconds << " s at speed " << speed << " on " << threads << " threads (kp "
+	     << P.kp << ", ki " << P.ki << ", kd " << P.kd << ")\n";
+
+	// Every thread takes the next robot until all robots are done
+	vector<LegMetrics> results(robots * 6);
+	std::atomic<int> next(0);
+	auto start = std::chrono::steady_clock::now();
+	vector<std::thread> workers;
+	for (int t = 0; t < threads; t++)
+	{
+		workers.push_back(std::thread([&]() {
+			for (int r = next++; r < robots; r = next++)
+				walkRobot(r, P, seconds, speed, &results[r * 6]);
+		}));
+	}
+	for (unsigned int t = 0; t < workers.size(); t++)
+		workers[t].join();
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Per leg position, added over all robots
+	const char *names[6] = {"LF 0x10", "RF 0x16", "LM 0x12", "RM 0x18", "LH 0x14", "RH 0x1a"};
+	LegMetrics Total = LegMetrics();
+	for (int i = 0; i < 6; i++)
+	{
+		LegMetrics M = LegMetrics();
+		for (int r = 0; r < robots; r++)
+			M = LegSimAdd(M, results[r * 6 + i]);
+		LegSimPrint(M, names[i]);
+		Total = LegSimAdd(Total, M);
+	}
+	LegSimPrint(Total, "all");
+	printf(" %.0f robot seconds in %.2f s: %.0f x real time (%.0f x per thread)\n", robots * seconds, wall, robots * seconds / wall,
+	       robots * seconds / wall / threads);
+	return 0;
+}
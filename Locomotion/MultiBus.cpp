@@ -0,0 +1,340 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "Bus.h"
+#include "SimBus.h"
+#include "MultiBus.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE BACKEND FOR MORE THAN ONE I2C BUS
+// All six legs on one bus means every stride update waits for the bytes of all six legs, one after the other, also when they are
+// in one batch. The newer Pis have more I2C controllers (/dev/i2c-1, /dev/i2c-3, ...), so the legs can be spread over them, for
+// example the left legs on i2c-1 and the right legs on i2c-3 (connectLegs in Communications.cpp decides which leg goes where).
+// A MultiBus holds one backend per bus (a lane) and one I/O thread per lane:
+//  - a handle from setup belongs to one lane, only the broadcast address (0x00) is opened on every lane (unless it is opened for one
+//    lane, for the part of the broadcast frame of the legs on that bus, see SendFrames)
+//  - a single transaction goes to the bus of its leg directly, from the thread that asked for it
+//  - a batch is split per lane, and the parts go out at the same time, each by the thread of its lane. The caller waits until all
+//    lanes are done, so a batch is still one step: when writeBatch returns, every leg has its command (the barrier). A broadcast
+//    write is a batch with a part on every lane.
+// SendFrames uses the barrier to let the legs on all buses start together: first the commands without the update register (the
+// stage), then, when every bus is done, only the update registers (the commit), which is one byte per leg and takes the same short
+// time on every bus. The broadcast frame needs no commit: every bus gets a part of the same length. Nothing is allocated after setup, the parts of a batch are kept in the lanes.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The bus of leg *leg* (the order of connectLegs)
+int MultiBusLane(int leg, int lanes)
+{
+	const char *spec = getenv("ZEBRO_LEGBUS");
+	if (spec != NULL)
+	{
+		for (int i = 0; i < leg && spec != NULL; i++)
+		{
+			spec = strchr(spec, ',');
+			if (spec != NULL) spec++;
+		}
+		return (spec == NULL) ? 0 : atoi(spec);
+	}
+	if (lanes == 2)
+		return leg % 2;				// The odd legs are on the right side
+	if (lanes == 3)
+		return leg / 2;
+	return (lanes > 1) ? leg % lanes : 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts the I/O thread of every lane. Simulated legs are wired like a robot: every leg answers on its own bus only (MultiBusLane).
+MultiBus::MultiBus(const vector<Bus *> &buses)
+{
+	for (int l = 0; l < (int) buses.size() && l < MULTIBUS_LANES_MAX; l++)
+	{
+		BusLane *L = new BusLane();
+		L->bus = buses[l]; L->job = 0; L->count = 0; L->result = 0; L->stop = 0;
+		lane.push_back(L);
+	}
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		SimBus *sim = dynamic_cast<SimBus *>(lane[l]->bus);
+		for (int p = 0; p < SIM_POSITIONS && sim != NULL; p++)
+		{
+			int leg = 2 * ((p % 6) / 2) + p / 6;	// Left front, right front, left middle, ... (positions 0, 6, 2, 8, 4, 10)
+			if (MultiBusLane(leg, (int) lane.size()) != l)
+				sim->setPresent(SIM_ADDRESS_OFFSET + p, 0);
+		}
+	}
+	for (int l = 0; l < (int) lane.size(); l++)
+		lane[l]->thread = std::thread(&MultiBus::work, this, lane[l]);
+	count();
+}
+
+// Stops and joins the threads, and deletes the backends of the lanes
+MultiBus::~MultiBus()
+{
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		{
+			std::lock_guard<std::mutex> guard(lane[l]->lock);
+			lane[l]->stop = 1;
+		}
+		lane[l]->wake.notify_one();
+		lane[l]->thread.join();
+		delete lane[l]->bus;
+		delete lane[l];
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Does the job of a lane: its part of a batch
+static void doJob(BusLane *L)
+{
+	if (L->job == MULTIBUS_WRITE_BATCH)
+		L->result = L->bus->writeBatch(L->writes, L->count);
+	else
+		L->result = L->bus->readBatch(L->reads, L->count);
+}
+
+void MultiBus::work(BusLane *L)
+{
+	std::unique_lock<std::mutex> guard(L->lock);
+	while (1)
+	{
+		L->wake.wait(guard, [L]() { return L->job != 0 || L->stop == 1; });
+		if (L->job == 0)
+			return;
+		guard.unlock();
+		doJob(L);
+		guard.lock();
+		L->job = 0;
+		L->done.notify_one();
+	}
+}
+
+// Gives every lane with a part of the batch the job, and waits until all of them are done. The caller does the part of the last lane
+// itself while the threads of the other lanes do theirs: waking a thread for it as well would only add its wake up to the batch (a
+// batch for one lane, or a broadcast on two buses, would then be slower than on one bus).
+void MultiBus::run(int job)
+{
+	int own = -1;
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		if (lane[l]->count > 0)
+			own = l;
+	}
+	for (int l = 0; l < own; l++)
+	{
+		BusLane *L = lane[l];
+		if (L->count == 0)
+			continue;
+		{
+			std::lock_guard<std::mutex> guard(L->lock);
+			L->job = job;
+		}
+		L->wake.notify_one();
+	}
+	if (own >= 0)
+	{
+		lane[own]->job = job;
+		doJob(lane[own]);
+		lane[own]->job = 0;
+	}
+	for (int l = 0; l < own; l++)
+	{
+		std::unique_lock<std::mutex> guard(lane[l]->lock);
+		lane[l]->done.wait(guard, [this, l]() { return lane[l]->job == 0; });
+	}
+	count();
+}
+
+void MultiBus::count()
+{
+	long total = 0;
+	for (int l = 0; l < (int) lane.size(); l++)
+		total += lane[l]->bus->syscalls;
+	syscalls = total;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Opens the leg on the bus of the first lane, or the broadcast address on all lanes
+int MultiBus::setup(int adress)
+{
+	return setup(adress, (adress == 0) ? -1 : 0);
+}
+
+// Opens the leg at *adress* on lane *bus* (-1 = every lane)
+int MultiBus::setup(int adress, int bus)
+{
+	BusRoute R;
+	R.lane = bus;
+	if (R.lane >= (int) lane.size())
+	{
+		cout << "\n There is no bus " << R.lane << " for the leg at address " << adress << "\n";
+		return -1;
+	}
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		R.fds[l] = -1;
+		if (R.lane == -1 || R.lane == l)
+		{
+			R.fds[l] = lane[l]->bus->setup(adress);
+			if (R.fds[l] < 0)
+				return -1;
+		}
+	}
+	count();
+	routes.push_back(R);
+	return (int) routes.size() - 1;
+}
+
+int MultiBus::lanes()
+{
+	return (int) lane.size();
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Single transactions go to the bus of the leg, a write to the broadcast address is a batch on every lane
+int MultiBus::writeReg8(int fd, int reg, int data)
+{
+	uint8_t value = data;
+	return writeBlock(fd, reg, &value, 1);
+}
+
+int MultiBus::writeBlock(int fd, int reg, const uint8_t *data, int n)
+{
+	if (fd < 0 || fd >= (int) routes.size())
+		return -1;
+	BusRoute &R = routes[fd];
+	if (R.lane == -1)
+	{
+		BusWrite W;
+		W.fd = fd; W.reg = reg; W.data = data; W.n = n;
+		return writeBatch(&W, 1);
+	}
+	int result = lane[R.lane]->bus->writeBlock(R.fds[R.lane], reg, data, n);
+	count();
+	return result;
+}
+
+int MultiBus::readReg8(int fd, int reg)
+{
+	if (fd < 0 || fd >= (int) routes.size())
+		return -1;
+	BusRoute &R = routes[fd];
+	int l = (R.lane == -1) ? 0 : R.lane;			// Reading the broadcast address reads the first bus
+	int value = lane[l]->bus->readReg8(R.fds[l], reg);
+	count();
+	return value;
+}
+
+int MultiBus::readBlock(int fd, int reg, uint8_t *data, int n)
+{
+	if (fd < 0 || fd >= (int) routes.size())
+		return -1;
+	BusRoute &R = routes[fd];
+	int l = (R.lane == -1) ? 0 : R.lane;
+	int result = lane[l]->bus->readBlock(R.fds[l], reg, data, n);
+	count();
+	return result;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Splits the batch per lane (a write to the broadcast address goes to every lane) and sends the parts at the same time
+int MultiBus::writeBatch(BusWrite *writes, int count)
+{
+	for (int l = 0; l < (int) lane.size(); l++)
+		lane[l]->count = 0;
+	for (int i = 0; i < count; i++)
+	{
+		writes[i].result = 0;
+		if (writes[i].fd < 0 || writes[i].fd >= (int) routes.size())
+		{
+			writes[i].result = -1;
+			continue;
+		}
+		BusRoute &R = routes[writes[i].fd];
+		for (int l = 0; l < (int) lane.size(); l++)
+		{
+			if (R.lane != -1 && R.lane != l)
+				continue;
+			BusLane *L = lane[l];
+			if (L->count >= BUS_BATCH_MAX)
+				return Bus::writeBatch(writes, count);		// More than one transaction on this bus anyway
+			L->writes[L->count] = writes[i]; L->writes[L->count].fd = R.fds[l];
+			L->origin[L->count] = i; L->count++;
+		}
+	}
+	run(MULTIBUS_WRITE_BATCH);
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (writes[i].result < 0)
+			result = -1;
+	}
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		BusLane *L = lane[l];
+		for (int k = 0; k < L->count; k++)
+		{
+			if (L->writes[k].result < 0)
+			{
+				writes[L->origin[k]].result = -1;		// A broadcast write failed if it failed on one of the buses
+				result = -1;
+			}
+		}
+	}
+	return result;
+}
+
+int MultiBus::readBatch(BusRead *reads, int count)
+{
+	for (int l = 0; l < (int) lane.size(); l++)
+		lane[l]->count = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reads[i].result = 0;
+		if (reads[i].fd < 0 || reads[i].fd >= (int) routes.size())
+		{
+			reads[i].result = -1;
+			continue;
+		}
+		BusRoute &R = routes[reads[i].fd];
+		int l = (R.lane == -1) ? 0 : R.lane;
+		BusLane *L = lane[l];
+		if (L->count >= BUS_BATCH_MAX)
+			return Bus::readBatch(reads, count);
+		L->reads[L->count] = reads[i]; L->reads[L->count].fd = R.fds[l];
+		L->origin[L->count] = i; L->count++;
+	}
+	run(MULTIBUS_READ_BATCH);
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (reads[i].result < 0)
+			result = -1;
+	}
+	for (int l = 0; l < (int) lane.size(); l++)
+	{
+		BusLane *L = lane[l];
+		for (int k = 0; k < L->count; k++)
+		{
+			reads[L->origin[k]].result = L->reads[k].result;
+			if (L->reads[k].result < 0)
+				result = -1;
+		}
+	}
+	return result;
+}
+
+string MultiBus::name()
+{
+	string names = "";
+	for (int l = 0; l < (int) lane.size(); l++)
+		names += ((l > 0) ? "," : "") + lane[l]->bus->name();
+	return names;
+}
@@ -0,0 +1,67 @@
+#ifndef MULTIBUS_H
+#define MULTIBUS_H
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdint.h>
+#include "Bus.h"
+using namespace std;
+
+// HEADER FILE FOR THE MULTIPLE BUSES! See the .cpp file for the extended explanations
+
+#define MULTIBUS_LANES_MAX 4		// Most buses in one MultiBus (the Pi 4 has five I2C controllers on the header, a leg side or leg pair per bus is enough)
+#define MULTIBUS_WRITE_BATCH 1		// Jobs of a lane thread
+#define MULTIBUS_READ_BATCH 2
+
+struct BusLane
+{
+	Bus *bus;
+	std::thread thread;		// The I/O thread of this bus
+	std::mutex lock;
+	std::condition_variable wake;	// Wakes the thread for a job
+	std::condition_variable done;	// Wakes MultiBus when the job is done
+	int job;			// MULTIBUS_WRITE_BATCH or MULTIBUS_READ_BATCH, 0 = nothing to do
+	BusWrite writes[BUS_BATCH_MAX];	// The part of a batch for this bus, with the handles of this bus
+	BusRead reads[BUS_BATCH_MAX];
+	int origin[BUS_BATCH_MAX];	// Index of every write or read in the batch of the caller
+	int count;			// Amount of writes or reads for this bus
+	int result;			// Result of the job
+	int stop;
+};
+
+struct BusRoute
+{
+	int lane;			// Bus of the leg, -1 = all buses (broadcast address)
+	int fds[MULTIBUS_LANES_MAX];	// Handle of the leg on its bus (or on every bus)
+};
+
+class MultiBus : public Bus
+{
+public:
+	MultiBus(const vector<Bus *> &buses);	// Starts an I/O thread per bus
+	~MultiBus();
+	int setup(int adress);
+	int setup(int adress, int bus);
+	int lanes();
+	int writeReg8(int fd, int reg, int data);
+	int readReg8(int fd, int reg);
+	int writeBlock(int fd, int reg, const uint8_t *data, int n);
+	int writeBatch(BusWrite *writes, int count);
+	int readBlock(int fd, int reg, uint8_t *data, int n);
+	int readBatch(BusRead *reads, int count);
+	string name();
+
+private:
+	vector<BusLane *> lane;
+	vector<BusRoute> routes;		// Route of every handle made by setup (handle = index)
+	void run(int job);			// Does the part of the batch of every lane at the same time, and waits for all of them (the barrier)
+	void count();				// syscalls = the kernel calls of all buses
+	void work(BusLane *L);			// The I/O thread of a lane
+};
+
+int MultiBusLane(int leg, int lanes); // The bus of leg *leg* (0-5, the order of connectLegs): ZEBRO_LEGBUS ("0,1,0,1,0,1"), or the left and right legs on two buses, front, middle and hind on three
+
+#endif
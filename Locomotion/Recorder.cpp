@@ -0,0 +1,281 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Recorder.h"
+#include <map>
+using namespace std;
+
+// THIS FILE CONTAINS THE SESSION RECORDER
+// To compare planner changes, the same session can be run again without the robot. When recording, every pass of the main loop
+// writes its time and key to the file, followed by all the I2C transactions (register writes and reads) done in that pass.
+// When replaying, the main loop takes its time and key from the file instead of the clock and the keyboard, reads return the
+// recorded values and the loop does not wait, so it runs as fast as the CPU allows. The writes of every pass are compared to the
+// recorded writes of the same pass, so a difference stays local to the pass where it happened.
+//
+// File format (binary, little endian, like the Pi):
+//   header:      "KZR1", int32 starting speed
+//   loop pass:   'L', double time (s), uint8 key
+//   transaction: 'W' (write) or 'R' (read), uint8 I2C address, uint8 register, int16 value
+
+
+struct Transaction
+{
+	char type;	// 'W' or 'R'
+	int adress;	// I2C address of the leg (0 = all legs)
+	int reg;	// Register
+	int value;	// Written or read value
+	int used;	// Read is already given back to the loop (replay)
+};
+
+struct Recorder
+{
+	int mode = RECORDER_OFF;
+	FILE *file = NULL;
+	map<int, int> adresses;			// File descriptor -> I2C address
+	vector<Transaction> expected;		// Recorded transactions of the current pass (replay)
+	vector<Transaction> emitted;		// Transactions done by the loop in the current pass (replay)
+	int haveNext = 0; double nextTime = 0; int nextCh = 0;	// The loop pass that is read ahead (replay)
+	double firstTime = 0; double lastTime = 0;
+	long loops = 0; long transactions = 0; long mismatches = 0; long mismatchLoops = 0;
+	std::chrono::steady_clock::time_point start;
+};
+
+static Recorder R;
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Small helpers to read and write the file
+static void writeTransaction(char type, int adress, int reg, int value)
+{
+	uint8_t a = adress; uint8_t r = reg; int16_t v = value;
+	fputc(type, R.file); fwrite(&a, 1, 1, R.file); fwrite(&r, 1, 1, R.file); fwrite(&v, 2, 1, R.file);
+}
+
+// Reads the transactions of one pass into R.expected, up to the next loop pass (which is read ahead) or the end of the file
+static void readPass()
+{
+	R.expected.clear();
+	R.haveNext = 0;
+	int type;
+	while ((type = fgetc(R.file)) != EOF)
+	{
+		if (type == 'L')
+		{
+			uint8_t ch;
+			if (fread(&R.nextTime, sizeof(double), 1, R.file) != 1 || fread(&ch, 1, 1, R.file) != 1)
+				break;
+			R.nextCh = ch; R.haveNext = 1;
+			return;
+		}
+		uint8_t a, r; int16_t v;
+		if (fread(&a, 1, 1, R.file) != 1 || fread(&r, 1, 1, R.file) != 1 || fread(&v, 2, 1, R.file) != 1)
+			break;
+		Transaction T = {(char) type, a, r, v, 0};
+		R.expected.push_back(T);
+	}
+}
+
+static void printTransaction(const char *name, Transaction T)
+{
+	cout << "   " << name << " " << T.type << " 0x" << hex << T.adress << dec << " reg " << T.reg << " = " << T.value << "\n";
+}
+
+// Compares the transactions the loop did in this pass to the recorded ones
+static void comparePass()
+{
+	unsigned int n = max(R.expected.size(), R.emitted.size());
+	long diff = 0;
+	int show = (R.mismatchLoops < RECORDER_SHOW_MISMATCHES);
+	for (unsigned int i = 0; i < n; i++)
+	{
+		int same = (i < R.expected.size() && i < R.emitted.size() && R.expected[i].type == R.emitted[i].type && R.expected[i].adress == R.emitted[i].adress
+			    && R.expected[i].reg == R.emitted[i].reg && (R.expected[i].type == 'R' || R.expected[i].value == R.emitted[i].value));
+		if (same == 1)
+			continue;
+		if (diff == 0 && show == 1)
+			cout << "\n Replay mismatch at t = " << R.lastTime << " s\n";
+		if (show == 1)
+		{
+			if (i < R.expected.size()) printTransaction("recorded", R.expected[i]);
+			if (i < R.emitted.size()) printTransaction("replayed", R.emitted[i]);
+		}
+		diff++;
+	}
+	if (diff > 0)
+	{
+		R.mismatches += diff;
+		R.mismatchLoops++;
+	}
+	R.emitted.clear();
+}
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Returns the mode of the recorder
+int RecorderMode()
+{
+	return R.mode;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts recording: writes the header with the starting speed
+int RecordStart(const char *filename, int speed)
+{
+	R.file = fopen(filename, "wb");
+	if (R.file == NULL)
+	{
+		cout << "\n Can not open " << filename << " for recording\n";
+		return 0;
+	}
+	int32_t s = speed;
+	fwrite("KZR1", 1, 4, R.file); fwrite(&s, 4, 1, R.file);
+	R.mode = RECORDER_RECORD;
+	R.loops = 0; R.transactions = 0; R.mismatches = 0; R.mismatchLoops = 0;
+	R.start = std::chrono::steady_clock::now();
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Starts replaying: checks the header and reads the transactions before the first loop pass
+int ReplayStart(const char *filename)
+{
+	R.file = fopen(filename, "rb");
+	char magic[4]; int32_t speed = 0;
+	if (R.file == NULL || fread(magic, 1, 4, R.file) != 4 || string(magic, 4) != "KZR1" || fread(&speed, 4, 1, R.file) != 1)
+	{
+		cout << "\n " << filename << " is not a recording\n";
+		return 0;
+	}
+	R.mode = RECORDER_REPLAY;
+	R.loops = 0; R.transactions = 0; R.mismatches = 0; R.mismatchLoops = 0;
+	R.emitted.clear();
+	readPass();
+	R.firstTime = R.nextTime; R.lastTime = R.nextTime;
+	R.start = std::chrono::steady_clock::now();
+	return speed;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Remembers which I2C address belongs to a file descriptor, so the file does not depend on the descriptors of one run
+void RecordSetup(int fd, int adress)
+{
+	R.adresses[fd] = adress;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Called once per loop pass, after the time and the key are known.
+// Recording: writes them to the file. Replaying: finishes the previous pass and gives the time and key of the next pass.
+int RecordLoop(double &time, int &ch)
+{
+	if (R.mode == RECORDER_RECORD)
+	{
+		uint8_t c = ch;
+		fputc('L', R.file); fwrite(&time, sizeof(double), 1, R.file); fwrite(&c, 1, 1, R.file);
+		R.loops++;
+		R.lastTime = time;
+		if (R.loops == 1)
+			R.firstTime = time;
+	}
+	if (R.mode == RECORDER_REPLAY)
+	{
+		comparePass();
+		if (R.haveNext == 0)
+		{
+			R.expected.clear();
+			return 0;					// End of the recording
+		}
+		time = R.nextTime; ch = R.nextCh;
+		R.lastTime = time;
+		readPass();
+		R.loops++;
+	}
+	return 1;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Records a register write. When replaying, the write is kept to compare it with the recording at the end of the pass.
+void RecordWrite(int fd, int reg, int value)
+{
+	if (R.mode == RECORDER_OFF)
+		return;
+	R.transactions++;
+	if (R.mode == RECORDER_RECORD)
+		writeTransaction('W', R.adresses[fd], reg, value);
+	else
+	{
+		Transaction T = {'W', R.adresses[fd], reg, (int16_t) value, 0};
+		R.emitted.push_back(T);
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Records a register read. When replaying, the recorded value of the same register of the same leg in this pass is given back.
+int RecordRead(int fd, int reg, int value)
+{
+	if (R.mode == RECORDER_OFF)
+		return value;
+	R.transactions++;
+	int adress = R.adresses[fd];
+	if (R.mode == RECORDER_RECORD)
+	{
+		writeTransaction('R', adress, reg, value);
+		return value;
+	}
+	value = 0;							// Read that was not recorded
+	for (unsigned int i = 0; i < R.expected.size(); i++)
+	{
+		if (R.expected[i].type == 'R' && R.expected[i].used == 0 && R.expected[i].adress == adress && R.expected[i].reg == reg)
+		{
+			value = R.expected[i].value;
+			R.expected[i].used = 1;
+			break;
+		}
+	}
+	Transaction T = {'R', adress, reg, value, 0};
+	R.emitted.push_back(T);
+	return value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Closes the file and prints the summary. The replay speed is the recorded session time divided by the time the replay took.
+long RecordFinish()
+{
+	if (R.mode == RECORDER_OFF)
+		return 0;
+	if (R.mode == RECORDER_REPLAY)
+		comparePass();						// The last pass, when the loop stopped before the end of the recording
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - R.start).count();
+	double session = R.lastTime - R.firstTime;
+	if (R.mode == RECORDER_RECORD)
+	{
+		cout << "\n Recorded " << R.loops << " loop passes and " << R.transactions << " transactions (" << ftell(R.file) << " bytes)\n";
+	}
+	else
+	{
+		cout << "\n Replayed " << R.loops << " loop passes and " << R.transactions << " transactions of " << session << " s in " << wall << " s";
+		if (wall > 0)
+			cout << " (" << session / wall << " x real time, " << R.loops / wall << " passes/s)";
+		cout << "\n Bus traffic: " << R.mismatches << " different transactions in " << R.mismatchLoops << " loop passes\n";
+	}
+	fclose(R.file);
+	R.file = NULL;
+	R.mode = RECORDER_OFF;
+	return R.mismatches;
+}
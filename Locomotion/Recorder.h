@@ -0,0 +1,30 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <vector>
+using namespace std;
+
+// HEADER FILE FOR THE SESSION RECORDER! See the .cpp file for the extended explanations
+
+#define RECORDER_OFF 0		// Normal operation, nothing is recorded
+#define RECORDER_RECORD 1	// The loop input and all bus transactions are written to the file
+#define RECORDER_REPLAY 2	// The loop is driven from the file, the bus is not used
+#define RECORDER_SHOW_MISMATCHES 10	// Amount of loops with different bus traffic that are printed in full when replaying
+
+int RecorderMode(); // Returns RECORDER_OFF, RECORDER_RECORD or RECORDER_REPLAY
+
+int RecordStart(const char *filename, int speed); // Starts recording to *filename*. Returns 0 if the file can not be opened
+
+int ReplayStart(const char *filename); // Starts replaying *filename*. Returns the recorded starting speed, or 0 if the file can not be used
+
+void RecordSetup(int fd, int adress); // Remembers the I2C address that belongs to a file descriptor
+
+int RecordLoop(double &time, int &ch); // Records the time and key of a loop pass, or replaces them by the recorded ones. Returns 0 at the end of a replay
+
+void RecordWrite(int fd, int reg, int value); // Records (or checks) a register write
+
+int RecordRead(int fd, int reg, int value); // Records a register read, returns the value that the loop should use
+
+long RecordFinish(); // Closes the file and prints the summary. Returns the amount of mismatches found by the replay
+
+#endif
@@ -0,0 +1,202 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE LOOKAHEAD SCHEDULE
+// Instead of only keeping PrevVec, CurVec and NextVec, the schedule keeps the next K touchdown/liftoff vectors of the current gait
+// in a ring buffer. Every vector is the Max-Plus product of the gait matrix and the vector before it (x(k+1) = mpm x(k)).
+// The main loop refills one vector per pass, so the Max-Plus calculations are spread over the time the loop is waiting anyway.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Initialises the schedule and fills it completely
+void ScheduleInit(Schedule &S, vector<vector<float> > mpm, vector<float> StartVec, int size)
+{
+	S.mpm = mpm;
+	S.Vecs = vector<vector<float> >(size, vector<float>(StartVec.size(), 0));
+	S.PrevVec = StartVec;
+	S.head = 0;
+	S.Vecs[0] = MPMVM(mpm, StartVec);	// The first vector is calculated from the starting vector
+	S.count = 1;
+	S.index = 0;
+	S.epoch = 0;
+	S.refills = 0; S.refillTime = 0; S.refillMax = 0;
+	ScheduleRefill(S, size);		// Fills the rest of the buffer
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Calculates at most *steps* new vectors at the end of the schedule. Returns the amount of vectors calculated.
+int ScheduleRefill(Schedule &S, int steps)
+{
+	int size = S.Vecs.size();
+	int done = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (done < steps && S.count < size)
+	{
+		int last = (S.head + S.count - 1) % size;	// The last valid vector
+		int next = (S.head + S.count) % size;		// The free spot behind it
+		MPMVM(S.mpm, S.Vecs[last], S.Vecs[next]);	// Into the existing vector, so the loop does not allocate
+		S.count++; done++;
+	}
+	if (done > 0)
+	{
+		double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		S.refills += done;
+		S.refillTime += elapsed;
+		if (elapsed > S.refillMax)
+			S.refillMax = elapsed;
+	}
+	return done;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Returns the vector k strides ahead of the current vector. When the schedule was not refilled far enough, the missing vectors are calculated now.
+const vector<float> &ScheduleAt(Schedule &S, int k)
+{
+	int size = S.Vecs.size();
+	if (k >= size)
+		k = size - 1;					// Can not look further ahead than the size of the buffer
+	if (k >= S.count)
+		ScheduleRefill(S, k - S.count + 1);
+	return S.Vecs[(S.head + k) % size];
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Moves the schedule one stride further. The current vector becomes PrevVec and the next vector becomes the current vector.
+void ScheduleAdvance(Schedule &S)
+{
+	int size = S.Vecs.size();
+	if (S.count < 2)
+		ScheduleRefill(S, 1);				// Makes sure there is a next vector
+	S.PrevVec = S.Vecs[S.head];
+	S.head = (S.head + 1) % size;
+	S.count--;
+	S.index++;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Changes the gait of the schedule. The vectors up to and including *from* strides ahead are kept (they may already be sent to the legs),
+// the vectors after that are thrown away and are recalculated with the new gait matrix.
+void ScheduleSetGait(Schedule &S, vector<vector<float> > mpm, int from)
+{
+	if (from < 0)
+		from = 0;
+	if (from >= S.count)
+		ScheduleAt(S, from);				// Makes sure the vectors that are kept exist (with the old gait)
+	S.mpm = mpm;
+	S.count = from + 1;
+	S.epoch++;
+	ScheduleRefill(S, 1);					// The next vector is needed soon, the rest is refilled by the main loop
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Changes the gait of the schedule through a planned transition (see Transition.cpp). The vectors up to and including *from* strides ahead are kept,
+// followed by the transition vectors. The vectors after the transition are calculated with the new gait matrix.
+void ScheduleSetTransition(Schedule &S, vector<vector<float> > mpm, int from, vector<vector<float> > Vecs)
+{
+	int size = S.Vecs.size();
+	if (from < 0)
+		from = 0;
+	if (from >= S.count)
+		ScheduleAt(S, from);				// Makes sure the vectors that are kept exist (with the old gait)
+	S.mpm = mpm;
+	S.count = from + 1;
+	S.epoch++;
+	for (unsigned int j = 0; j < Vecs.size() && S.count < size; j++)
+	{
+		S.Vecs[(S.head + S.count) % size] = Vecs[j];
+		S.count++;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Moves the whole schedule *shift* seconds later (PrevVec and all vectors ahead). The gait stays the same, only the start time changes.
+// Entries of -1 (minus infinity, no event) are not moved.
+void ScheduleShift(Schedule &S, float shift)
+{
+	int size = S.Vecs.size();
+	S.epoch++;						// A transition that is being planned starts from a vector that is not in the schedule anymore
+	for (unsigned int j = 0; j < S.PrevVec.size(); j++)
+		if (S.PrevVec[j] >= 0)
+			S.PrevVec[j] += shift;
+	for (int k = 0; k < S.count; k++)
+	{
+		vector<float> &Vec = S.Vecs[(S.head + k) % size];
+		for (unsigned int j = 0; j < Vec.size(); j++)
+			if (Vec[j] >= 0)
+				Vec[j] += shift;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the refill benchmark: the amount of calculated vectors and the average and worst time it took
+void SchedulePrintStats(Schedule &S)
+{
+	double average = 0;
+	if (S.refills > 0)
+		average = S.refillTime / S.refills;
+	cout << "\n Schedule: stride " << S.index << ", " << S.count << "/" << S.Vecs.size() << " vectors ahead, " << S.refills << " refills, "
+	     << average * 1e6 << " us per vector, worst call " << S.refillMax * 1e6 << " us \n";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The self check of ./Walking schedulecheck [strides]. For the gait of every speed the schedule walks *strides* strides the way the loop
+// uses it (one refill per pass, ScheduleAt for CurVec and NextVec), and every CurVec is compared with x(k+1) = mpm x(k) calculated with
+// MPMVM directly. Halfway the gait changes to the gait of the next speed with ScheduleSetGait, which has to keep NextVec.
+// The refill cost is printed next to the cost of the plain MPMVM calls (which allocate a new vector every time).
+long ScheduleCheck(int strides)
+{
+	long mismatches = 0; long vectors = 0;
+	double refillTime = 0; double refillMax = 0; long refills = 0;
+	double directTime = 0; long directs = 0;
+	for (int speed = 1; speed <= SCHEDULE_CHECK_SPEEDS; speed++)
+	{
+		vector<vector<float> > mpm = gait(speed);
+		vector<vector<float> > mpmNext = gait(speed % SCHEDULE_CHECK_SPEEDS + 1);
+		vector<float> Ref(12, 0);
+		Schedule S; ScheduleInit(S, mpm, Ref, SCHEDULE_DEFAULT_SIZE);
+		Ref = MPMVM(mpm, Ref);					// The first vector of the schedule
+		for (int k = 0; k < strides; k++)
+		{
+			if (ScheduleAt(S, 0) != Ref)
+				mismatches++;
+			vectors++;
+			auto start = std::chrono::steady_clock::now();
+			Ref = MPMVM(mpm, Ref);
+			directTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); directs++;
+			if (k == strides / 2)
+			{
+				ScheduleSetGait(S, mpmNext, 1);		// CurVec and NextVec stay (NextVec with the old gait), the strides after them follow the new gait
+				mpm = mpmNext;
+			}
+			ScheduleAdvance(S);
+			ScheduleRefill(S, 1);				// One vector per loop pass
+		}
+		refillTime += S.refillTime; refills += S.refills;
+		if (S.refillMax > refillMax)
+			refillMax = S.refillMax;
+	}
+	cout << "\n Schedule check: " << SCHEDULE_CHECK_SPEEDS << " gaits, " << vectors << " vectors, " << mismatches << " differ from MPMVM \n";
+	cout << " Refill: " << ((refills > 0) ? refillTime / refills : 0) * 1e6 << " us per vector, worst call " << refillMax * 1e6
+	     << " us, MPMVM: " << ((directs > 0) ? directTime / directs : 0) * 1e6 << " us per vector \n";
+	return mismatches;
+}
@@ -0,0 +1,46 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <vector>
+using namespace std;
+
+// HEADER FILE FOR THE LOOKAHEAD SCHEDULE! See the .cpp file for the extended explanations
+// Only the standard headers are included here, so the other headers can include this one for the Schedule type.
+
+#define SCHEDULE_DEFAULT_SIZE 16	// Amount of touchdown/liftoff vectors that are kept ahead (K)
+#define SCHEDULE_CHECK_SPEEDS 99	// ./Walking schedulecheck checks the gaits of the speeds 1 up to this one
+#define SCHEDULE_CHECK_STRIDES 200	// and walks this many strides with every gait when it is not given
+
+struct Schedule
+{
+	vector<vector<float> > mpm;	// The Max-Plus gait matrix used to extend the schedule
+	vector<vector<float> > Vecs;	// Ring buffer with the touchdown/liftoff vectors, Vecs[head] is the current vector
+	vector<float> PrevVec;		// The vector before the current vector
+	int head;			// Position of the current vector in the ring buffer
+	int count;			// Amount of valid vectors in the ring buffer, starting at head
+	long index;			// Stride index of the current vector (counted from the start of the program)
+	long epoch;			// Counts the changes of the vectors ahead other than refills (gait change, transition, shift), a gait transition planned before one does not fit anymore
+	long refills;			// Amount of vectors calculated by ScheduleRefill (benchmark)
+	double refillTime;		// Total time spent in ScheduleRefill in seconds (benchmark)
+	double refillMax;		// Longest single ScheduleRefill call in seconds (benchmark)
+};
+
+void ScheduleInit(Schedule &S, vector<vector<float> > mpm, vector<float> StartVec, int size); // Fills the schedule with the vectors following StartVec
+
+int ScheduleRefill(Schedule &S, int steps); // Calculates at most *steps* new vectors at the end of the schedule
+
+const vector<float> &ScheduleAt(Schedule &S, int k); // Returns the vector k strides ahead of the current vector (0 = CurVec, 1 = NextVec)
+
+void ScheduleAdvance(Schedule &S); // Makes the next vector the current vector
+
+void ScheduleSetGait(Schedule &S, vector<vector<float> > mpm, int from); // Keeps the vectors up to *from*, and recomputes the rest with the new gait
+
+void ScheduleSetTransition(Schedule &S, vector<vector<float> > mpm, int from, vector<vector<float> > Vecs); // Same, but the vectors after *from* start with the transition vectors
+
+void ScheduleShift(Schedule &S, float shift); // Moves PrevVec and all vectors ahead *shift* seconds later (rebase after missed deadlines)
+
+void SchedulePrintStats(Schedule &S); // Prints the refill benchmark
+
+long ScheduleCheck(int strides); // Compares the schedule with repeated MPMVM calls for the gait of every speed, prints the refill cost. Returns the amount of vectors that differ
+
+#endif
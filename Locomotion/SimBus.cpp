@@ -0,0 +1,487 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Bus.h"
+#include "SimBus.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE SIMULATED ZEBROBUS
+// Six (or up to twelve) legs that answer like the leg firmware (KiloZebro/code/leg_module) does over the ZebroBus:
+//  - a write to 0x00 goes to all legs, writes and reads auto increment the register (zebrobus.c)
+//  - registers 30-36 are staged and only take effect when 37 (VREGS_MOTION_UPDATE) is written (motion.c). Writing 2 to 37 puts the walk
+//    command in the queue instead: it starts when the command before it reaches its time, a command that is queued already is ignored.
+//    38 is the queue depth, 1 to 39 empties it
+//  - register 11 sets the clock of the leg to whole seconds, 11-13 read back the seconds and the 64000 ticks/s counter (time.c)
+//  - register 200 latches the clock (201-203) with the sequence number (204), 205-206 slew and 207-208 trim it, 209 is the slew
+//    that is left (time.c). The crystal of every leg is off by a fixed amount (-300 to +240 ppm), so the clocks drift apart
+//  - registers 110-113 give the encoder position (high byte first), direction and calibration state (encoder.c)
+//  - register 22 with 0x12 resets the emergency stop (errors.c), mode 255 sets it
+// The legs themselves are ideal: a walk command moves the leg at constant speed to the commanded position, arriving exactly at
+// the commanded time (or as fast as SIM_MAX_SPEED allows). Calibration is instant and sets the position to 0.
+// Every transaction takes *latency* microseconds plus *byteTime* for every byte on the bus (address, register and data, 90 us at
+// 100 kHz), so the load of the bus on the loop can be measured without a robot.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes the legs at the positions the Locomotion code uses (0x10, 0x12 ... 0x1a)
+SimBus::SimBus(int latency, int byteTime) : transactions(0), legs(SIM_POSITIONS), latency(latency), byteTime(byteTime)
+{
+	start = std::chrono::steady_clock::now();
+	for (int p = 0; p < SIM_POSITIONS; p++)
+	{
+		SimLeg &L = legs[p];
+		memset(L.vregs, 0, sizeof(L.vregs));
+		memset(L.staged, 0, sizeof(L.staged));
+		memset(L.broadcast, 0, sizeof(L.broadcast));
+		L.present = (p % 2 == 0);
+		L.clock = 0; L.clockRef = 0; L.trim = 0; L.slew = 0; L.high = 0;
+		L.drift = ((p * 7) % 11 - 5) * 60e-6;
+		L.position = 0; L.startPosition = 0; L.startTime = 0; L.distance = 0; L.speed = 0;
+		L.queued = 0; L.endValid = 0; L.end = 0;
+		L.speedStored = 0;
+		L.failSkip = 0; L.failCount = 0;
+		L.vregs[1] = 1;				// VREGS_PRODUCT_ID
+		L.vregs[2] = 1;				// VREGS_PRODUCT_VERSION
+		L.vregs[3] = 1;				// VREGS_SERIAL_ID
+		L.vregs[5] = SIM_ADDRESS_OFFSET + p;	// VREGS_ZEBROBUS_ADDRESS
+		L.vregs[6] = (p < SIM_POSITIONS / 2) ? 0 : 1;	// VREGS_LEG_SIDE
+		L.vregs[7] = p;				// VREGS_LEG_ADDRESS
+	}
+}
+
+string SimBus::name()
+{
+	return "sim (" + to_string(latency) + " us per transaction, " + to_string(byteTime) + " us per byte)";
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// The handle of a leg is its address, 0 is all legs
+int SimBus::setup(int adress)
+{
+	return adress;
+}
+
+int SimBus::writeReg8(int fd, int reg, int data)
+{
+	uint8_t value = data;
+	return write(fd, reg, &value, 1);
+}
+
+int SimBus::writeBlock(int fd, int reg, const uint8_t *data, int n)
+{
+	return write(fd, reg, data, n);
+}
+
+int SimBus::readBlock(int fd, int reg, uint8_t *data, int n)
+{
+	return (read(fd, reg, data, n) < 0) ? -1 : 0;
+}
+
+int SimBus::readReg8(int fd, int reg)
+{
+	uint8_t value;
+	if (read(fd, reg, &value, 1) < 0)
+		return -1;
+	return value;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Connects or disconnects a leg
+void SimBus::setPresent(int adress, int present)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	int p = adress - SIM_ADDRESS_OFFSET;
+	if (p >= 0 && p < SIM_POSITIONS)
+		legs[p].present = present;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes a leg miss write messages, a NACK in the middle of a batch (./Walking queuecheck)
+void SimBus::failWrites(int adress, int skip, int count)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	int p = adress - SIM_ADDRESS_OFFSET;
+	if (p >= 0 && p < SIM_POSITIONS)
+	{
+		legs[p].failSkip = skip; legs[p].failCount = count;
+	}
+}
+
+// The queue of a leg is not in its registers, only its depth (38)
+int SimBus::queued(int adress, uint8_t Commands[SIM_QUEUE_SIZE][8])
+{
+	std::lock_guard<std::mutex> guard(lock);
+	int p = adress - SIM_ADDRESS_OFFSET;
+	if (p < 0 || p >= SIM_POSITIONS)
+		return 0;
+	memcpy(Commands, legs[p].queue, sizeof(legs[p].queue));
+	return legs[p].queued;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Simulation time in seconds
+double SimBus::now()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Takes the time of one transaction of *bytes* bytes. Busy waiting, because sleeping is not accurate enough for a few microseconds.
+// The wait yields, so the simulated buses of a MultiBus (each in its own thread) also overlap on a single core.
+void SimBus::wait(int bytes)
+{
+	int duration = latency + bytes * byteTime;
+	if (duration <= 0)
+		return;
+	auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(duration);
+	while (std::chrono::steady_clock::now() < end) {std::this_thread::yield();}
+}
+
+double SimBus::legTime(int position)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	SimLeg &L = legs[position];
+	return clockAt(L, now());
+}
+
+// The clock of the leg at time t: it runs (1 + drift) / (1 + trim) as fast as the simulation, and slews at most SIM_SLEW_TICKS per second.
+// The slew that is left at t goes in *slew*.
+double SimBus::clockAt(const SimLeg &L, double t, double *slew)
+{
+	double dt = t - L.clockRef;
+	double most = (dt > 0) ? dt * SIM_SLEW_TICKS / SIM_CLOCK_TICKS : 0;
+	double slewed = (fabs(L.slew) <= most) ? L.slew : copysign(most, L.slew);
+	if (slew != NULL)
+		*slew = L.slew - slewed;
+	double rate = (1 + L.drift) / (1 + L.trim / (16.0 * SIM_CLOCK_TICKS));
+	return fmod(L.clock + dt * rate - slewed + 512, 256);
+}
+
+// Makes t the reference of the clock, before its rate or slew changes
+void SimBus::rebase(SimLeg &L, double t)
+{
+	double slew;
+	L.clock = clockAt(L, t, &slew);
+	L.slew = slew; L.clockRef = t;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Writes n registers starting at reg
+int SimBus::write(int adress, int reg, const uint8_t *data, int n)
+{
+	wait(2 + n);					// Address, register, data
+	std::lock_guard<std::mutex> guard(lock);
+	transactions++; syscalls++;
+	return writeLeg(adress, reg, data, n, now());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Writes several legs in one transaction (repeated starts, every message has its own address and register)
+int SimBus::writeBatch(BusWrite *writes, int count)
+{
+	int bytes = 0;
+	for (int i = 0; i < count; i++)
+		bytes += 2 + writes[i].n;
+	wait(bytes);
+	std::lock_guard<std::mutex> guard(lock);
+	transactions++; syscalls++;
+	double t = now();
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		writes[i].result = (writeLeg(writes[i].fd, writes[i].reg, writes[i].data, writes[i].n, t) < 0) ? -1 : 0;
+		if (writes[i].result < 0)
+			result = -1;
+	}
+	return result;
+}
+
+// Handles the registers written to *adress* (0 is all legs), returns -1 if nobody acknowledged it. The lock must be held.
+int SimBus::writeLeg(int adress, int reg, const uint8_t *data, int n, double t)
+{
+	int done = 0;
+	for (int p = 0; p < SIM_POSITIONS; p++)
+	{
+		if (legs[p].present == 0 || (adress != 0 && adress != SIM_ADDRESS_OFFSET + p))
+			continue;
+		if (adress != 0 && legs[p].failCount > 0)
+		{
+			if (legs[p].failSkip > 0)
+				legs[p].failSkip--;
+			else
+			{
+				legs[p].failCount--;
+				return -1;				// The leg does not acknowledge this message
+			}
+		}
+		for (int i = 0; i < n; i++)
+			writeRegister(legs[p], (reg + i) % SIM_VREGS_SIZE, data[i], t);
+		done = 1;
+	}
+	if (done == 0 && adress != 0)
+		return -1;				// Nobody acknowledged the address
+	return 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads n registers starting at reg
+int SimBus::read(int adress, int reg, uint8_t *data, int n)
+{
+	wait(3 + n);					// Address, register, address again, data
+	std::lock_guard<std::mutex> guard(lock);
+	transactions++; syscalls++;
+	return readLeg(adress, reg, data, n, now());
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Reads several legs in one transaction (a register write and a read per leg, all separated by repeated starts)
+int SimBus::readBatch(BusRead *reads, int count)
+{
+	int bytes = 0;
+	for (int i = 0; i < count; i++)
+		bytes += 3 + reads[i].n;
+	wait(bytes);
+	std::lock_guard<std::mutex> guard(lock);
+	transactions++; syscalls++;
+	double t = now();
+	int result = 0;
+	for (int i = 0; i < count; i++)
+	{
+		reads[i].result = (readLeg(reads[i].fd, reads[i].reg, reads[i].data, reads[i].n, t) < 0) ? -1 : 0;
+		if (reads[i].result < 0)
+			result = -1;
+	}
+	return result;
+}
+
+// Reads the registers of the leg at *adress*, returns -1 if it did not acknowledge. The lock must be held.
+int SimBus::readLeg(int adress, int reg, uint8_t *data, int n, double t)
+{
+	int p = adress - SIM_ADDRESS_OFFSET;
+	if (p < 0 || p >= SIM_POSITIONS || legs[p].present == 0)
+		return -1;
+	SimLeg &L = legs[p];
+	update(L, t);
+	for (int i = 0; i < n; i++)
+		data[i] = L.vregs[(reg + i) % SIM_VREGS_SIZE];
+	return n;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Handles one written register, like zebrobus_process_write_requests does
+void SimBus::writeRegister(SimLeg &L, int reg, uint8_t data, double t)
+{
+	if (reg >= 30 && reg <= 36)
+		L.staged[reg - 30] = data;			// New motion command, not active yet
+	else if (reg == 37)
+		commit(L, t, data == 2);			// MOTION_UPDATE_QUEUE
+	else if (reg == 39 && data == 1)
+	{
+		update(L, t);
+		L.queued = 0; L.vregs[38] = 0;			// motion_queue_flush
+	}
+	else if (reg == 11)
+	{
+		update(L, t);
+		L.clock = data; L.clockRef = t; L.slew = 0;	// time_set_time: whole seconds, the counter starts at 0
+	}
+	else if (reg == 200)
+	{
+		double clock = clockAt(L, t);			// time_latch, scaled to 64000 ticks per second
+		unsigned int ticks = (unsigned int) ((clock - floor(clock)) * SIM_CLOCK_TICKS);
+		L.vregs[201] = ((int) floor(clock)) % 256;
+		L.vregs[202] = ticks >> 8; L.vregs[203] = ticks & 0xFF;
+		L.vregs[204] = data;
+	}
+	else if (reg == 205 || reg == 207)
+		L.high = data;
+	else if (reg == 206)
+	{
+		update(L, t);
+		rebase(L, t);
+		int ticks = (int16_t) ((L.high << 8) | data);	// Ticks the clock is ahead
+		if (abs(ticks) > SIM_STEP_TICKS)
+		{
+			L.clock = fmod(L.clock - (double) ticks / SIM_CLOCK_TICKS + 256, 256);
+			ticks = 0;
+		}
+		L.slew = (double) ticks / SIM_CLOCK_TICKS;
+	}
+	else if (reg == 208)
+	{
+		update(L, t);
+		rebase(L, t);
+		L.trim = (int16_t) ((L.high << 8) | data);
+	}
+	else if (reg == 8 && data <= 2)
+	{
+		L.speedStored = data;				// zebrobus_store_speed, taken at the next boot
+		L.vregs[8] = (L.speedStored << 4) | (L.vregs[8] & 0x0F);
+	}
+	else if (reg == 9 && data == SIM_REBOOT_KEY)
+		reboot(L, t);
+	else if (reg == 22 && data == 0x12)
+		L.vregs[22] = 0;				// Reset emergency stop
+	else if (reg == 3 || reg == 86)
+		L.vregs[reg] = data;				// Serial id and test field can be written
+	else if (reg == SIM_BROADCAST_MODE)
+		L.broadcast[0] = data;
+	else if (reg > SIM_BROADCAST_MODE && reg < SIM_BROADCAST_UPDATE)
+	{
+		int p = L.vregs[7];				// Position of the leg (VREGS_LEG_ADDRESS)
+		int slice = SIM_BROADCAST_MODE + 1 + (p / 2) * 4;
+		if (p % 2 == 0 && reg >= slice && reg < slice + 4)
+			L.broadcast[1 + reg - slice] = data;	// Position a, position b, time a, time b of this leg
+	}
+	else if (reg == SIM_BROADCAST_UPDATE)
+	{
+		uint8_t unicast[8];
+		memcpy(unicast, L.staged, sizeof(unicast));	// The broadcast command has its own state in the firmware
+		memcpy(L.staged, L.broadcast, sizeof(L.staged));
+		L.staged[5] = 1;				// New data flag
+		commit(L, t, data == 2);
+		memcpy(L.staged, unicast, sizeof(unicast));
+		memset(L.broadcast, 0, sizeof(L.broadcast));
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Restarts the leg (VREGS_ZEBROBUS_REBOOT): the motion, the queue and the clock start over, the stored bus timing preset becomes active.
+// The leg stays where it is, it only forgets what it was doing.
+void SimBus::reboot(SimLeg &L, double t)
+{
+	update(L, t);
+	memset(L.staged, 0, sizeof(L.staged));
+	memset(L.broadcast, 0, sizeof(L.broadcast));
+	L.clock = 0; L.clockRef = t; L.trim = 0; L.slew = 0;
+	L.startPosition = L.position; L.startTime = t; L.distance = 0; L.speed = 0;
+	L.queued = 0; L.endValid = 0; L.vregs[38] = 0;
+	L.vregs[8] = (L.speedStored << 4) | L.speedStored;
+	L.vregs[14] = 0; L.vregs[22] = 0;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Activates the staged motion command (VREGS_MOTION_UPDATE), which also empties the queue, or puts it at the end of the queue
+void SimBus::commit(SimLeg &L, double t, int queue)
+{
+	update(L, t);
+	int mode = L.staged[0];
+	if (L.vregs[22] != 0 && mode != 0 && mode != 1 && mode != 255)
+	{
+		memset(L.staged, 0, sizeof(L.staged));	// Only idle, calibrate and panic are accepted during an emergency stop
+		return;
+	}
+	if (queue == 1)
+	{
+		int queued = 0;						// A command that is queued already is dropped as well (a repeated batch)
+		for (int i = 0; i < L.queued; i++)
+			queued |= (memcmp(L.queue[i], L.staged, 5) == 0);	// Mode, position and time
+		if ((mode == 2 || mode == 3) && L.queued < SIM_QUEUE_SIZE && queued == 0)	// Other commands, or a full queue: the command is dropped
+		{
+			memcpy(L.queue[L.queued], L.staged, 8);
+			L.queued++;
+		}
+	}
+	else
+	{
+		L.queued = 0;
+		activate(L, L.staged, t);
+	}
+	L.vregs[38] = L.queued;
+	memset(L.staged, 0, sizeof(L.staged));
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Makes *command* (registers 30-36) the current motion command at time t
+void SimBus::activate(SimLeg &L, const uint8_t *command, double t)
+{
+	int mode = command[0];
+	memcpy(&L.vregs[30], command, 7);
+	L.startPosition = L.position; L.startTime = t; L.distance = 0; L.speed = 0;
+	L.endValid = 0;
+	if (mode == 1)
+	{
+		L.position = 0; L.startPosition = 0;	// Calibration: the leg is at the hall sensor
+		L.vregs[30] = 0;
+	}
+	else if (mode == 255)
+	{
+		L.vregs[22] = 1;
+		L.queued = 0;
+	}
+	else if (mode == 2 || mode == 3)
+	{
+		int target = (L.vregs[31] << 8) + L.vregs[32];
+		double arrival = L.vregs[33] + L.vregs[34] * 0.004;		// Leg time in seconds
+		double delta = fmod(arrival - clockAt(L, t) + 256 + 128, 256) - 128;	// Rollover like time_calculate_delta
+		double forward = fmod(target - L.position + 2 * SIM_PULSES, SIM_PULSES);
+		L.distance = (mode == 2) ? forward : forward - SIM_PULSES;
+		if (forward == 0)
+			L.distance = 0;
+		L.speed = (delta > 0) ? fabs(L.distance) / delta : SIM_MAX_SPEED;
+		if (L.speed > SIM_MAX_SPEED)
+			L.speed = SIM_MAX_SPEED;
+		L.endValid = 1; L.end = arrival;
+	}
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Moves the leg to time t, starting the queued commands whose turn came on the way, and writes the clock and encoder registers
+void SimBus::update(SimLeg &L, double t)
+{
+	while (1 == 1)
+	{
+		double due = t;						// When the next queued command starts
+		if (L.endValid == 1)
+		{
+			double delta = fmod(L.end - clockAt(L, t) + 256 + 128, 256) - 128;	// Time until the current command should arrive
+			if (delta > 0)
+				break;
+			L.endValid = 0;
+			due = t + delta;
+		}
+		if (L.queued == 0 || L.vregs[22] != 0)
+			break;
+		move(L, due);
+		uint8_t command[8];
+		memcpy(command, L.queue[0], 8);
+		L.queued--;
+		memmove(L.queue[0], L.queue[1], 8 * L.queued);
+		L.vregs[38] = L.queued;
+		activate(L, command, due);
+	}
+	move(L, t);
+	double slew;
+	double legtime = clockAt(L, t, &slew);
+	int residual = (int) lround(slew * SIM_CLOCK_TICKS);
+	L.vregs[209] = (uint8_t) (int8_t) ((residual > 127) ? 127 : (residual < -128) ? -128 : residual);	// VREGS_CLOCK_RESIDUAL
+	unsigned int ticks = (unsigned int) ((legtime - floor(legtime)) * SIM_CLOCK_TICKS);
+	L.vregs[11] = ((int) floor(legtime)) % 256;
+	L.vregs[12] = ticks >> 8; L.vregs[13] = ticks & 0xFF;
+	int counter = (int) L.position;
+	L.vregs[110] = counter >> 8; L.vregs[111] = counter & 0xFF;
+	L.vregs[113] = 0;
+}
+
+// Moves the leg along the current motion command to time t
+void SimBus::move(SimLeg &L, double t)
+{
+	if (L.distance != 0)
+	{
+		double moved = L.speed * (t - L.startTime);
+		if (moved >= fabs(L.distance))
+		{
+			moved = fabs(L.distance);
+			L.vregs[30] = 0;					// Arrived: back to idle
+		}
+		double p = L.startPosition + (L.distance > 0 ? moved : -moved);
+		L.position = fmod(p + SIM_PULSES, SIM_PULSES);
+		if (L.vregs[30] == 0)
+			L.distance = 0;
+		L.vregs[112] = (L.distance < 0);
+	}
+}
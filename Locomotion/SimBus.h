@@ -0,0 +1,93 @@
+#ifndef SIMBUS_H
+#define SIMBUS_H
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <stdint.h>
+#include "Bus.h"
+using namespace std;
+
+// HEADER FILE FOR THE SIMULATED ZEBROBUS! See the .cpp file for the extended explanations
+
+#define SIM_POSITIONS 12		// Leg positions on the ZebroBus (address = 0x10 + position)
+#define SIM_ADDRESS_OFFSET 0x10		// ADDRESS_ZEBROBUS_OFFSET of the firmware
+#define SIM_VREGS_SIZE 256		// VREGS_FILE_SIZE of the firmware
+#define SIM_PULSES 910			// ENCODER_PULSES_PER_ROTATION of the firmware
+#define SIM_MAX_SPEED 1820		// Fastest leg speed in pulses per second (2 rotations per second)
+#define SIM_CLOCK_TICKS 64000		// TIME_ONE_SECOND_COUNTER_VALUE of the firmware
+#define SIM_BROADCAST_MODE 170		// VREGS_BROADCAST_MODE of the firmware, followed by 4 bytes per leg (position p has slice p / 2)
+#define SIM_BROADCAST_UPDATE 195	// VREGS_BROADCAST_UPDATE of the firmware
+#define SIM_SLEW_TICKS 320		// TIME_SLEW_MAX_TICKS of the firmware: most ticks a leg slews its clock per second
+#define SIM_STEP_TICKS 640		// TIME_SLEW_STEP_TICKS of the firmware: a larger slew steps the clock at once
+#define SIM_QUEUE_SIZE 8		// MOTION_QUEUE_SIZE of the firmware (VREGS_MOTION_QUEUE_DEPTH 38, VREGS_MOTION_QUEUE_FLUSH 39)
+#define SIM_REBOOT_KEY 0xB0		// ZEBROBUS_REBOOT_KEY of the firmware (VREGS_ZEBROBUS_REBOOT 9)
+
+struct SimLeg
+{
+	int present;			// 0 if no leg is connected at this position (reads are not acknowledged)
+	uint8_t vregs[SIM_VREGS_SIZE];	// The virtual registers as they are read over the bus
+	uint8_t staged[8];		// Motion registers 30-37 written since the last update (new_state of motion.c)
+	uint8_t broadcast[8];		// The slice of this leg of the broadcast frame 170-195, laid out like staged (broadcast_state of motion.c)
+	double clock;			// Time of the clock of the leg at clockRef (seconds, 0 - 256)
+	double clockRef;		// Simulation time of clock
+	double drift;			// The crystal of the leg runs this much too fast (s/s)
+	int trim;			// Clock trim (VREGS_CLOCK_TRIM, 1/16 ticks per second)
+	double slew;			// Part of the clock slew that was not applied at clockRef (s)
+	uint8_t high;			// First byte of the slew or trim that is being written
+	double position;		// Leg position in encoder pulses (0 - 909)
+	double startPosition;		// Position when the current motion command was started
+	double startTime;		// Simulation time when the current motion command was started
+	double distance;		// Distance of the current motion command in pulses (negative is backward)
+	double speed;			// Speed of the current motion command in pulses per second
+	uint8_t queue[SIM_QUEUE_SIZE][8];	// Walk commands written with update value 2, started one after the other (queue of motion.c)
+	int queued;			// Amount of commands in the queue
+	int endValid;			// 1 while the current command is a walk command that did not reach its time yet
+	double end;			// Leg time the current walk command should arrive (seconds, 0 - 256)
+	uint8_t speedStored;		// Bus timing preset for the next boot (the flash page of zebrobus.c)
+	int failSkip, failCount;	// After failSkip more messages to this leg, the next failCount are not acknowledged (failWrites)
+};
+
+class SimBus : public Bus
+{
+public:
+	SimBus(int latency, int byteTime = 0);		// A transaction takes *latency* plus *byteTime* per byte on the bus (both in microseconds)
+	int setup(int adress);
+	int writeReg8(int fd, int reg, int data);
+	int readReg8(int fd, int reg);
+	int writeBlock(int fd, int reg, const uint8_t *data, int n);
+	int writeBatch(BusWrite *writes, int count);
+	int readBlock(int fd, int reg, uint8_t *data, int n);
+	int readBatch(BusRead *reads, int count);
+	string name();
+
+	int write(int adress, int reg, const uint8_t *data, int n);	// Writes n registers starting at reg, like one I2C write with auto increment
+	int read(int adress, int reg, uint8_t *data, int n);		// Reads n registers starting at reg, like one I2C read with auto increment
+	void setPresent(int adress, int present);			// Connects or disconnects the leg at *adress*
+	double legTime(int position);					// Time of the clock of a leg in seconds (0 - 256)
+	void failWrites(int adress, int skip, int count);		// The leg at *adress* does not acknowledge *count* write messages after the next *skip*
+	int queued(int adress, uint8_t Commands[SIM_QUEUE_SIZE][8]);	// Copies the queued commands of a leg (registers 30-37), returns how many
+	long transactions;						// Amount of transactions handled
+
+private:
+	vector<SimLeg> legs;
+	int latency;
+	int byteTime;
+	std::chrono::steady_clock::time_point start;
+	std::mutex lock;
+	double now();
+	void wait(int bytes);
+	void update(SimLeg &L, double t);
+	int writeLeg(int adress, int reg, const uint8_t *data, int n, double t);
+	int readLeg(int adress, int reg, uint8_t *data, int n, double t);
+	void writeRegister(SimLeg &L, int reg, uint8_t data, double t);
+	void commit(SimLeg &L, double t, int queue);
+	void activate(SimLeg &L, const uint8_t *command, double t);
+	void move(SimLeg &L, double t);
+	double clockAt(const SimLeg &L, double t, double *slew = NULL);
+	void rebase(SimLeg &L, double t);
+	void reboot(SimLeg &L, double t);
+};
+
+#endif
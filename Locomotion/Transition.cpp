@@ -0,0 +1,211 @@
+#include <iostream>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <vector>
+#include <time.h>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include <ncurses.h>
+#include <termios.h>
+#include <fcntl.h>
+#include "MaxPlusCalc.h"
+#include "Gaits.h"
+#include "Decisions.h"
+#include "Supporting.h"
+#include "Communications.h"
+#include "Schedule.h"
+#include "Transition.h"
+using namespace std;
+
+// THIS FILE CONTAINS THE GAIT TRANSITION PLANNER
+// When the speed changes, the new gait matrix can not simply be applied to the vectors of the old gait: the first strides of the new gait
+// may lie in the past or take a long time to settle. The planner computes an intermediate Max-Plus schedule that:
+//  - starts from the last vector of the old gait that is kept (StartVec),
+//  - never lets a leg lift off before now + TRANSITION_MARGIN,
+//  - keeps all the precedence constraints of the new gait (every stride is closed with A_0*),
+//  - reaches the periodic regime of the new gait (x(k+1) = period + x(k)) as early as possible.
+// The earliest schedule is found by iterating the new gait matrix until the periodic regime is found. Because that can take a few
+// strides, every stride j on the way is also tried as the start of the periodic regime: the periodic vector is shifted just far enough
+// to stay behind the iterated stride j (so it is still feasible), and the j that makes the new gait periodic the earliest is chosen.
+
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Checks if every element of A is the same amount later than the element of B. The amount is returned in *step*.
+int constantStep(vector<float> A, vector<float> B, float &step)
+{
+	int first = 1;
+	for (unsigned int i = 0; i < A.size(); i++)
+	{
+		if (A[i] < 0 || B[i] < 0)
+			continue;					// -1 is minus infinity, it does not take part in the schedule
+		if (first == 1)
+		{
+			step = A[i] - B[i];
+			first = 0;
+		}
+		else if (fabs((A[i] - B[i]) - step) > TRANSITION_EPS)
+			return 0;
+	}
+	return (first == 0);
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Plans the transition from StartVec (the last vector of the old gait that is kept) to the gait used at *speed*
+GaitTransition PlanTransition(int speed, vector<float> StartVec, double time)
+{
+	GaitTransition T;
+	vector<vector<float> > A0star;
+	vector<vector<float> > A1;
+	gaitParts(speed, A0star, A1);					// The parts of the new gait matrix
+	T.mpm = MPMM(A0star, A1);
+	T.periodic = 0;
+	T.speed = speed;
+	T.stride = 0;
+	T.epoch = 0;
+
+	// The first stride of the new gait: the constraints on the previous stride (A_1), the earliest time a leg can lift off, and then
+	// the precedence constraints within the stride (A_0*).
+	float earliest = time + TRANSITION_MARGIN;
+	vector<float> y = MPMVM(A1, StartVec);
+	for (unsigned int i = y.size() / 2; i < y.size(); i++)		// The second half of the vector contains the lift off times
+	{
+		if (y[i] < earliest)
+			y[i] = earliest;
+	}
+	vector<vector<float> > X(1, StartVec);				// X[k] is stride k of the iterated (earliest) schedule, X[0] = StartVec
+	X.push_back(MPMVM(A0star, y));
+
+	// Iterate the new gait until the stride after X[K] is X[K] moved by one period
+	int K = 0; float period = 0;
+	for (int k = 1; k < TRANSITION_MAX_STRIDES; k++)
+	{
+		X.push_back(MPMVM(T.mpm, X[k]));
+		if (constantStep(X[k + 1], X[k], period) == 1)
+		{
+			K = k;
+			break;
+		}
+	}
+
+	if (K == 0)							// No periodic regime found, use the iterated schedule as it is
+	{
+		T.Vecs = vector<vector<float> >(X.begin() + 1, X.end());
+		T.length = TRANSITION_MAX_STRIDES;
+		T.period = MaxVec(X.back()) - MaxVec(X[X.size() - 2]);
+		T.duration = MaxVec(X.back()) - time;
+		return T;
+	}
+
+	// Try every stride j as the start of the periodic regime, and keep the one where the regime starts the earliest
+	vector<float> V = X[K];						// A vector in the periodic regime
+	int bestj = K; float bestshift = 0; float bestend = MaxVec(V);
+	for (int j = 1; j < K; j++)
+	{
+		float shift = -1e9;
+		for (unsigned int i = 0; i < V.size(); i++)
+		{
+			if (V[i] >= 0 && X[j][i] >= 0 && X[j][i] - V[i] > shift)
+				shift = X[j][i] - V[i];			// The smallest shift that keeps every time behind the iterated stride j
+		}
+		float end = MaxVec(V) + shift;
+		if (end < bestend - TRANSITION_EPS)
+		{
+			bestj = j; bestshift = shift; bestend = end;
+		}
+	}
+
+	for (int j = 1; j < bestj; j++)
+		T.Vecs.push_back(X[j]);
+	vector<float> Aligned = V;
+	for (unsigned int i = 0; i < Aligned.size(); i++)
+	{
+		if (Aligned[i] >= 0)
+			Aligned[i] += bestshift;
+	}
+	T.Vecs.push_back(Aligned);
+	T.length = bestj;
+	T.period = period;
+	T.duration = bestend - time;
+	T.periodic = 1;
+	return T;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Checks one planned transition from StartVec at *time*: no lift off before time + TRANSITION_MARGIN, every stride at or after what the
+// new gait allows after the stride before it (StartVec for the first), and a last stride that repeats itself every period.
+// Returns the amount of violations.
+static long checkTransition(const GaitTransition &T, const vector<float> &StartVec, double time)
+{
+	long violations = 0;
+	const vector<float> *Prev = &StartVec;
+	for (unsigned int k = 0; k < T.Vecs.size(); k++)
+	{
+		vector<float> Allowed = MPMVM(T.mpm, *Prev);		// The earliest stride k the precedence constraints allow
+		for (unsigned int i = 0; i < Allowed.size(); i++)
+		{
+			if (T.Vecs[k][i] >= 0 && Allowed[i] >= 0 && T.Vecs[k][i] < Allowed[i] - TRANSITION_EPS)
+				violations++;
+		}
+		Prev = &T.Vecs[k];
+	}
+	for (unsigned int i = StartVec.size() / 2; i < StartVec.size(); i++)
+	{
+		if (T.Vecs.size() > 0 && T.Vecs[0][i] >= 0 && T.Vecs[0][i] < time + TRANSITION_MARGIN - TRANSITION_EPS)
+			violations++;						// A lift off that the legs can not be told in time
+	}
+	float step = 0;
+	if (T.periodic == 1 && (constantStep(MPMVM(T.mpm, T.Vecs.back()), T.Vecs.back(), step) == 0 || fabs(step - T.period) > TRANSITION_EPS))
+		violations++;							// The last stride is not in the periodic regime
+	return violations;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// ./Walking transitioncheck [step]: plans the transition between every two speeds that are a multiple of *step* (also to the same speed),
+// starting in the periodic regime of the old gait, checks every transition (checkTransition) and prints the transition lengths.
+long TransitionCheck(int step)
+{
+	if (step < 1)
+		step = TRANSITION_CHECK_STEP;
+	long violations = 0; long plans = 0; long aperiodic = 0;
+	long lengthTotal = 0; int lengthMax = 0; double durationTotal = 0;
+	for (int from = step; from < 100; from += step)
+	{
+		vector<vector<float> > mpm = gait(from);
+		vector<float> StartVec(12, 0);
+		for (int k = 0; k < TRANSITION_CHECK_WARMUP; k++)
+			StartVec = MPMVM(mpm, StartVec);
+		double time = MinVec(StartVec);				// Planned while the legs are in the stride of StartVec
+		for (int to = step; to < 100; to += step)
+		{
+			GaitTransition T = PlanTransition(to, StartVec, time);
+			long v = checkTransition(T, StartVec, time);
+			if (v > 0)
+				cout << " Transition " << from << " -> " << to << ": " << v << " violations \n";
+			violations += v;
+			aperiodic += (T.periodic == 0);
+			lengthTotal += T.length; durationTotal += T.duration;
+			if (T.length > lengthMax)
+				lengthMax = T.length;
+			plans++;
+		}
+	}
+	cout << "\n Transition check: " << plans << " transitions, " << violations << " violations, " << aperiodic << " without periodic regime \n";
+	cout << " Length: " << ((plans > 0) ? (double)lengthTotal / plans : 0) << " strides average, " << lengthMax << " worst, periodic after "
+	     << ((plans > 0) ? durationTotal / plans : 0) << " s average \n";
+	return violations + aperiodic;
+}
+
+//-----------------------------------------------------------------------------------------------------------------------------
+// Prints the transition metrics
+void printTransition(GaitTransition T)
+{
+	cout << "\n Gait transition: " << T.length << " strides, periodic after " << T.duration << " s, period " << T.period << " s";
+	if (T.periodic == 0)
+		cout << " (periodic regime not found)";
+	cout << "\n";
+}
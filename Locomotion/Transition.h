@@ -0,0 +1,34 @@
+#ifndef TRANSITION_H
+#define TRANSITION_H
+
+#include <vector>
+using namespace std;
+
+// HEADER FILE FOR THE GAIT TRANSITION PLANNER! See the .cpp file for the extended explanations
+
+#define TRANSITION_MAX_STRIDES 24	// Maximum amount of strides the planner looks at before giving up on finding the periodic regime
+#define TRANSITION_MARGIN 0.05		// Time (s) between planning and the first lift off of the transition, so the legs can still be told
+#define TRANSITION_EPS 0.001		// Two times that differ less than this are seen as equal
+#define TRANSITION_CHECK_STEP 5		// transitioncheck plans from and to every speed that is a multiple of this
+#define TRANSITION_CHECK_WARMUP 8	// Strides of the old gait before the transition starts (transitioncheck)
+
+struct GaitTransition
+{
+	vector<vector<float> > mpm;	// Gait matrix of the new gait
+	vector<vector<float> > Vecs;	// The intermediate touchdown/liftoff vectors, the last one is in the periodic regime of the new gait
+	int length;			// Amount of strides until the new gait is periodic (the transition length)
+	float period;			// Stride time of the new gait in its periodic regime
+	float duration;			// Time from planning until the new gait is periodic
+	int periodic;			// 1 if the periodic regime was found within TRANSITION_MAX_STRIDES
+	int speed;			// Speed the transition goes to
+	long stride;			// Schedule stride index of StartVec (set by the caller, used by GaitWorker.cpp)
+	long epoch;			// Schedule epoch StartVec was taken in (set by the caller, used by GaitWorker.cpp)
+};
+
+GaitTransition PlanTransition(int speed, vector<float> StartVec, double time); // Plans the transition from StartVec (old gait) to the gait used at *speed*
+
+void printTransition(GaitTransition T); // Prints the transition metrics
+
+long TransitionCheck(int step); // Plans a transition between every two speeds that are a multiple of *step* and checks its constraints. Returns the amount of violations
+
+#endif